@@ -0,0 +1,101 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+
+#include "wlogtext.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QTest>
+
+#include <memory>
+#include <ranges>
+#include <vector>
+
+/**
+ * @brief throughput of wLogText::append(range), with the view following the end
+ *
+ * Lines are appended in batches, as a stream delivers them, and events are
+ * processed between batches, so the coalesced repaints and the scroll to the
+ * last line are part of the cost measured.
+ */
+class wLogTextBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    static constexpr int batchLines = 10000;        //!< lines appended per call
+    static constexpr int totalLines = 2000000;      //!< lines appended by appendThroughput()
+    static constexpr double minLinesPerSecond = 1e6;
+
+    std::vector<QString> texts;                     //!< text of a batch, reused by every batch
+
+    /** @brief a shown widget, sized as a typical result view */
+    static auto newView() -> std::unique_ptr<wLogText> {
+        auto view = std::make_unique<wLogText>();
+        view->resize(1200, 800);
+        view->show();
+        return view;}
+
+    /** @brief append the batch of texts as lines, then let the widget refresh */
+    auto appendTexts(wLogText& view) const -> void {
+        view.append(texts | std::views::transform([](QString const& text) {return logTextItem{text, 0};}));
+        QCoreApplication::processEvents();}
+
+private Q_SLOTS:
+    void initTestCase() {
+        texts.reserve(batchLines);
+        for (int n = 0; n < batchLines; ++n)
+            texts.push_back(QStringLiteral("2021-03-14 15:09:26.%1 INFO worker-%2 processed request %3 in %4 ms")
+                            .arg(n % 1000, 3, 10, QLatin1Char('0')).arg(n % 16).arg(n).arg(n % 97));
+    }
+
+    void appendBatch_data() {
+        QTest::addColumn<bool>("autoScroll");
+        QTest::newRow("auto-scroll") << true;
+        QTest::newRow("scroll lock") << false;
+    }
+
+    void appendBatch() {
+        QFETCH(bool, autoScroll);
+        auto const view = newView();
+        view->setScrollLock(!autoScroll);
+        QBENCHMARK {
+            appendTexts(*view);
+        }
+    }
+
+    void appendThroughput() {
+        auto const view = newView();
+        QElapsedTimer timer;
+        timer.start();
+        for (int appended = 0; appended < totalLines; appended += batchLines)
+            appendTexts(*view);
+        double const linesPerSecond = totalLines * 1e9 / static_cast<double>(std::max<qint64>(timer.nsecsElapsed(), 1));
+        qInfo("%.0f lines/s appended with auto-scroll", linesPerSecond);
+
+        QCOMPARE(view->lineCount(), lineNumber_t{totalLines});
+        /* The last refresh may be deferred to the next frame. */
+        QTRY_COMPARE(view->verticalScrollBar()->value(), view->verticalScrollBar()->maximum());
+#ifdef QT_NO_DEBUG
+        QVERIFY2(linesPerSecond >= minLinesPerSecond, "append throughput below 1M lines/s");
+#endif
+    }
+};
+
+QTEST_MAIN(wLogTextBenchmark)
+
+#include "wlogtextbenchmark.moc"
@@ -0,0 +1,102 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "blockreader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+
+blockReader::blockReader(int fd, std::atomic<bool> const *stop) :
+    m_fd{fd}, m_stop{stop}
+{
+}
+
+auto blockReader::waitReady() const -> bool
+{
+    if (!m_stop)
+        return true;
+    for (pollfd ready{m_fd, POLLIN, 0}; !*m_stop; ) {
+        if (::poll(&ready, 1, 250) != 0)
+            return true;
+    }
+    return false;
+}
+
+auto blockReader::next() -> std::optional<std::string_view>
+{
+    if (m_eof && m_carry.empty())
+        return std::nullopt;
+
+    /* Start the next buffer with the partial line carried from the last one.
+     * The carry is in a different buffer of the ring, so they never overlap. */
+    m_current = (m_current + 1) % ringSize;
+    auto& buffer = m_ring[m_current];
+    if (buffer.size() < std::max(blockSize, m_carry.size() * 2))
+        buffer.resize(std::max(blockSize, m_carry.size() * 2));
+    size_t filled = m_carry.size();
+    std::copy(m_carry.begin(), m_carry.end(), buffer.begin());
+    size_t scanned = 0;                     // bytes known to hold no newline
+
+    while (!m_eof) {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        if (!waitReady()) {
+            m_eof = true;
+            m_carry = {};
+            return std::nullopt;
+        }
+
+        ssize_t const count = ::read(m_fd, buffer.data() + filled, buffer.size() - filled);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            m_error = errno;
+            m_carry = {};
+            return std::nullopt;
+        }
+        if (count == 0) {
+            m_eof = true;
+            break;
+        }
+        filled += static_cast<size_t>(count);
+
+        /* A pipe delivers a little at a time, so keep reading until the buffer
+         * is mostly full, unless no more input is ready yet. */
+        if (filled < buffer.size() / 2) {
+            pollfd ready{m_fd, POLLIN, 0};
+            if (::poll(&ready, 1, 0) != 0)
+                continue;
+        }
+        auto const *const begin = buffer.data();
+        auto const *newline = static_cast<char const*>(memrchr(begin + scanned, '\n', filled - scanned));
+        if (newline) {
+            size_t const end = static_cast<size_t>(newline - begin) + 1;
+            m_carry = {begin + end, filled - end};
+            return std::string_view{begin, end};
+        }
+        scanned = filled;
+    }
+
+    /* End of input: everything left is whole lines, the last possibly without a newline. */
+    m_carry = {};
+    if (filled == 0)
+        return std::nullopt;
+    return std::string_view{buffer.data(), filled};
+}
@@ -0,0 +1,78 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file blockreader.h Reading a file descriptor in large blocks of whole lines */
+
+#ifndef BLOCKREADER_H
+#define BLOCKREADER_H
+
+#include <array>
+#include <atomic>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief reads a file descriptor in large blocks of whole lines
+ *
+ * Reads with read(2) into a ring of buffers. Each block returned by next()
+ * ends at a newline; the partial line after the last newline of a read is
+ * carried to the start of the next buffer. Reads continue until a buffer is
+ * half full, or no more input is ready. At end of input the remaining lines
+ * are returned, the last possibly without a newline.
+ *
+ * A block stays valid until next() has been called ringSize - 1 more times,
+ * so one block may be processed while the next is being read.
+ */
+class blockReader {
+public:
+    /** Number of buffers in the ring */
+    static constexpr size_t ringSize = 3;
+
+    /** Initial size of each buffer; a buffer grows to hold a longer line */
+    static constexpr size_t blockSize = size_t{4} << 20;
+
+    /**
+     * @brief constructor
+     * @param fd file descriptor to read; not closed by the reader
+     * @param stop if not null, a flag which ends input when set, checked while
+     * waiting for input, so a reader on another thread can be stopped
+     */
+    explicit blockReader(int fd, std::atomic<bool> const *stop = nullptr);
+
+    /**
+     * @brief read the next block of lines
+     * @return block of whole lines, or nullopt at end of input or on error
+     */
+    auto next() -> std::optional<std::string_view>;
+
+    /** @return errno of a failed read, or 0 */
+    auto error() const {return m_error;}
+
+private:
+    int m_fd;
+    std::atomic<bool> const *m_stop;
+    int m_error = 0;
+    bool m_eof = false;
+    std::array<std::vector<char>, ringSize> m_ring;
+    size_t m_current = 0;                   //!< ring index of the buffer last returned
+    std::string_view m_carry;               //!< partial line following the last block
+
+    /** @return @c true when input is ready, or @c false if stopped while waiting */
+    auto waitReady() const -> bool;
+};
+
+#endif // BLOCKREADER_H
@@ -0,0 +1,33 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "filterdelegate.h"
+
+#include <QLineEdit>
+
+auto filterItemDelegate::createEditor(QWidget *parent, QStyleOptionViewItem const& option, QModelIndex const& index) const
+    -> QWidget*
+{
+    QWidget *editor = QStyledItemDelegate::createEditor(parent, option, index);
+    if (auto lineEdit = qobject_cast<QLineEdit*>(editor)) {
+        /* createEditor() is const, but signalling does not change the delegate. */
+        auto self = const_cast<filterItemDelegate*>(this);
+        int const row = index.row();
+        connect(lineEdit, &QLineEdit::textEdited, self, [self,row](QString const& text) {
+            Q_EMIT self->textEdited(row, text);});
+    }
+    return editor;
+}
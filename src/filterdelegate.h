@@ -0,0 +1,48 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file filterdelegate.h Editing delegate of the filters table expression column */
+
+#ifndef FILTERDELEGATE_H
+#define FILTERDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+/**
+ * @brief delegate of the expression column
+ *
+ * Edits as the standard delegate, and also signals each change of the text
+ * while editing, before the edit is committed to the item.
+ */
+class filterItemDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    auto createEditor(QWidget *parent, QStyleOptionViewItem const& option, QModelIndex const& index) const
+        -> QWidget* override;
+
+Q_SIGNALS:
+    /**
+     * @brief the text in an editor was changed by the user
+     * @param row row being edited
+     * @param text text in the editor
+     */
+    void textEdited(int row, QString const& text);
+};
+
+#endif // FILTERDELEGATE_H
@@ -0,0 +1,267 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+
+#include "filtermodel.h"
+
+#include <QBrush>
+#include <QCoreApplication>
+#include <QIcon>
+
+#include <KLocalizedString>
+
+namespace {
+
+inline auto checkState(bool checked) -> Qt::CheckState
+{
+    return checked ? Qt::Checked : Qt::Unchecked;
+}
+
+/** @return the flag of @p entry shown in check column @p column */
+inline auto checkFlag(filterEntry& entry, int column) -> bool&
+{
+    return column == filterModel::ColEnable ? entry.enabled :
+           column == filterModel::ColExclude ? entry.exclude : entry.ignoreCase;
+}
+
+inline auto checkFlag(filterEntry const& entry, int column) -> bool
+{
+    return column == filterModel::ColEnable ? entry.enabled :
+           column == filterModel::ColExclude ? entry.exclude : entry.ignoreCase;
+}
+
+} // namespace
+
+auto filterModel::rowCount(QModelIndex const& parent) const -> int
+{
+    return parent.isValid() ? 0 : m_filters.size();
+}
+
+auto filterModel::columnCount(QModelIndex const& parent) const -> int
+{
+    return parent.isValid() ? 0 : NumCol;
+}
+
+auto filterModel::data(QModelIndex const& index, int role) const -> QVariant
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid))
+        return {};
+
+    int const row = index.row();
+    auto const& entry = m_filters[row];
+    if (index.column() != ColRegEx)
+        return role == Qt::CheckStateRole ? QVariant{checkState(checkFlag(entry, index.column()))} : QVariant{};
+
+    auto const& state = m_states[static_cast<size_t>(row)];
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return entry.re;
+    case Qt::ToolTipRole:
+        if (!state.error.isEmpty())
+            return state.error;
+        if (state.lint.isEmpty())
+            return state.toolTip;
+        return state.toolTip.isEmpty() ? state.lint : state.toolTip + QLatin1Char('\n') + state.lint;
+    case Qt::DecorationRole:
+        if (!state.error.isEmpty())
+            return QIcon::fromTheme(QStringLiteral("error"));
+        if (state.lintWarning)
+            return QIcon::fromTheme(QStringLiteral("dialog-warning"));
+        return {};
+    case Qt::ForegroundRole:
+        if (!state.error.isEmpty())
+            return QBrush{Qt::red};
+        return {};
+    default:
+        return {};
+    }
+}
+
+auto filterModel::setData(QModelIndex const& index, QVariant const& value, int role) -> bool
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid))
+        return false;
+
+    int const row = index.row();
+    int const column = index.column();
+    auto& entry = m_filters[row];
+    if (column == ColRegEx) {
+        if (role != Qt::EditRole)
+            return false;
+        /* As a table item, an unchanged text is not an edit. */
+        if (QString const text{value.toString()}; text != entry.re)
+            entry.re = text;
+        else
+            return true;
+    } else {
+        if (role != Qt::CheckStateRole)
+            return false;
+        bool const checked = static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked;
+        if (bool& flag = checkFlag(entry, column); flag != checked)
+            flag = checked;
+        else
+            return true;
+    }
+    Q_EMIT dataChanged(index, index, column == ColRegEx ? QVector<int>{Qt::DisplayRole, Qt::EditRole}
+                                                        : QVector<int>{Qt::CheckStateRole});
+    Q_EMIT entryEdited(row, column);
+    return true;
+}
+
+auto filterModel::flags(QModelIndex const& index) const -> Qt::ItemFlags
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid))
+        return Qt::NoItemFlags;
+    Qt::ItemFlags const flags{Qt::ItemIsSelectable | Qt::ItemIsEnabled};
+    return index.column() == ColRegEx ? flags | Qt::ItemIsEditable : flags | Qt::ItemIsUserCheckable;
+}
+
+auto filterModel::headerData(int section, Qt::Orientation orientation, int role) const -> QVariant
+{
+    if (orientation != Qt::Horizontal || section < 0 || section >= NumCol)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (section) {
+        case ColEnable:
+            return QCoreApplication::translate("mainwidget", "En", nullptr);
+        case ColExclude:
+            return QCoreApplication::translate("mainwidget", "Ex", nullptr);
+        case ColCaseIgnore:
+            return QCoreApplication::translate("mainwidget", "IC", nullptr);
+        default:
+            return QCoreApplication::translate("mainwidget", "Regular Expression", nullptr);
+        }
+    case Qt::ToolTipRole:
+        switch (section) {
+        case ColEnable:
+            return i18n("Expression entry is enabled when checked");
+        case ColExclude:
+            return i18n("Exclude matching lines");
+        case ColCaseIgnore:
+            return i18n("Use case insensitive matching");
+        default:
+            return i18n("Regular expression string");
+        }
+    case Qt::WhatsThisRole:
+        switch (section) {
+        case ColEnable:
+            return i18n("When checked, this filter is enabled, and will be applied "
+            "to the result. When unchecked, this entry is not used.");
+        case ColExclude:
+            return i18n("When not checked, lines matching the regular expression "
+            "will be included in the result. When checked, those which "
+            "do not match will be included.");
+        case ColCaseIgnore:
+            return i18n("When checked, the regular expression match will ignore text case.");
+        default:
+            return {};
+        }
+    case Qt::TextAlignmentRole:
+        return section == ColRegEx ? QVariant{} : QVariant{static_cast<int>(Qt::AlignLeft)};
+    default:
+        return {};
+    }
+}
+
+auto filterModel::insertRows(int row, int count, QModelIndex const& parent) -> bool
+{
+    if (parent.isValid() || row < 0 || row > m_filters.size() || count <= 0)
+        return false;
+    filterEntry empty;
+    empty.enabled = true;
+    QList<filterEntry> rows;
+    rows.reserve(count);
+    for (int n = 0; n < count; ++n)
+        rows.push_back(empty);
+    insertFilters(row, rows);
+    return true;
+}
+
+auto filterModel::removeRows(int row, int count, QModelIndex const& parent) -> bool
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > m_filters.size())
+        return false;
+    beginRemoveRows(QModelIndex{}, row, row + count - 1);
+    m_filters.erase(m_filters.begin() + row, m_filters.begin() + row + count);
+    m_states.erase(m_states.begin() + row, m_states.begin() + row + count);
+    endRemoveRows();
+    return true;
+}
+
+void filterModel::setEntry(int row, filterEntry const& newEntry)
+{
+    m_filters[row] = newEntry;
+    m_states[static_cast<size_t>(row)] = rowState{};
+    Q_EMIT dataChanged(index(row, 0), index(row, NumCol - 1));
+}
+
+void filterModel::setFilters(QList<filterEntry> const& newFilters)
+{
+    beginResetModel();
+    m_filters = newFilters;
+    m_states.assign(static_cast<size_t>(m_filters.size()), rowState{});
+    endResetModel();
+}
+
+void filterModel::insertFilters(int row, QList<filterEntry> const& newFilters)
+{
+    if (newFilters.isEmpty())
+        return;
+    beginInsertRows(QModelIndex{}, row, row + newFilters.size() - 1);
+    QList<filterEntry> filters{m_filters.mid(0, row)};
+    filters.reserve(m_filters.size() + newFilters.size());
+    filters.append(newFilters);
+    filters.append(m_filters.mid(row));
+    m_filters = std::move(filters);
+    m_states.insert(m_states.begin() + row, static_cast<size_t>(newFilters.size()), rowState{});
+    endInsertRows();
+}
+
+void filterModel::setToolTip(int row, QString const& toolTip)
+{
+    if (auto& state = m_states[static_cast<size_t>(row)]; state.toolTip != toolTip) {
+        state.toolTip = toolTip;
+        stateChanged(row, {Qt::ToolTipRole});
+    }
+}
+
+void filterModel::setLint(int row, QString const& findings, bool warning)
+{
+    auto& state = m_states[static_cast<size_t>(row)];
+    state.lint = findings;
+    state.lintWarning = warning;
+    stateChanged(row, {Qt::ToolTipRole, Qt::DecorationRole});
+}
+
+void filterModel::setError(int row, QString const& error)
+{
+    auto& state = m_states[static_cast<size_t>(row)];
+    state.error = error;
+    if (!error.isEmpty()) {
+        state.lint.clear();
+        state.lintWarning = false;
+    }
+    stateChanged(row, {Qt::ToolTipRole, Qt::DecorationRole, Qt::ForegroundRole});
+}
+
+void filterModel::stateChanged(int row, QVector<int> const& roles)
+{
+    auto const cell = index(row, ColRegEx);
+    Q_EMIT dataChanged(cell, cell, roles);
+}
@@ -0,0 +1,160 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+
+/** @file filtermodel.h Filter entries, and the model of the filters table */
+
+#ifndef FILTERMODEL_H
+#define FILTERMODEL_H
+
+#include <QAbstractTableModel>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <vector>
+
+struct filterEntry {
+    bool enabled = false;
+    bool exclude = false;
+    bool ignoreCase = false;
+    QString re;
+
+    auto operator==(filterEntry const&) const -> bool = default;
+
+    /** @return true if the entry is enabled and has an expression */
+    auto isActive() const -> bool {return enabled && !re.isEmpty();}
+
+    QJsonObject toJson() const;
+    static auto fromJson(const QJsonObject& jentry) -> filterEntry;
+};
+
+struct filterData {
+    bool valid = false;
+    QString dialect;
+    QList<filterEntry> filters;
+};
+
+/**
+ * @brief model of the filters table
+ *
+ * Holds the filters as a plain list of filterEntry, rather than as table
+ * items, so a run reads its rows without going through the view, and
+ * filters() is a snapshot: an implicitly shared copy, which later edits of
+ * the table do not change. Loading inserts all rows at once.
+ *
+ * Each row also has display state which is not part of the filter: the tool
+ * tip of the last run, lint findings, and the error of an invalid
+ * expression. Setting these, or the entries, from code emits dataChanged()
+ * but not entryEdited(), which is kept for edits made in the view.
+ */
+class filterModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    /** Constants for column addressing */
+    enum {ColEnable = 0, ColExclude, ColCaseIgnore, ColRegEx, NumCol};
+
+    using QAbstractTableModel::QAbstractTableModel;
+
+    auto rowCount(QModelIndex const& parent = QModelIndex{}) const -> int override;
+    auto columnCount(QModelIndex const& parent = QModelIndex{}) const -> int override;
+    auto data(QModelIndex const& index, int role = Qt::DisplayRole) const -> QVariant override;
+    auto setData(QModelIndex const& index, QVariant const& value, int role = Qt::EditRole) -> bool override;
+    auto flags(QModelIndex const& index) const -> Qt::ItemFlags override;
+    auto headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const -> QVariant override;
+
+    /** Inserts empty rows: enabled, with no expression */
+    auto insertRows(int row, int count, QModelIndex const& parent = QModelIndex{}) -> bool override;
+    auto removeRows(int row, int count, QModelIndex const& parent = QModelIndex{}) -> bool override;
+
+    /** @return the filters, a snapshot unaffected by later edits */
+    auto filters() const -> QList<filterEntry> const& {return m_filters;}
+
+    /** @return the filter of row @p row */
+    auto entry(int row) const -> filterEntry const& {return m_filters[row];}
+
+    /**
+     * @brief replace the filter of a row, clearing its display state
+     * @param row row to set
+     * @param newEntry filter
+     */
+    auto setEntry(int row, filterEntry const& newEntry) -> void;
+
+    /**
+     * @brief replace all rows, as a model reset
+     * @param newFilters filters
+     */
+    auto setFilters(QList<filterEntry> const& newFilters) -> void;
+
+    /**
+     * @brief insert rows of filters, in a single insertion
+     * @param row row before which to insert
+     * @param newFilters filters to insert
+     */
+    auto insertFilters(int row, QList<filterEntry> const& newFilters) -> void;
+
+    /**
+     * @brief set the tool tip of a row, shown ahead of its lint findings
+     * @param row filter row
+     * @param toolTip tool tip, e.g. the line counts of the last run
+     */
+    auto setToolTip(int row, QString const& toolTip) -> void;
+
+    /**
+     * @brief set the lint findings of a row
+     * @param row filter row
+     * @param findings findings, one per line; empty for none
+     * @param warning mark the row with a warning icon
+     */
+    auto setLint(int row, QString const& findings, bool warning) -> void;
+
+    /**
+     * @brief mark a row's expression as invalid
+     *
+     * The expression is shown in red, with an error icon, and @p error as its
+     * tool tip, in place of the lint findings.
+     *
+     * @param row filter row
+     * @param error error of the expression; empty to clear
+     */
+    auto setError(int row, QString const& error) -> void;
+
+Q_SIGNALS:
+    /**
+     * @brief a cell was changed in the view
+     * @param row row changed
+     * @param column column changed
+     */
+    void entryEdited(int row, int column);
+
+private:
+    /** Display state of a row */
+    struct rowState {
+        QString toolTip;
+        QString lint;
+        QString error;
+        bool lintWarning = false;
+    };
+
+    QList<filterEntry> m_filters;
+    std::vector<rowState> m_states;     //!< state of each row of m_filters
+
+    /** @brief signal a change of display state of the expression of row @p row */
+    auto stateChanged(int row, QVector<int> const& roles) -> void;
+};
+
+#endif // FILTERMODEL_H
@@ -15,7 +15,10 @@
  **/
 
 #include "filters.h"
+#include "blockreader.h"
+#include "linesplitter.h"
 #include "mainwidget.h"
+#include "utf8regex.h"
 
 #include <QDebug>
 #include <QJsonArray>
@@ -30,9 +33,16 @@
 #include <KLocalizedString>
 #include <KSharedConfig>
 
+#include <cstring>
 #include <exception>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#include <unistd.h>
 
 QString const generalConfigName = QStringLiteral("general");
 QString const filtersConfigName = QStringLiteral("filters");
@@ -180,73 +190,87 @@ static auto batchLoadFilters(const commandLineOptions& opts) -> filterData
 }
 
 
-static itemsList batchLoadSubjectFile(const commandLineOptions& opts)
-{
-    QFile source{opts.subjectFile};
-    if (source.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        itemsList lines;
-        int srcLine = 0;
-        for(QTextStream stream(&source); !stream.atEnd(); )
-          lines.emplace_back(++srcLine, stream.readLine());
-        lines.shrink_to_fit();
-        return lines;
-    }
-    throw subjectLoadException(opts.subjectFile);
-}
+/** A batch filter expression, ready to match */
+struct batchFilter {
+    utf8RegularExpression re;
+    bool exclude = false;
+};
 
-static itemsList readStdIn()
+static auto batchCompileFilters(const filterData& filters) -> std::vector<batchFilter>
 {
-    itemsList lines;
-    for(int srcLine = 0; std::cin;) {
-        std::string line;
-        std::getline(std::cin, line);
-        lines.emplace_back(++srcLine, QString::fromStdString(line));
-    }
-    return lines;
-}
-
+    if (filters.dialect != QStringLiteral("QRegularExpression"))
+        throw dialectTypeException(filters.dialect);
 
-static stepList batchApplyQRegularExpressions(const filterData& filters, stepList items)
-{
+    std::vector<batchFilter> result;
     for (const filterEntry& entry : filters.filters) {
         if (entry.enabled) {
-            bool const exclude{entry.exclude};
-            QRegularExpression::PatternOptions pOpts = QRegularExpression::NoPatternOption;
-            if (entry.ignoreCase)
-                pOpts |= QRegularExpression::CaseInsensitiveOption;
-            QRegularExpression re(entry.re, pOpts);
+            utf8RegularExpression re{entry.re, entry.ignoreCase};
             if (!re.isValid())
                 throw badRegexException(entry.re);
-            re.optimize();
-            items = QtConcurrent::blockingFiltered(items,
-                    [&re, exclude](const textItem* item) {return re.match(item->text).hasMatch() ^ exclude;});
-            if (items.empty())
-                break;
+            result.push_back({std::move(re), entry.exclude});
         }
     }
-    return items;
+    return result;
 }
 
-static stepList batchApplyFilters(const filterData& filters, const stepList& lines)
+/**
+ * @brief filter a block of lines
+ *
+ * Lines are matched as UTF-8, in place in the block, and the matching lines
+ * appended to @p out as they are; no line is converted.
+ *
+ * @param filters filters to apply, in order
+ * @param block UTF-8 block of whole lines
+ * @param out output to append the matching lines to
+ */
+static auto batchFilterBlock(const std::vector<batchFilter>& filters, std::string_view block, std::string& out) -> void
 {
-    if (filters.dialect == QStringLiteral("QRegularExpression"))
-        return batchApplyQRegularExpressions(filters, stepList{lines});
-    throw dialectTypeException(filters.dialect);
+    auto const split = splitLines(block);
+    QVector<std::string_view> lines(split.cbegin(), split.cend());
+    for (auto const& [re, exclude] : filters) {
+        lines = QtConcurrent::blockingFiltered(lines, [&re = re, exclude = exclude](std::string_view line) {
+            return re.match(line) ^ exclude;});
+        if (lines.empty())
+            return;
+    }
+
+    for (std::string_view const line : qAsConst(lines)) {
+        out.append(line);
+        out.push_back('\n');
+    }
 }
 
 auto doBatch(const commandLineOptions& opts) -> int
 {
     try {
         filterData const filters{batchLoadFilters(opts)};
-        itemsList sourceItems = opts.stdin ? readStdIn() : batchLoadSubjectFile(opts);
-        stepList steps;
-        steps.reserve(sourceItems.size());
-        std::for_each(sourceItems.begin(), sourceItems.end(),
-                      [&steps](auto& item) mutable {steps.push_back(&item);});
-
-        steps = batchApplyFilters(filters, steps);
-        for (auto const& item : qAsConst(sourceItems))
-            std::cout << item.text.toUtf8().constData() << '\n';
+        std::vector<batchFilter> const compiled{batchCompileFilters(filters)};
+
+        QFile source{opts.subjectFile};
+        int fd = STDIN_FILENO;
+        if (!opts.stdin) {
+            if (!source.open(QIODevice::ReadOnly))
+                throw subjectLoadException(opts.subjectFile);
+            fd = source.handle();
+        }
+
+        /* Blocks are streamed through the filters: the next block is read
+         * while this one is filtered, and the results written as they come. */
+        std::ios_base::sync_with_stdio(false);
+        blockReader reader{fd};
+        auto const readBlock = [&reader]() {return reader.next();};
+        std::string out;
+        QFuture<std::optional<std::string_view>> pending{QtConcurrent::run(readBlock)};
+        while (std::optional<std::string_view> const block{pending.result()}) {
+            pending = QtConcurrent::run(readBlock);
+            batchFilterBlock(compiled, *block, out);
+            std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
+        }
+        std::cout.flush();
+        if (reader.error() != 0)
+            throw subjectLoadException(opts.stdin ? QStringLiteral("stdin: %1").arg(QString::fromLocal8Bit(std::strerror(reader.error())))
+                                                  : opts.subjectFile);
     }
     catch (std::exception const &except) {
         std::cerr << except.what() << std::endl;
@@ -0,0 +1,96 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file hashing.h Fast non-cryptographic 64-bit hashing of line text */
+
+#ifndef HASHING_H
+#define HASHING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+__extension__ using hashUint128_t = unsigned __int128;
+
+static constexpr uint64_t hashSecret0 = 0xa0761d6478bd642full;
+static constexpr uint64_t hashSecret1 = 0xe7037ed1a0b428dbull;
+static constexpr uint64_t hashSecret2 = 0x8ebc6af09c88c6e3ull;
+
+/**
+ * @brief 64x64 -> 128 bit multiply, folded back to 64 bits
+ */
+inline auto hashMum(uint64_t a, uint64_t b) noexcept -> uint64_t
+{
+    hashUint128_t const r = static_cast<hashUint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline auto hashLoad64(unsigned char const *p) noexcept -> uint64_t
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline auto hashLoadPartial(unsigned char const *p, size_t n) noexcept -> uint64_t
+{
+    uint64_t v = 0;
+    std::memcpy(&v, p, n);
+    return v;
+}
+
+/**
+ * @brief hash a byte range to 64 bits
+ *
+ * Hashes 16 bytes per step with a multiply-fold mix, so the hash runs at close
+ * to memory bandwidth for typical log line lengths. This is not a
+ * cryptographic hash; callers which need exact equality must still compare the
+ * text when hashes are equal.
+ *
+ * @param data start of the data to hash
+ * @param size number of bytes to hash
+ * @param seed optional seed, to chain hashes
+ * @return 64-bit hash of the data
+ */
+inline auto hash64(void const *data, size_t size, uint64_t seed = 0) noexcept -> uint64_t
+{
+    auto p = static_cast<unsigned char const *>(data);
+    uint64_t h = seed ^ hashMum(size ^ hashSecret0, hashSecret1);
+    for (; size >= 16; p += 16, size -= 16)
+        h = hashMum(hashLoad64(p) ^ hashSecret1, hashLoad64(p + 8) ^ h);
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (size > 8) {
+        a = hashLoad64(p);
+        b = hashLoadPartial(p + 8, size - 8);
+    } else
+        a = hashLoadPartial(p, size);
+    return hashMum(hashMum(a ^ hashSecret1, b ^ h) ^ hashSecret2, size ^ hashSecret0);
+}
+
+/**
+ * @brief combine a value into a running hash
+ * @param h running hash value
+ * @param v value to fold into @p h
+ * @return new running hash
+ */
+inline auto hashCombine(uint64_t h, uint64_t v) noexcept -> uint64_t
+{
+    return hashMum(h ^ hashSecret2, v ^ hashSecret1);
+}
+
+#endif // HASHING_H
@@ -0,0 +1,55 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "linesplitter.h"
+#include "parallel.h"
+
+#include <cstring>
+
+auto splitLines(std::string_view text) -> std::vector<std::string_view>
+{
+    size_t const size = text.size();
+    auto ranges = splitRanges(size, size_t{1} << 20);
+
+    // Index of the first newline at or after from, or size if none:
+    auto const findNewline = [text,size](size_t from) -> size_t {
+        auto const *const p = static_cast<char const*>(std::memchr(text.data() + from, '\n', size - from));
+        return p ? static_cast<size_t>(p - text.data()) : size;};
+
+    /* Each chunk takes the lines which start within it; the last of those may
+     * end in a following chunk. */
+    std::vector<std::vector<std::string_view>> chunkLines(ranges.size());
+    QtConcurrent::blockingMap(ranges, [&](indexRange const& r) {
+        auto& lines = chunkLines[static_cast<size_t>(&r - ranges.data())];
+        size_t start = r.first == 0 ? 0 : std::min(findNewline(r.first - 1) + 1, size);
+        while (start < r.second) {
+            size_t const newline = findNewline(start);
+            size_t end = newline;
+            if (end < size && end > start && text[end - 1] == '\r')
+                --end;
+            lines.push_back(text.substr(start, end - start));
+            start = newline + 1;
+        }});
+
+    size_t total = 0;
+    for (auto const& lines : chunkLines)
+        total += lines.size();
+    std::vector<std::string_view> result;
+    result.reserve(total);
+    for (auto const& lines : chunkLines)
+        result.insert(result.end(), lines.begin(), lines.end());
+    return result;
+}
@@ -0,0 +1,39 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file linesplitter.h Splitting a text buffer into lines in place */
+
+#ifndef LINESPLITTER_H
+#define LINESPLITTER_H
+
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief split UTF-8 text into lines, in parallel chunks
+ *
+ * Lines end at "\n" or "\r\n"; the terminators are not included. A final line
+ * without a terminator is a line, and a final terminator does not start an
+ * empty line, as with QTextStream::readLine(). No UTF-8 sequence contains a
+ * newline byte, so the text is split as bytes, with memchr(). The text is not
+ * copied: each view refers into @p text, which must outlive the views.
+ *
+ * @param text text to split
+ * @return view of each line
+ */
+auto splitLines(std::string_view text) -> std::vector<std::string_view>;
+
+#endif // LINESPLITTER_H
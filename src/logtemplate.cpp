@@ -0,0 +1,110 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "logtemplate.h"
+
+#include <QRegularExpression>
+
+#include <array>
+
+namespace {
+
+/** Character class bits */
+enum : uint8_t {
+    clsWord     = 0x01,         //!< part of a word
+    clsDigit    = 0x02,         //!< decimal digit
+    clsVariable = 0x04,         //!< may appear in a variable word
+};
+
+constexpr auto makeClassTable()
+{
+    std::array<uint8_t, 128> table{};
+    for (char16_t c = u'0'; c <= u'9'; ++c)
+        table[c] = clsWord | clsDigit | clsVariable;
+    for (char16_t c = u'a'; c <= u'z'; ++c)
+        table[c] = clsWord;
+    for (char16_t c = u'A'; c <= u'Z'; ++c)
+        table[c] = clsWord;
+    for (char16_t c = u'a'; c <= u'f'; ++c)
+        table[c] |= clsVariable;
+    for (char16_t c = u'A'; c <= u'F'; ++c)
+        table[c] |= clsVariable;
+    for (char16_t c : {u'x', u'X', u'.', u':', u'-'})
+        table[c] |= clsWord | clsVariable;
+    table[u'_'] = clsWord;
+    return table;
+}
+
+constexpr auto classTable = makeClassTable();
+
+inline auto charClass(QChar c) -> uint8_t
+{
+    char16_t const u = c.unicode();
+    if (u < classTable.size()) [[likely]]
+        return classTable[u];
+    return c.isLetterOrNumber() ? clsWord : 0;
+}
+
+/** Regular expression for a variable word; the same character set as clsVariable,
+ * with at least one digit. */
+QString const variableRegEx{QStringLiteral("[-0-9A-Fa-fxX.:]*[0-9][-0-9A-Fa-fxX.:]*")};
+
+} // namespace
+
+auto lineTemplate(QStringView text, QString& out) -> void
+{
+    out.resize(0);
+    out.reserve(static_cast<int>(text.size()));
+    qsizetype const size = text.size();
+    for (qsizetype i = 0; i < size;) {
+        if (!(charClass(text[i]) & clsWord)) {
+            out.append(text[i++]);
+            continue;
+        }
+
+        /* Accumulate the class bits of the whole word; it is variable if every
+         * character may be in a variable word, and any is a digit. */
+        qsizetype const start = i;
+        uint8_t allOf = 0xff;
+        uint8_t anyOf = 0;
+        for (uint8_t cls; i < size && ((cls = charClass(text[i])) & clsWord); ++i) {
+            allOf &= cls;
+            anyOf |= cls;
+        }
+        if ((allOf & clsVariable) && (anyOf & clsDigit))
+            out.append(templateVariable);
+        else
+            out.append(text.data() + start, static_cast<int>(i - start));
+    }
+}
+
+auto displayTemplate(QString const& templ) -> QString
+{
+    return QString{templ}.replace(templateVariable, QStringLiteral("<*>"));
+}
+
+auto templateRegularExpression(QString const& templ) -> QString
+{
+    QString re{QStringLiteral("^")};
+    auto const parts = templ.splitRef(templateVariable);
+    for (int n = 0; n < parts.size(); ++n) {
+        if (n != 0)
+            re.append(variableRegEx);
+        re.append(QRegularExpression::escape(parts[n].toString()));
+    }
+    re.append(QLatin1Char('$'));
+    return re;
+}
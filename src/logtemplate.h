@@ -0,0 +1,135 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file logtemplate.h Grouping of log lines by template, with variable tokens masked */
+
+#ifndef LOGTEMPLATE_H
+#define LOGTEMPLATE_H
+
+#include <QString>
+#include <QStringView>
+#include <QtConcurrent>
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "hashing.h"
+#include "parallel.h"
+
+/** Character marking a masked variable token within a template. It is from the
+ * Unicode private use area, so it will not be confused with text of the line. */
+inline constexpr QChar templateVariable{0xE000};
+
+/**
+ * @brief compute the template of a line
+ *
+ * The line is split into words, being runs of letters, digits and ".:-_". Words
+ * which contain a digit, and are otherwise made up only of hexadecimal digits,
+ * "x" and ".:-" are variable: numbers, hex IDs, UUIDs, IP addresses, dates and
+ * times. Each variable word is replaced with a single templateVariable.
+ *
+ * Classification is table driven over the ASCII range, without per character
+ * branching on the character class.
+ *
+ * @param text line to examine
+ * @param out receives the template; its capacity is reused between calls
+ */
+auto lineTemplate(QStringView text, QString& out) -> void;
+
+/**
+ * @brief template in displayable form
+ * @param templ template from lineTemplate()
+ * @return template with each variable token shown as "<*>"
+ */
+auto displayTemplate(QString const& templ) -> QString;
+
+/**
+ * @brief regular expression matching lines of a template
+ * @param templ template from lineTemplate()
+ * @return anchored regular expression, matching exactly the lines with @p templ
+ */
+auto templateRegularExpression(QString const& templ) -> QString;
+
+/** A group of lines sharing a template */
+struct logTemplate {
+    QString text;               //!< template, with variable tokens as templateVariable
+    uint64_t hash = 0;          //!< hash of text
+    size_t count = 0;           //!< number of lines with this template
+    size_t firstIndex = 0;      //!< index of the first line with this template; the sample
+};
+
+/**
+ * @brief group lines by template
+ *
+ * Lines are processed in parallel chunks, each building its own groups, which
+ * are then merged in chunk order, so the groups are in the order of the first
+ * line of each.
+ *
+ * @param count number of lines
+ * @param textOf function returning the text of line n, as a QStringView or a QString
+ * @return groups of lines
+ */
+template <typename TextOf>
+auto clusterTemplates(size_t count, TextOf&& textOf) -> std::vector<logTemplate>
+{
+    struct chunk {
+        indexRange range;
+        std::vector<logTemplate> groups;
+        std::unordered_multimap<uint64_t, size_t> index;
+    };
+    auto const findGroup = [](chunk const& c, uint64_t hash, QString const& text) -> std::optional<size_t> {
+        auto [it, end] = c.index.equal_range(hash);
+        for (; it != end; ++it) {
+            if (c.groups[it->second].text == text)
+                return it->second;
+        }
+        return std::nullopt;};
+
+    std::vector<chunk> chunks;
+    for (auto const& range : splitRanges(count))
+        chunks.push_back(chunk{range, {}, {}});
+    if (chunks.empty())
+        return {};
+
+    QtConcurrent::blockingMap(chunks, [&textOf,&findGroup](chunk& c) {
+        QString templ;
+        for (size_t i = c.range.first; i < c.range.second; ++i) {
+            lineTemplate(textOf(i), templ);
+            uint64_t const hash = hash64(templ.constData(), static_cast<size_t>(templ.size()) * sizeof(QChar));
+            if (auto const group = findGroup(c, hash, templ); group)
+                ++c.groups[*group].count;
+            else {
+                c.index.emplace(hash, c.groups.size());
+                c.groups.push_back(logTemplate{templ, hash, 1, i});
+            }
+        }});
+
+    chunk merged{std::move(chunks.front())};
+    for (auto it = chunks.begin() + 1; it != chunks.end(); ++it) {
+        for (auto& group : it->groups) {
+            if (auto const found = findGroup(merged, group.hash, group.text); found)
+                merged.groups[*found].count += group.count;
+            else {
+                merged.index.emplace(group.hash, merged.groups.size());
+                merged.groups.push_back(std::move(group));
+            }
+        }
+    }
+    return std::move(merged.groups);
+}
+
+#endif // LOGTEMPLATE_H
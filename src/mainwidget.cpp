@@ -1,8 +1,21 @@
 #include "mainwidget.h"
+#include "filterdelegate.h"
 #include "filters.h"
+#include "hashing.h"
+#include "linesplitter.h"
+#include "streamreader.h"
+#include "parallel.h"
+#include "regexlint.h"
+#include "sampling.h"
+#include "scheduler.h"
+#include "slowlinesdialog.h"
+#include "templatesdialog.h"
+#include "timehistogram.h"
+#include "utf8regex.h"
 
 #include <QCheckBox>
 #include <QClipboard>
+#include <QComboBox>
 #include <QtConcurrent>
 #include <QDebug>
 #include <QFileDialog>
@@ -18,10 +31,15 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QFutureWatcher>
 #include <QPair>
 #include <QPushButton>
 #include <QStatusBar>
-#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QToolButton>
+#include <QToolTip>
+#include <QUndoStack>
 
 #include <KAboutData>
 #include <KActionCollection>
@@ -34,15 +52,72 @@
 #include <KStandardAction>
 #include <KXmlGuiWindow>
 
+#include <chrono>
 #include <ranges>
+#include <unordered_map>
 #include <vector>
+
+#include <sys/stat.h>
 namespace rng=std::ranges;
 
+namespace {
+
+/** Estimated nanoseconds to filter a line, for the cost of rebuilding a step
+ * which was taken from a cache rather than timed */
+constexpr qint64 nominalLineNanos = 200;
+
+/** Undoable edit of the filters table, as the rows before and after */
+class filtersEditCommand : public QUndoCommand {
+public:
+    using applyFn = std::function<void(QList<filterEntry> const&)>;
+
+    filtersEditCommand(QList<filterEntry> before, QList<filterEntry> after, applyFn apply) :
+        QUndoCommand{i18n("Filter Edit")}, m_before{std::move(before)}, m_after{std::move(after)},
+        m_apply{std::move(apply)} {}
+
+    /* The edit has been made when the command is pushed, so the first redo is skipped. */
+    void redo() override {
+        if (!m_done)
+            m_done = true;
+        else
+            m_apply(m_after);
+    }
+    void undo() override {m_apply(m_before);}
+
+private:
+    QList<filterEntry> m_before;
+    QList<filterEntry> m_after;
+    applyFn m_apply;
+    bool m_done = false;
+};
+
+/** @return length of @p text decoded from UTF-8, as textItem::decoded() gives it */
+auto decodedLength(std::string_view text) -> int
+{
+    /* ASCII, the usual case, is counted without decoding. */
+    if (std::all_of(text.cbegin(), text.cend(), [](char c) {return static_cast<unsigned char>(c) < 0x80;}))
+        return static_cast<int>(text.size());
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size())).size();
+}
+
+} // namespace
+
 mainWidget::mainWidget(KXmlGuiWindow *main, QWidget *parent) :
     QWidget{parent}, mainWindow{main}
 {
     setupUi();
     appendEmptyRow();
+    recordedFilters = filterRows();
+}
+
+mainWidget::~mainWidget()
+{
+    cancelRun(true);
+    clearPreview();
+    clearLint();
+    saveSubjectState();
+    stopStream();
+    workScheduler::instance().pool(workLane::background)->waitForDone();
 }
 
 
@@ -61,42 +136,24 @@ void mainWidget::setupUi()
     QVBoxLayout *verticalLayout{new QVBoxLayout(groupBox_2)};
     verticalLayout->setObjectName(QString::fromUtf8("verticalLayout"));
 
-    filtersTable = new QTableWidget(groupBox_2);
+    filtersModel = new filterModel(this);
+    filtersTable = new QTableView(groupBox_2);
     filtersTable->setObjectName(QString::fromUtf8("filtersTable"));
     filtersTable->setMouseTracking(true);
-    filtersTable->setColumnCount(NumCol);
+    filtersTable->setModel(filtersModel);
     filtersTable->setContextMenuPolicy(Qt::CustomContextMenu);
     filtersTable->horizontalHeader()->setStretchLastSection(true);
     filtersTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 
-    auto item{new QTableWidgetItem};
-    item->setTextAlignment(Qt::AlignLeft);
-    item->setText(QCoreApplication::translate("mainwidget", "En", nullptr));
-    item->setToolTip(i18n("Expression entry is enabled when checked"));
-    item->setWhatsThis(i18n("When checked, this filter is enabled, and will be applied "
-    "to the result. When unchecked, this entry is not used."));
-    filtersTable->setHorizontalHeaderItem(ColEnable, item);
-
-    item = new QTableWidgetItem;
-    item->setText(QCoreApplication::translate("mainwidget", "Ex", nullptr));
-    item->setTextAlignment(Qt::AlignLeft);
-    item->setToolTip(i18n("Exclude matching lines"));
-    item->setWhatsThis(i18n("When not checked, lines matching the regular expression "
-    "will be included in the result. When checked, those which "
-    "do not match will be included."));
-    filtersTable->setHorizontalHeaderItem(ColExclude, item);
-
-    item = new QTableWidgetItem;
-    item->setText(QCoreApplication::translate("mainwidget", "IC", nullptr));
-    item->setTextAlignment(Qt::AlignLeft);
-    item->setToolTip(i18n("Use case insensitive matching"));
-    item->setWhatsThis(i18n("When checked, the regular expression match will ignore text case."));
-    filtersTable->setHorizontalHeaderItem(ColCaseIgnore, item);
-
-    item = new QTableWidgetItem;
-    item->setText(QCoreApplication::translate("mainwidget", "Regular Expression", nullptr));
-    item->setToolTip(i18n("Regular expression string"));
-    filtersTable->setHorizontalHeaderItem(ColRegEx, item);
+    auto delegate = new filterItemDelegate(filtersTable);
+    filtersTable->setItemDelegateForColumn(ColRegEx, delegate);
+    connect(delegate, SIGNAL(textEdited(int,QString)), this, SLOT(regexEdited(int,QString)));
+    connect(delegate, SIGNAL(closeEditor(QWidget*,QAbstractItemDelegate::EndEditHint)), this, SLOT(regexEditEnded()));
+
+    previewWatcher = new QFutureWatcher<samplePreview>(this);
+    connect(previewWatcher, SIGNAL(finished()), this, SLOT(previewFinished()));
+    lintWatcher = new QFutureWatcher<lintProbe>(this);
+    connect(lintWatcher, SIGNAL(finished()), this, SLOT(lintProbeFinished()));
 
     verticalLayout->addWidget(filtersTable);
 
@@ -107,10 +164,39 @@ void mainWidget::setupUi()
 
     result = new wLogText(groupBox_3);
     result->setObjectName(QStringLiteral("result"));
+    result->setTextSource([this](quintptr tag) {return resultText(reinterpret_cast<textItem const*>(tag));});
     result->setGutter(32);
     result->setFont(QFont{QStringLiteral("Monospace")});
     QVBoxLayout *verticalLayout_2 = new QVBoxLayout(groupBox_3);
     verticalLayout_2->setObjectName(QStringLiteral("verticalLayout_2"));
+
+    histogramPanel = new QWidget(groupBox_3);
+    histogramPanel->setObjectName(QStringLiteral("histogramPanel"));
+    QVBoxLayout *histogramLayout{new QVBoxLayout(histogramPanel)};
+    histogramLayout->setContentsMargins(0, 0, 0, 0);
+    QHBoxLayout *histogramControls{new QHBoxLayout};
+    histogramControls->addWidget(new QLabel(i18n("Bucket width:"), histogramPanel));
+    bucketWidthCombo = new QComboBox(histogramPanel);
+    bucketWidthCombo->setObjectName(QStringLiteral("bucketWidthCombo"));
+    bucketWidthCombo->addItem(i18n("1 second"), qlonglong{1000});
+    bucketWidthCombo->addItem(i18n("10 seconds"), qlonglong{10 * 1000});
+    bucketWidthCombo->addItem(i18n("1 minute"), qlonglong{60 * 1000});
+    bucketWidthCombo->addItem(i18n("5 minutes"), qlonglong{5 * 60 * 1000});
+    bucketWidthCombo->addItem(i18n("15 minutes"), qlonglong{15 * 60 * 1000});
+    bucketWidthCombo->addItem(i18n("1 hour"), qlonglong{60 * 60 * 1000});
+    bucketWidthCombo->addItem(i18n("1 day"), qlonglong{24 * 60 * 60 * 1000});
+    bucketWidthCombo->setCurrentIndex(2);
+    histogramControls->addWidget(bucketWidthCombo);
+    QToolButton *clearRangeButton{new QToolButton(histogramPanel)};
+    histogramControls->addWidget(clearRangeButton);
+    histogramControls->addStretch();
+    histogramLayout->addLayout(histogramControls);
+    histogram = new timeHistogram(histogramPanel);
+    histogram->setObjectName(QStringLiteral("histogram"));
+    histogramLayout->addWidget(histogram);
+    histogramPanel->hide();
+    verticalLayout_2->addWidget(histogramPanel);
+
     verticalLayout_2->addWidget(result);
 
     splitter->addWidget(groupBox_3);
@@ -119,6 +205,17 @@ void mainWidget::setupUi()
 
     status = new QLabel;
     mainWindow->statusBar()->insertWidget(0, status);
+    pendingLabel = new QLabel;
+    pendingLabel->setVisible(false);
+    mainWindow->statusBar()->addPermanentWidget(pendingLabel);
+    workLabel = new QLabel;
+    workLabel->setVisible(false);
+    mainWindow->statusBar()->addPermanentWidget(workLabel);
+    connect(&workScheduler::instance(), SIGNAL(queueChanged()), this, SLOT(workQueueChanged()));
+
+    autoRunTimer = new QTimer(this);
+    autoRunTimer->setSingleShot(true);
+    connect(autoRunTimer, SIGNAL(timeout()), this, SLOT(autoRunTimeout()));
 
     //pixBmUser = KIconLoader::global()->loadIcon(QStringLiteral("bookmarks"), KIconLoader::Small);
     pixBmUser = QIcon::fromTheme(QStringLiteral("status-note")).pixmap(16,16);
@@ -126,7 +223,10 @@ void mainWidget::setupUi()
     result->setPixmap(pixmapIdBookMark, pixBmUser);
     pixBmAnnotation = QIcon::fromTheme(QStringLiteral("status-note")).pixmap(16,16);
     result->setPixmap(pixmapIdAnnotation,  pixBmAnnotation);
-    result->setGutter(std::max(pixBmUser.width(), pixBmAnnotation.width()));
+    gutterPixmapWidth = std::max(pixBmUser.width(), pixBmAnnotation.width());
+    result->setGutter(gutterPixmapWidth);
+    result->setMarkerColor(markerBookmark, QColor{0x30, 0x80, 0xe0});
+    result->setMarkerColor(markerFindHit, QColor{0xe0, 0xa0, 0x20});
 
     KActionCollection *ac{mainWindow->actionCollection()};
 
@@ -145,6 +245,13 @@ void mainWidget::setupUi()
     actionLoadFromClipboard->setWhatsThis(i18n("Set subject to text contents of the clipboard"));
     actionLoadFromClipboard->setToolTip(i18n("Set subject to clipboard"));
 
+    actionStreamLineLimit = ac->addAction(QStringLiteral("stream_line_limit"), this, SLOT(streamLineLimitTriggered()));
+    actionStreamLineLimit->setText(i18n("Limit Streamed Lines..."));
+    actionStreamLineLimit->setToolTip(i18n("Set the number of lines kept from a streamed subject"));
+    actionStreamLineLimit->setWhatsThis(i18n("Sets the number of the most recent lines kept when the subject is "
+                                             "streamed from standard input or a named pipe. Older lines are "
+                                             "dropped, in batches, once the limit is exceeded."));
+
     actionSaveResults = ac->addAction(QStringLiteral("save_result"), this, SLOT(saveResult()));
     actionSaveResults->setText(i18n("Save Result..."));
     actionSaveResults->setToolTip(i18n("Save the filtered result."));
@@ -192,6 +299,43 @@ void mainWidget::setupUi()
     action->setIcon(QIcon::fromTheme(QStringLiteral("actual-size")));
     ac->setDefaultShortcut(action, QKeySequence(QStringLiteral("Ctrl+0")));
 
+    actionShowMinimap = ac->addAction(QStringLiteral("show_minimap"));
+    actionShowMinimap->setText(i18nc("view menu", "Show &Minimap"));
+    actionShowMinimap->setToolTip(i18n("Toggle the marker density strip beside the result scroll bar"));
+    actionShowMinimap->setWhatsThis(i18n("The minimap shows where bookmarks and find hits lie in the whole "
+                                         "result. Click or drag in it to scroll there."));
+    actionShowMinimap->setCheckable(true);
+
+    actionWrapLines = ac->addAction(QStringLiteral("wrap_lines"));
+    actionWrapLines->setText(i18nc("view menu", "&Wrap Long Lines"));
+    actionWrapLines->setToolTip(i18n("Toggle wrapping result lines at the width of the view"));
+    actionWrapLines->setWhatsThis(i18n("Wraps result lines longer than the view is wide onto the following "
+                                       "rows, rather than scrolling sideways to see them."));
+    actionWrapLines->setCheckable(true);
+
+    action = ac->addAction(QStringLiteral("show_paint_stats"));
+    action->setText(i18nc("view menu", "Show &Paint Statistics"));
+    action->setToolTip(i18n("Toggle the result paint timing overlay"));
+    action->setWhatsThis(i18n("Shows the time and rows of the last paint of the result, the slowest paint, "
+                              "style cache hits and misses, and paints and merged refreshes per second."));
+    action->setCheckable(true);
+    connect(action, SIGNAL(toggled(bool)), result, SLOT(setPaintStatsOverlay(bool)));
+
+    actionShowHistogram = ac->addAction(QStringLiteral("show_time_histogram"));
+    actionShowHistogram->setText(i18nc("view menu", "Show &Time Histogram"));
+    actionShowHistogram->setToolTip(i18n("Toggle the histogram of result lines per time bucket"));
+    actionShowHistogram->setWhatsThis(i18n("Shows the number of result lines per time bucket, from the time "
+                                           "stamp at the start of each line. Drag over the histogram to show "
+                                           "only the lines of those buckets."));
+    actionShowHistogram->setCheckable(true);
+
+    actionClearTimeRange = ac->addAction(QStringLiteral("clear_time_range"), this, SLOT(clearTimeRange()));
+    actionClearTimeRange->setText(i18nc("view menu", "Clear Time Range"));
+    actionClearTimeRange->setToolTip(i18n("Show the lines of all time buckets"));
+    actionClearTimeRange->setIcon(QIcon::fromTheme(QStringLiteral("edit-clear")));
+    actionClearTimeRange->setEnabled(false);
+    clearRangeButton->setDefaultAction(actionClearTimeRange);
+
     /***********************/
     /***   Filters menu  ***/
     actionRun = ac->addAction(QStringLiteral("run_filters"), this, [this](){applyFrom(0);}
@@ -217,6 +361,50 @@ void mainWidget::setupUi()
     action->setText(i18n("Dialect"));
     action->setToolTip(i18n("Select the RE dialect used"));
 
+    actionCollapseDuplicates = ac->addAction(QStringLiteral("collapse_duplicates"), this, SLOT(collapseDuplicatesChanged()));
+    actionCollapseDuplicates->setText(i18n("Collapse Duplicates"));
+    actionCollapseDuplicates->setCheckable(true);
+    actionCollapseDuplicates->setToolTip(i18n("Show repeated result lines once, with an occurrence count"));
+    actionCollapseDuplicates->setWhatsThis(i18n("When set, identical lines of the final result are shown once, "
+                                                "at their first occurrence, with the number of occurrences "
+                                                "in the gutter."));
+
+    actionCollapseMaskTime = ac->addAction(QStringLiteral("collapse_mask_timestamp"), this, SLOT(collapseDuplicatesChanged()));
+    actionCollapseMaskTime->setText(i18n("Ignore Timestamps When Collapsing"));
+    actionCollapseMaskTime->setCheckable(true);
+    actionCollapseMaskTime->setToolTip(i18n("Ignore a leading timestamp when collapsing duplicates"));
+    actionCollapseMaskTime->setWhatsThis(i18n("When set, lines which differ only in a leading date and time "
+                                              "are treated as duplicates."));
+
+    actionProfileLines = ac->addAction(QStringLiteral("profile_lines"));
+    actionProfileLines->setText(i18n("Profile Slow Lines"));
+    actionProfileLines->setCheckable(true);
+    actionProfileLines->setToolTip(i18n("Time the match of each line, keeping the slowest of each row"));
+    actionProfileLines->setWhatsThis(i18n("When set, the match of each line is timed as the filters run, and the "
+                                          "%1 slowest lines of each row are kept, to be listed with \"Slow Lines...\" "
+                                          "in the filters table context menu. Running is somewhat slower.",
+                                          slowLinesKept));
+
+    action = ac->addAction(QStringLiteral("line_templates"), this, SLOT(showTemplates()));
+    action->setText(i18n("Line Templates..."));
+    action->setToolTip(i18n("Group result lines by template"));
+    action->setWhatsThis(i18n("Group the lines of the final result by template, with numbers, hex IDs, "
+                              "UUIDs and IP addresses masked, and show the count of lines of each. "
+                              "Activating a template adds a filter selecting its lines."));
+
+    actionUseResultCache = ac->addAction(QStringLiteral("use_result_cache"), this, SLOT(useResultCacheTriggered(bool)));
+    actionUseResultCache->setText(i18n("Cache Results"));
+    actionUseResultCache->setCheckable(true);
+    actionUseResultCache->setToolTip(i18n("Keep filter results and bookmarks of files on disk"));
+    actionUseResultCache->setWhatsThis(i18n("When set, the result of each filter step is saved on disk, keyed by "
+                                            "the subject contents and the filters up to that step, and reused "
+                                            "when the same file is filtered the same way again. The bookmarks "
+                                            "and position in the result are restored when the file is reopened."));
+
+    action = ac->addAction(QStringLiteral("clear_result_cache"), this, SLOT(clearResultCache()));
+    action->setText(i18n("Clear Result Cache"));
+    action->setToolTip(i18n("Remove all cached filter results and saved bookmarks"));
+
     action = ac->addAction(QStringLiteral("load_filters"), this, SLOT(loadFilters()));
     action->setText(i18n("Load Filters..."));
     action->setToolTip(i18n("Replace current filter list with contents of a file."));
@@ -252,6 +440,23 @@ void mainWidget::setupUi()
     action->setToolTip(i18n("Clears the filters table"));
     action->setIcon(QIcon::fromTheme(QStringLiteral("delete-table")));
 
+    filtersUndo = new QUndoStack(this);
+    action = KStandardAction::undo(filtersUndo, SLOT(undo()), ac);
+    action->setToolTip(i18n("Undo the last change to the filters"));
+    action->setEnabled(false);
+    connect(filtersUndo, SIGNAL(canUndoChanged(bool)), action, SLOT(setEnabled(bool)));
+    action = KStandardAction::redo(filtersUndo, SLOT(redo()), ac);
+    action->setToolTip(i18n("Redo the last undone change to the filters"));
+    action->setEnabled(false);
+    connect(filtersUndo, SIGNAL(canRedoChanged(bool)), action, SLOT(setEnabled(bool)));
+
+    /* Filter edits are recorded from the model, which signals changes made
+     * from code as well as those made in the view. */
+    connect(filtersModel, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)), this, SLOT(filtersEdited()));
+    connect(filtersModel, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(filtersEdited()));
+    connect(filtersModel, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(filtersEdited()));
+    connect(filtersModel, SIGNAL(modelReset()), this, SLOT(filtersEdited()));
+
     /**********************/
     /*** Result Menu  ***/
     action = KStandardAction::find(this, SLOT(resultFind()), ac);
@@ -282,6 +487,12 @@ void mainWidget::setupUi()
     action->setText(i18n("Result Font..."));
     action->setToolTip(i18n("Select the font for the results table"));
 
+    action = ac->addAction(QStringLiteral("step_memory_budget"), this, SLOT(stepMemoryBudgetTriggered()));
+    action->setText(i18n("Step Memory Budget..."));
+    action->setToolTip(i18n("Set the memory kept for intermediate filter results"));
+    action->setWhatsThis(i18n("Intermediate filter results beyond this budget are packed, and if need be "
+                              "dropped, and rebuilt when a filter above them is changed."));
+
     /***********************************/
     /*** Filters table context menu  ***/
     filtersTableMenu = new QMenu(filtersTable);
@@ -318,6 +529,21 @@ void mainWidget::setupUi()
 
     filtersTableMenu->addSeparator();
 
+    actionPinStep = filtersTableMenu->addAction(i18n("Pin Step as Base"), this, SLOT(pinStep()));
+    ac->addAction(QStringLiteral("pin_step"), actionPinStep);
+    actionPinStep->setToolTip(i18n("Keep the result of the current row, and free the results before it"));
+    actionPinStep->setWhatsThis(i18n("Keeps the result of the current row in memory, and frees the results of "
+                                     "the rows above it. Editing a row above rebuilds them from the source."));
+    actionPinStep->setIcon(QIcon::fromTheme(QStringLiteral("pin")));
+
+    action = filtersTableMenu->addAction(i18n("Slow Lines..."), this, SLOT(showSlowLines()));
+    ac->addAction(QStringLiteral("slow_lines"), action);
+    action->setToolTip(i18n("List the lines the current row took longest to match"));
+    action->setWhatsThis(i18n("Lists the lines the current row took longest to match, when it was last run "
+                              "with \"Profile Slow Lines\" set. Activating a line shows it in the result."));
+
+    filtersTableMenu->addSeparator();
+
     actionInsertFilters = filtersTableMenu->addAction(i18n("Insert File ..."), this,
                 SLOT(insertFiltersAbove()));
     ac->addAction(QStringLiteral("insert_filters"), actionInsertFilters);
@@ -333,6 +559,16 @@ void mainWidget::setupUi()
     actionCopySelection = KStandardAction::copy(result, SLOT(copy()), ac);
     ctxtMenu->addAction(actionCopySelection);
 
+    actionSaveSelectionAs = ac->addAction(QStringLiteral("save_selection_as"), this, SLOT(saveSelectionAs()));
+    actionSaveSelectionAs->setText(i18n("Save Selection As..."));
+    actionSaveSelectionAs->setToolTip(i18n("Save the selected result text to a file."));
+    actionSaveSelectionAs->setWhatsThis(i18n("Save the selected text of the result to a file, without copying it "
+                                             "to the clipboard; for selections too large to paste."));
+    actionSaveSelectionAs->setIcon(QIcon::fromTheme(QStringLiteral("document-save-as")));
+    actionSaveSelectionAs->setEnabled(false);
+    connect(result, SIGNAL(copyAvailable(bool)), actionSaveSelectionAs, SLOT(setEnabled(bool)));
+    ctxtMenu->addAction(actionSaveSelectionAs);
+
     // Annotation menu items:
     // ctxtMenu->addSeparator();
     // action = ac->addAction(QStringLiteral("annotation"), this, SLOT(addAnnotationAction()));
@@ -350,9 +586,14 @@ void mainWidget::setupUi()
     ctxtMenu->addAction(actionToggleBookmark);
     ctxtMenu->addAction(actionBookmarkMenu);
 
-    connect(filtersTable, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(tableItemChanged(QTableWidgetItem*)));
+    connect(filtersModel, SIGNAL(entryEdited(int,int)), this, SLOT(filterEntryEdited(int,int)));
     connect(filtersTable, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(filtersTableMenuRequested(QPoint)));
     connect(actionLineNumbers, SIGNAL(triggered(bool)), this, SLOT(actionLineNumbersTriggerd(bool)));
+    connect(actionShowMinimap, SIGNAL(triggered(bool)), this, SLOT(showMinimapTriggered(bool)));
+    connect(actionWrapLines, SIGNAL(triggered(bool)), this, SLOT(wrapLinesTriggered(bool)));
+    connect(actionShowHistogram, SIGNAL(triggered(bool)), this, SLOT(showHistogramTriggered(bool)));
+    connect(bucketWidthCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(bucketWidthChanged(int)));
+    connect(histogram, SIGNAL(rangeSelected(int,int)), this, SLOT(timeRangeSelected(int,int)));
 
     if (objectName().isEmpty())
         setObjectName(QStringLiteral("mainWidget"));
@@ -368,6 +609,22 @@ void mainWidget::setupUi()
 
     /* settings related to the general application */
     KConfigGroup generalConfig{KSharedConfig::openConfig(), generalConfigName};
+    streamLineLimit = generalConfig.readEntry(QStringLiteral("streamLineLimit"), 0);
+    actionUseResultCache->setChecked(generalConfig.readEntry(QStringLiteral("useResultCache"), true));
+    stepMemoryBudget = generalConfig.readEntry(QStringLiteral("stepMemoryBudget"), stepMemoryBudget);
+    autoRunLatency = generalConfig.readEntry(QStringLiteral("autoRunLatency"), autoRunLatency);
+    auto& scheduler = workScheduler::instance();
+    /* The foreground lane is QtConcurrent's global pool, shared with other
+     * users of it, so only its thread count is set. */
+    for (auto const& [lane, name] : {std::pair{workLane::interactive, QStringLiteral("interactive")},
+                                     std::pair{workLane::foreground, QStringLiteral("foreground")},
+                                     std::pair{workLane::background, QStringLiteral("background")}}) {
+        scheduler.setThreadCount(lane, generalConfig.readEntry(QStringLiteral("%1Threads").arg(name), 0));
+        if (lane != workLane::foreground) {
+            auto const cpus = generalConfig.readEntry(QStringLiteral("%1Cpus").arg(name), QList<int>{});
+            scheduler.setCpuAffinity(lane, {cpus.cbegin(), cpus.cend()});
+        }
+    }
 
     /* settings related to the filters section */
     KConfigGroup filtersConfig{KSharedConfig::openConfig(), filtersConfigName};
@@ -381,6 +638,16 @@ void mainWidget::setupUi()
     findHistorySize = resultsConfig.readEntry(QStringLiteral("findHistorySize"), findHistorySize);
 
     actionLineNumbers->setChecked(resultsConfig.readEntry(QStringLiteral("showLineNumbers"), false));
+    actionShowMinimap->setChecked(resultsConfig.readEntry(QStringLiteral("showMinimap"), true));
+    result->setMinimapVisible(actionShowMinimap->isChecked());
+    actionWrapLines->setChecked(resultsConfig.readEntry(QStringLiteral("wrapLines"), false));
+    result->setWrapLines(actionWrapLines->isChecked());
+    actionShowHistogram->setChecked(resultsConfig.readEntry(QStringLiteral("showTimeHistogram"), false));
+    histogramPanel->setVisible(actionShowHistogram->isChecked());
+    bucketWidthCombo->setCurrentIndex(resultsConfig.readEntry(QStringLiteral("histogramBucketWidth"), 2));
+    actionCollapseDuplicates->setChecked(resultsConfig.readEntry(QStringLiteral("collapseDuplicates"), false));
+    actionCollapseMaskTime->setChecked(resultsConfig.readEntry(QStringLiteral("collapseMaskTimestamp"), false));
+    actionCollapseMaskTime->setEnabled(actionCollapseDuplicates->isChecked());
 }
 
 
@@ -392,13 +659,8 @@ void mainWidget::updateApplicationTitle()
 auto mainWidget::initialLoad(const commandLineOptions& opts) -> bool
 {
     if (opts.stdin)
-      QMessageBox::warning(this,
-                           i18nc("Warning message box caption for option not supported",
-                                 "Option Not Supported"),
-                           i18nc("Warning message box content for option not supported",
-                                 "--stdin option not supported in GUI mode"));
-
-    if (!opts.subjectFile.isEmpty()) {
+        startStream(QString{});
+    else if (!opts.subjectFile.isEmpty()) {
         if (!loadSubjectFile(opts.subjectFile))
             QMessageBox::warning(this,
                                  i18nc("Warning message box caption for could not load file",
@@ -439,6 +701,10 @@ auto mainWidget::initialLoad(const commandLineOptions& opts) -> bool
     actionAutorun->setChecked(opts.autoRun);
     actionRun->setEnabled(!opts.autoRun);
 
+    /* The initial filters are not an edit to undo. */
+    recordFiltersEdit();
+    filtersUndo->clear();
+
     return true;
 }
 
@@ -462,27 +728,29 @@ auto mainWidget::loadSubjectFile(const QString& localFile) -> bool
 {
     if (localFile.isEmpty())
         return true;
+    saveSubjectState();
+
+    /* A named pipe is streamed, as it may never reach end of file. */
+    if (struct stat info; ::stat(QFile::encodeName(localFile).constData(), &info) == 0 && S_ISFIFO(info.st_mode)) {
+        startStream(localFile);
+        recentFileAction->addUrl(QUrl::fromLocalFile(localFile));
+        return true;
+    }
 
-    if (QFile source(localFile); source.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    /* Line ends are handled by splitLines(), so the file is not opened in
+     * text mode; that would scan and compact the whole buffer for "\r". */
+    if (QFile source(localFile); source.open(QIODevice::ReadOnly)) {
         titleFile = QFileInfo(localFile).fileName();
         subjModified = false;
         resultFileName.clear();
         updateApplicationTitle();
         sourceLineCount = -1;
         clearResultsAfter(0);
-        bookmarkedLines.clear();
-        sourceItems.clear();
-        sourceLineCount = 0;
-        for(QTextStream stream(&source); !stream.atEnd(); )
-            sourceItems.emplace_back(++sourceLineCount, stream.readLine());
-        sourceItems.shrink_to_fit();
-
-        stepList steps;
-        steps.reserve(sourceItems.size());
-        std::for_each(sourceItems.begin(), sourceItems.end(),
-                      [&steps](auto& item) mutable {steps.push_back(&item);});
-        stepResults.resize(1);
-        stepResults[0] = std::move(steps);
+        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        setSubjectText(source.readAll());
+        subjectCacheable = true;
+        restoreSubjectState();
+        QGuiApplication::restoreOverrideCursor();
         recentFileAction->addUrl(QUrl::fromLocalFile(localFile));
         status->setText(QStringLiteral("%1: %2 lines").arg(localFile).arg(sourceItems.size()));
         maybeAutoApply(0);
@@ -499,129 +767,1097 @@ void mainWidget::loadRecentSubject(const QUrl& url)
 
 void mainWidget::loadSubjectFromCB()
 {
+    /* Take the clipboard's UTF-8 bytes as the subject buffer; decoding through
+     * a QString would hold the text three times over at the peak. */
     const QClipboard *clipboard = QApplication::clipboard();
-    QString text = clipboard->text();
-    if (text.isEmpty()) {
+    QByteArray utf8;
+    if (QMimeData const* mime = clipboard->mimeData()) {
+        utf8 = mime->data(QStringLiteral("text/plain;charset=utf-8"));
+        if (utf8.isEmpty())
+            utf8 = mime->data(QStringLiteral("text/plain"));
+    }
+    if (utf8.isEmpty())
+        utf8 = clipboard->text().toUtf8();
+    if (utf8.isEmpty()) {
         QMessageBox::information(this,
                         i18nc("@title:window title of no data in clipboard information dialog", "No Data"),
                         i18nc("@info:status informational message of no data in clipboard information dialog", "Clipboard does not contain text data"));
         return;
     }
 
+    saveSubjectState();
+    titleFile = i18nc("@info:status title bar file-name when loaded from clipboard", "<clipboard>");
+    subjModified = false;
+    updateApplicationTitle();
+    sourceLineCount = -1;
+    clearResultsAfter(0);
+    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    setSubjectText(std::move(utf8));
+    subjectCacheable = true;
+    restoreSubjectState();
+    QGuiApplication::restoreOverrideCursor();
+    status->setText(QStringLiteral("%1: %2 lines").arg(titleFile).arg(sourceLineCount));
+    maybeAutoApply(0);
+}
+
+void mainWidget::setSubjectText(QByteArray&& text)
+{
+    cancelRun(true);
+    clearPreview();
+    clearLint();
+    pendingRun = std::numeric_limits<size_t>::max();
+    stopStream();
+    subjectCacheable = false;
+    subjectHash.reset();
+    pendingCaretLine = 0;
+    recentSteps.clear();
+    evictedSteps.clear();
+    stepCosts.clear();
+    recentStepKeys.clear();
+    rowSlowLines.clear();
+    pinnedStep = 0;
     bookmarkedLines.clear();
+    sourceTimes.clear();
+    /* The result lines read their text from the source items. */
+    clearResults();
+    sourceLineMap.clear();
     sourceItems.clear();
-    int srcLine = 0;
-    for(QTextStream stream(&text, QIODevice::ReadOnly); !stream.atEnd(); )
-        sourceItems.emplace_back(++srcLine, stream.readLine());
-    sourceItems.shrink_to_fit();
-
-    stepList steps;
-    steps.reserve(sourceItems.size());
-    std::for_each(sourceItems.begin(), sourceItems.end(),
-                  [&steps](auto& item) mutable {steps.push_back(&item);});
+    subjectBlocks.clear();
     stepResults.resize(1);
-    stepResults[0] = std::move(steps);
+    stepResults[0].clear();
+    updateBookmarkMenu();
+    sourceLineCount = 0;
+    appendSubjectText(std::move(text));
+}
 
-    titleFile = i18nc("@info:status title bar file-name when loaded from clipboard", "<clipboard>");
+auto mainWidget::appendSubjectText(QByteArray&& text) -> stepList
+{
+    auto& block = subjectBlocks.emplace_back(subjectBlock{std::move(text), sourceLineCount});
+    auto const lines = splitLines(std::string_view{block.text.constData(), static_cast<size_t>(block.text.size())});
+
+    stepList added;
+    added.reserve(static_cast<int>(lines.size()));
+    for (std::string_view const line : lines) {
+        auto& item = sourceItems.emplace_back(++sourceLineCount, line);
+        added.push_back(&item);
+    }
+    block.lastLine = sourceLineCount;
+    stepResults[0].append(added);
+    return added;
+}
+
+auto mainWidget::firstSourceLine() const -> int
+{
+    return sourceItems.empty() ? 1 : sourceItems.front().srcLineNumber;
+}
+
+void mainWidget::startStream(QString const& fileName)
+{
+    saveSubjectState();
+    titleFile = fileName.isEmpty() ? i18nc("@info:status title bar file-name when read from standard input", "<stdin>")
+                                   : QFileInfo(fileName).fileName();
     subjModified = false;
+    resultFileName.clear();
     updateApplicationTitle();
-    sourceLineCount = -1;
     clearResultsAfter(0);
-    sourceLineCount = sourceItems.size();
-    status->setText(QStringLiteral("%1: %2 lines").arg(titleFile).arg(sourceLineCount));
+    setSubjectText(QByteArray{});
+
+    /* The thread and reader delete themselves when reading ends, which may be
+     * after this widget is gone if a named pipe is still waiting for a writer. */
+    auto thread = new QThread;
+    streamSource = new streamReader{fileName};
+    streamSource->moveToThread(thread);
+    connect(thread, SIGNAL(started()), streamSource, SLOT(run()));
+    connect(streamSource, SIGNAL(blockRead(QByteArray)), this, SLOT(streamBlockRead(QByteArray)));
+    connect(streamSource, SIGNAL(finished(QString)), this, SLOT(streamFinished(QString)));
+    connect(streamSource, SIGNAL(finished(QString)), thread, SLOT(quit()));
+    connect(thread, SIGNAL(finished()), streamSource, SLOT(deleteLater()));
+    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    thread->start();
+
+    status->setText(i18n("%1: reading", titleFile));
     maybeAutoApply(0);
 }
 
+void mainWidget::stopStream()
+{
+    if (streamSource) {
+        disconnect(streamSource, nullptr, this, nullptr);
+        streamSource->stop();
+        streamSource = nullptr;
+    }
+}
+
+void mainWidget::streamBlockRead(QByteArray const& text)
+{
+    /* A run in flight is filtering the steps the new lines are added to, so
+     * it is cancelled, and run again once the new lines are in. */
+    if (runInFlight) {
+        cancelRun(true);
+        pendingRun = std::min(pendingRun, validSteps);
+    }
+    stepList added{appendSubjectText(QByteArray{text})};
+    if (added.empty())
+        return;
+    recentSteps.clear();
+    restoreEvictedSteps();
+
+    if (!sourceTimes.empty()) {
+        auto times = lineTimestamps(static_cast<size_t>(added.size()),
+                                    [&added](size_t n) {return added[static_cast<int>(n)]->text;});
+        for (auto it = times.begin(); it != times.end() && *it == noTimestamp; ++it)
+            *it = sourceTimes.back();
+        sourceTimes.insert(sourceTimes.end(), times.begin(), times.end());
+    }
+
+    /* Run the new lines through the steps whose results are current; the
+     * earlier lines are not filtered again. */
+    auto const rows = static_cast<size_t>(filtersModel->rowCount());
+    size_t const currentRows = std::min({validSteps, editedRow, rows});
+    bool const current = currentRows == rows && stepResults.size() == rows + 1;
+    for (size_t row = 0; row < currentRows && row + 1 < stepResults.size() && !added.empty(); ++row) {
+        added = applyExpression(row, std::move(added));
+        stepResults[row + 1].append(added);
+    }
+
+    if (current && !added.empty()) {
+        resultTimeExtentKnown = false;
+        int const width = QStringLiteral("%1").arg(added.back()->srcLineNumber).size();
+        if (actionCollapseDuplicates->isChecked() || timeRange
+            || (actionLineNumbers->isChecked() && width + 2 != lineNoColCount)) {
+            collapseDuplicates();
+            displayResult();
+        } else {
+            /* Mark the find hits among the new lines, as updateFindMarkers() marks the others. */
+            auto const findHit = result->minimapVisible() ? findHitMatcher() : std::function<bool(QStringView)>{};
+            result->append(qAsConst(added) | std::views::transform([this,&findHit](textItem *item) {
+                auto ltItem = newResultItem(item);
+                if (findHit && findHit(resultText(item)))
+                    ltItem.setMarkers(static_cast<markerMask_t>(ltItem.markers() | (1u << markerFindHit)));
+                return ltItem;}));
+            for (auto const item : qAsConst(added))
+                sourceLineMap.push_back(item->srcLineNumber);
+            actionSaveResults->setEnabled(true);
+            actionSaveResultsAs->setEnabled(true);
+        }
+    }
+    trimSource();
+    if (current)
+        updateHistogram();
+    status->setText(i18n("%1: reading -- source: %2, final %3 lines", titleFile, sourceLineCount,
+                         current ? result->lineCount() : 0));
+}
+
+void mainWidget::streamFinished(QString const& error)
+{
+    streamSource = nullptr;
+    if (error.isEmpty())
+        status->setText(i18n("%1: end of input, %2 lines", titleFile, sourceLineCount));
+    else
+        status->setText(i18n("%1: read failed: %2", titleFile, error));
+}
 
-stepList mainWidget::applyExpression(size_t entry, stepList src)
+void mainWidget::trimSource()
+{
+    if (streamLineLimit <= 0 || std::cmp_less(sourceItems.size(), slackedLineLimit(streamLineLimit)))
+        return;
+
+    recentSteps.clear();
+    restoreEvictedSteps();
+    clearPreview();
+    clearLint();
+    auto const toRemove = sourceItems.size() - static_cast<size_t>(streamLineLimit);
+    int const firstKept = sourceItems[toRemove].srcLineNumber;
+    auto const removed = [firstKept](textItem const* item) {return item->srcLineNumber < firstKept;};
+
+    /* Each step is in source order, so the removed lines are a prefix of each. */
+    int finalRemoved = 0;
+    for (auto& step : stepResults) {
+        auto const end = std::partition_point(step.begin(), step.end(), removed);
+        finalRemoved = static_cast<int>(std::distance(step.begin(), end));
+        step.erase(step.begin(), end);
+    }
+
+    auto const rows = static_cast<size_t>(filtersModel->rowCount());
+    if (validSteps >= rows && stepResults.size() == rows + 1) {
+        /* A time range is of final step indexes, which have now moved. */
+        bool const redisplay{actionCollapseDuplicates->isChecked() || timeRange};
+        if (timeRange) {
+            timeRange.reset();
+            histogram->clearSelection();
+            actionClearTimeRange->setEnabled(false);
+        }
+        if (redisplay) {
+            collapseDuplicates();
+            displayResult();
+        } else if (finalRemoved > 0) {
+            result->clear(0, finalRemoved);
+            sourceLineMap.erase(sourceLineMap.begin(), sourceLineMap.begin() + finalRemoved);
+        }
+        resultTimeExtentKnown = false;
+    } else {
+        /* The result shown is not current, but its lines still read their text
+         * from the source items about to be removed. */
+        auto const kept = std::partition_point(sourceLineMap.cbegin(), sourceLineMap.cend(),
+                                               [firstKept](int line) {return line < firstKept;});
+        if (auto const stale = static_cast<int>(std::distance(sourceLineMap.cbegin(), kept)); stale > 0) {
+            result->clear(0, stale);
+            sourceLineMap.erase(sourceLineMap.begin(), sourceLineMap.begin() + stale);
+        }
+    }
+
+    bool bookmarksRemoved{false};
+    for (auto it = bookmarkedLines.begin(); it != bookmarkedLines.end(); ) {
+        if (*it < firstKept) {
+            it = bookmarkedLines.erase(it);
+            bookmarksRemoved = true;
+        } else
+            ++it;
+    }
+    if (bookmarksRemoved)
+        updateBookmarkMenu();
+    if (!sourceTimes.empty())
+        sourceTimes.erase(sourceTimes.begin(), sourceTimes.begin() + static_cast<std::ptrdiff_t>(toRemove));
+    sourceItems.erase(sourceItems.begin(), sourceItems.begin() + static_cast<std::ptrdiff_t>(toRemove));
+    while (!subjectBlocks.empty() && subjectBlocks.front().lastLine < firstKept)
+        subjectBlocks.pop_front();
+}
+
+void mainWidget::streamLineLimitTriggered()
+{
+    bool ok{false};
+    int const limit = QInputDialog::getInt(this, i18n("Limit Streamed Lines"),
+                                           i18n("Most recent lines to keep (0 for no limit):"),
+                                           streamLineLimit, 0, std::numeric_limits<int>::max(), 1000, &ok);
+    if (!ok)
+        return;
+    streamLineLimit = limit;
+    KConfigGroup generalConfig{KSharedConfig::openConfig(), generalConfigName};
+    generalConfig.writeEntry(QStringLiteral("streamLineLimit"), streamLineLimit);
+    trimSource();
+}
+
+
+stepList mainWidget::applyExpression(size_t entry, stepList src, bool annotate, filterMode mode)
 {
     if (src.empty())
         return src;
 
-    if (size_t const rows = filtersTable->rowCount(); entry >= rows) {
+    if (size_t const rows = filtersModel->rowCount(); entry >= rows) {
         qWarning() << QStringLiteral("Range failure %1/%2").arg(entry).arg(rows);
         return stepList{};
     }
 
-    auto* item = filtersTable->item(entry, ColRegEx);
-    if (!item)
-        return src;
-
-    if (filtersTable->item(entry, ColEnable)->checkState() != Qt::Checked) {
-        item->setToolTip(i18nc("@info:tooltip filter table entry when expression is disabled", "disabled"));
+    /* A copy, so edits made while the lines are filtered do not change the step. */
+    filterEntry const entryCopy{filtersModel->entry(static_cast<int>(entry))};
+    if (!entryCopy.enabled) {
+        setRowToolTip(entry, i18nc("@info:tooltip filter table entry when expression is disabled", "disabled"));
         return src;
     }
 
-    if (item->text().isEmpty()) {
-        item->setToolTip(QString{});
+    if (entryCopy.re.isEmpty()) {
+        setRowToolTip(entry, QString{});
         return src;
     }
 
-    bool const exclude = filtersTable->item(entry, ColExclude)->checkState() == Qt::Checked;
-    QRegularExpression::PatternOptions pOpts = QRegularExpression::NoPatternOption;
-    if (filtersTable->item(entry, ColCaseIgnore)->checkState() == Qt::Checked)
-        pOpts |= QRegularExpression::CaseInsensitiveOption;
-    QRegularExpression re{item->text(), pOpts};
+    bool const exclude = entryCopy.exclude;
+    utf8RegularExpression const re{entryCopy.re, entryCopy.ignoreCase};
     if (!re.isValid())
         return src;
-    re.optimize();
 
     QElapsedTimer timer;
     timer.start();
-    auto const result = QtConcurrent::blockingFiltered(src,
-        [&re, exclude](const textItem* item) {return re.match(item->text).hasMatch() ^ exclude;});
-    item->setToolTip(QStringLiteral("%L1 of %L2 -- %L3us").arg(result.size())
-            .arg(src.size()).arg(timer.nsecsElapsed()/1000));
+    auto const matches = [&re, exclude](const textItem* item) {return re.match(item->text) ^ exclude;};
+    bool const cancellable = mode == filterMode::cancellable;
+    auto const filter = [this,&src,cancellable](auto const& keep) -> stepList {
+        if (!cancellable)
+            return QtConcurrent::blockingFiltered(src, keep);
+
+        /* Filter in the background, handling events meanwhile, so an edit can
+         * cancel the run. */
+        runFuture = QtConcurrent::filteredReduced<stepList>(src, keep,
+            [](stepList& list, textItem *item) {list.push_back(item);},
+            QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+        QEventLoop loop;
+        QFutureWatcher<stepList> watcher;
+        connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        watcher.setFuture(runFuture);
+        if (!runFuture.isFinished())
+            loop.exec();
+        runFuture.waitForFinished();
+        if (runCancelled)
+            return stepList{};
+        stepList kept{runFuture.result()};
+        runFuture = QFuture<stepList>{};
+        return kept;};
+
+    stepList result;
+    if (actionProfileLines->isChecked()) {
+        /* Timing is a separate predicate, so it costs nothing when profiling is off. */
+        slowLinesReservoir slowest{slowLinesKept};
+        result = filter([&matches,&slowest](const textItem* item) {
+            auto const start = std::chrono::steady_clock::now();
+            bool const keep = matches(item);
+            slowest.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+                        item->srcLineNumber);
+            return keep;});
+        if (rowSlowLines.size() <= entry)
+            rowSlowLines.resize(entry + 1);
+        rowSlowLines[entry] = slowest.lines();
+    } else
+        result = filter(matches);
+    if (cancellable && runCancelled)
+        return stepList{};
+
+    if (annotate) {
+        QString toolTip{QStringLiteral("%L1 of %L2 -- %L3us").arg(result.size())
+                .arg(src.size()).arg(timer.nsecsElapsed()/1000)};
+        if (actionProfileLines->isChecked() && !rowSlowLines[entry].empty())
+            toolTip += QStringLiteral(" -- slowest line %L1: %L2us").arg(rowSlowLines[entry].front().srcLineNumber)
+                    .arg(rowSlowLines[entry].front().nanos/1000);
+        if (re.matchErrors() > 0)
+            toolTip += QLatin1Char('\n') + i18n("%1 lines could not be matched, and count as not matching: %2",
+                                                re.matchErrors(), re.matchErrorString());
+        setRowToolTip(entry, toolTip);
+    } else if (re.matchErrors() > 0)
+        status->setText(i18n("Row %1: %2 lines could not be matched, and count as not matching: %3",
+                             entry + 1, re.matchErrors(), re.matchErrorString()));
     return result;
 }
 
 
 void mainWidget::maybeAutoApply(int entry)
 {
-    if (actionAutorun->isChecked())
-        applyFrom(entry);
+    if (!actionAutorun->isChecked())
+        return;
+
+    cancelRun(false);
+    pendingRun = std::min(pendingRun, static_cast<size_t>(std::max(entry, 0)));
+    if (qint64 const estimate = estimateRunNanos(pendingRun); estimate <= qint64{autoRunLatency} * 1000000) {
+        pendingLabel->setVisible(false);
+        autoRunTimer->start(0);
+    } else {
+        pendingLabel->setText(i18nc("@info:status auto-run waiting for edits to stop", "Run pending (about %1 s)",
+                                    QString::number(static_cast<double>(estimate) / 1e9, 'f', 1)));
+        pendingLabel->setVisible(true);
+        autoRunTimer->start(autoRunDelay);
+    }
+}
+
+void mainWidget::autoRunTimeout()
+{
+    /* A cancelled run is still unwinding; start once it has. */
+    if (runInFlight) {
+        autoRunTimer->start(50);
+        return;
+    }
+    if (pendingRun != std::numeric_limits<size_t>::max())
+        applyFrom(pendingRun);
+}
+
+auto mainWidget::estimateRunNanos(size_t start) -> qint64
+{
+    start = std::min(start, validSteps);
+    auto const rows = static_cast<size_t>(filtersModel->rowCount());
+    if (start >= stepResults.size())
+        return 0;
+
+    qint64 lines = stepResults[start].size();
+    if (start < evictedSteps.size() && evictedSteps[start])
+        lines = evictedSteps[start]->dropped ? static_cast<qint64>(sourceItems.size()) : evictedSteps[start]->count;
+
+    uint64_t key{0};
+    for (size_t row = 0; row < start; ++row)
+        key = chainStepKey(row, key);
+    qint64 nanos = 0;
+    for (size_t row = start; row < rows; ++row) {
+        key = chainStepKey(row, key);
+        if (!isActiveFilter(row) || recentSteps.contains(key))
+            continue;
+        qint64 const perLine = row < rowLineNanos.size() && rowLineNanos[row] > 0 ? rowLineNanos[row] : nominalLineNanos;
+        nanos += perLine * lines;
+    }
+    return nanos;
+}
+
+void mainWidget::regexEdited(int row, QString const& text)
+{
+    /* Only a held, current input is previewed; rebuilding an evicted step, or
+     * one after an edited row, would filter on the GUI thread at each key. */
+    stepList const* input = row < 0 ? nullptr : heldStepInput(static_cast<size_t>(row));
+    if (!input) {
+        previewRow = -1;
+        previewPending.reset();
+        return;
+    }
+
+    /* A preview running for another row is left to finish, and its result ignored. */
+    if (row != previewRow) {
+        previewRow = row;
+        previewSample.clear();
+        previewInputLines = -1;
+    }
+    if (input->size() != previewInputLines) {
+        /* Filters keep their input's order, and the lines of a step only change
+         * when it is recomputed, so the sample is kept while its size is unchanged.
+         * A running preview holds its own copy of the sample. */
+        previewInputLines = input->size();
+        previewSample.clear();
+        auto const indexes = stratifiedSample(static_cast<size_t>(input->size()), previewSampleSize);
+        previewSample.reserve(static_cast<int>(indexes.size()));
+        for (size_t const index : indexes)
+            previewSample.push_back((*input)[static_cast<int>(index)]);
+    }
+
+    if (text.isEmpty()) {
+        previewPending.reset();
+        setRowToolTip(static_cast<size_t>(row), QString{});
+        QToolTip::hideText();
+    } else if (previewWatcher->isRunning())
+        previewPending = text;
+    else
+        startPreview(text);
+}
+
+void mainWidget::startPreview(QString const& text)
+{
+    previewPending.reset();
+    bool const exclude = filtersModel->entry(previewRow).exclude;
+    bool const ignoreCase = filtersModel->entry(previewRow).ignoreCase;
+    previewWatcher->setFuture(workScheduler::instance().run(workLane::interactive,
+        [sample = previewSample, row = previewRow, text, exclude, ignoreCase]() {
+            samplePreview preview{row, static_cast<size_t>(sample.size()), 0, false, {}};
+            utf8RegularExpression const re{text, ignoreCase};
+            if (!re.isValid()) {
+                preview.error = re.errorString();
+                return preview;
+            }
+            /* A catastrophic expression must not tie up the lane, nor clearPreview() waiting on it. */
+            for (auto const item : sample) {
+                auto const matched = re.matchLimited(item->text, lintMatchLimit);
+                if (!matched) {
+                    preview.tooCostly = true;
+                    break;
+                }
+                preview.kept += (*matched ^ exclude) ? 1 : 0;
+            }
+            return preview;}));
+}
+
+void mainWidget::previewFinished()
+{
+    samplePreview const preview{previewWatcher->result()};
+    /* Text edited since supersedes the result, whichever row it was for. */
+    if (previewPending && previewRow >= 0) {
+        startPreview(*previewPending);
+        return;
+    }
+    if (preview.row != previewRow || preview.row < 0)
+        return;
+
+    QString tip;
+    if (!preview.error.isEmpty())
+        tip = i18nc("@info:tooltip preview of an expression being edited", "Invalid: %1", preview.error);
+    else if (preview.tooCostly)
+        tip = i18nc("@info:tooltip preview of an expression being edited",
+                    "Too costly to estimate: a sampled line exceeds the backtracking limit");
+    else if (std::cmp_equal(preview.sampled, previewInputLines))
+        tip = i18nc("@info:tooltip preview of an expression being edited", "%1 of %2 lines kept",
+                    preview.kept, previewInputLines);
+    else {
+        auto const [low, high] = wilsonInterval(preview.kept, preview.sampled);
+        double const fraction = static_cast<double>(preview.kept) / static_cast<double>(preview.sampled);
+        auto const lines = [this](double share) {
+            return QStringLiteral("%L1").arg(std::llround(share * previewInputLines));};
+        tip = i18nc("@info:tooltip preview of an expression being edited, from a sample; %3 and %4 are "
+                    "the bounds of the 95% confidence interval",
+                    "About %1 of %2 lines kept (%5%), between %3 and %4; from %6 sampled lines",
+                    lines(fraction), previewInputLines, lines(low), lines(high),
+                    QString::number(fraction * 100.0, 'g', 3), preview.sampled);
+    }
+    setRowToolTip(static_cast<size_t>(preview.row), tip);
+    QRect const rect{filtersTable->visualRect(filtersModel->index(preview.row, ColRegEx))};
+    QToolTip::showText(filtersTable->viewport()->mapToGlobal(rect.bottomLeft()), tip, filtersTable->viewport());
+}
+
+void mainWidget::regexEditEnded()
+{
+    /* A committed edit is run in full; a preview still running is dropped. */
+    previewRow = -1;
+    previewPending.reset();
+    QToolTip::hideText();
+}
+
+void mainWidget::clearPreview()
+{
+    previewRow = -1;
+    previewPending.reset();
+    previewWatcher->waitForFinished();
+    previewSample.clear();
+    previewInputLines = 0;
+}
+
+void mainWidget::cancelRun(bool wait)
+{
+    if (!runInFlight)
+        return;
+    runCancelled = true;
+    runFuture.cancel();
+    if (wait)
+        runFuture.waitForFinished();
 }
 
 void mainWidget::applyFrom(size_t start)
 {
+    /* Called again while running, as by "Run" during a run: restart. */
+    if (runInFlight) {
+        cancelRun(false);
+        pendingRun = std::min(pendingRun, start);
+        autoRunTimer->start(0);
+        return;
+    }
+
+    /* Start from a pending run, if earlier, and from the last step which is
+     * current, if a run was cancelled. */
+    start = std::min({start, pendingRun, validSteps, editedRow});
+    pendingRun = std::numeric_limits<size_t>::max();
+    autoRunTimer->stop();
+    pendingLabel->setVisible(false);
+
     clearResultsAfter(start);
+    if (start <= editedRow)
+        editedRow = std::numeric_limits<size_t>::max();
     if (stepResults.size() > start) {
         if (!validateExpressions(start))
             return;
 
-        size_t rows = filtersTable->rowCount();
+        size_t rows = filtersModel->rowCount();
         QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        stepInput(start);
         stepResults.resize(rows+1);
+        rowLineNanos.resize(rows);
+        runInFlight = true;
+        runCancelled = false;
+
+        /* Cache keys chain through the active rows: from 0 for recentSteps,
+         * and from the subject fingerprint for the disk cache. */
+        uint64_t recentKey{0};
+        std::optional<uint64_t> key{cacheSubjectHash()};
+        for (size_t row = 0; row < start; ++row) {
+            recentKey = chainStepKey(row, recentKey);
+            if (key)
+                key = chainStepKey(row, *key);
+        }
+        bool stored{false};
+
         for (size_t row = start; row < rows; ++row) {
-            auto result = applyExpression(row, stepResults[row]);
+            std::optional<stepList> cached;
+            bool const active{isActiveFilter(row)};
+            recentKey = chainStepKey(row, recentKey);
+            if (key)
+                key = chainStepKey(row, *key);
+            if (active) {
+                cached = recentStep(row, recentKey);
+                if (!cached && key)
+                    cached = loadCachedStep(row, *key);
+            }
+            bool const computed{active && !cached};
+            QElapsedTimer timer;
+            timer.start();
+            auto result = cached ? std::move(*cached) : applyExpression(row, stepResults[row], true, filterMode::cancellable);
+            if (runCancelled)
+                break;
+            stepCosts[row+1] = !active ? 0 : computed ? timer.nsecsElapsed() : stepResults[row].size() * nominalLineNanos;
+            if (computed && !stepResults[row].empty())
+                rowLineNanos[row] = stepCosts[row+1] / stepResults[row].size();
+            recentStepKeys[row+1] = active ? recentKey : 0;
+            if (active && !recentSteps.contains(recentKey))
+                recentSteps.insert(recentKey, new stepList{result}, std::max(1, static_cast<int>(result.size())));
+            if (key && computed) {
+                storeCachedStep(*key, result);
+                stored = true;
+            }
             subjModified |= stepResults[row].size() != result.size();
             stepResults[row+1] = std::move(result);
+            /* Advanced per row, before events are handled: a streamed block
+             * appends its lines to the steps up to validSteps, so the rows
+             * already run must count as current. */
+            validSteps = row + 1;
             qApp->processEvents();
+            if (runCancelled)
+                break;
+        }
+        runInFlight = false;
+        if (runCancelled) {
+            /* Whatever cancelled the run has set pendingRun if it is to run again. */
+            runCancelled = false;
+            QGuiApplication::restoreOverrideCursor();
+            if (pendingRun != std::numeric_limits<size_t>::max())
+                autoRunTimer->start(0);
+            return;
         }
+        validSteps = rows;
         updateApplicationTitle();
+        collapseDuplicates();
         displayResult();
+        if (pendingCaretLine > 0 && !sourceLineMap.empty()) {
+            jumpToSourceLine(pendingCaretLine);
+            pendingCaretLine = 0;
+        }
+        updateHistogram();
+        enforceStepBudget();
+        if (stored)
+            workScheduler::instance().run(workLane::background, [cache = resultCache]() {cache.evict();});
         QGuiApplication::restoreOverrideCursor();
     } else
         qWarning() << QStringLiteral("No source entry %1/%2").arg(start).arg(stepResults.size());
 }
 
+auto mainWidget::cacheSubjectHash() -> std::optional<uint64_t>
+{
+    if (!subjectCacheable || !actionUseResultCache->isChecked() || subjectBlocks.size() != 1)
+        return std::nullopt;
+    if (!subjectHash) {
+        auto const& text = subjectBlocks.front().text;
+        subjectHash = subjectFingerprint(std::string_view{text.constData(), static_cast<size_t>(text.size())});
+    }
+    return subjectHash;
+}
+
+auto mainWidget::isActiveFilter(size_t row) const -> bool
+{
+    return row < static_cast<size_t>(filtersModel->rowCount()) && filtersModel->entry(static_cast<int>(row)).isActive();
+}
+
+auto mainWidget::chainStepKey(size_t row, uint64_t key) -> uint64_t
+{
+    if (!isActiveFilter(row))
+        return key;
+    return stepKey(key, filtersModel->entry(static_cast<int>(row)), actionDialect->currentText());
+}
+
+auto mainWidget::loadCachedStep(size_t row, uint64_t key) -> std::optional<stepList>
+{
+    auto const lines = resultCache.load(*subjectHash, key, static_cast<uint32_t>(sourceItems.size()));
+    if (!lines)
+        return std::nullopt;
+
+    stepList step;
+    step.reserve(static_cast<int>(lines->size()));
+    for (uint32_t const index : *lines)
+        step.push_back(&sourceItems[index]);
+    annotateCachedStep(row, step.size());
+    return step;
+}
+
+auto mainWidget::stepInput(size_t step) -> stepList const&
+{
+    /* A dropped step after editedRow would be rebuilt by the edited rows
+     * rather than the ones it was run with; it stays evicted until the next run. */
+    if (step < evictedSteps.size() && evictedSteps[step] && (!evictedSteps[step]->dropped || step <= editedRow)) {
+        evictedStep const evicted{std::move(*evictedSteps[step])};
+        evictedSteps[step].reset();
+        std::optional<std::vector<uint32_t>> lines;
+        if (!evicted.dropped)
+            lines = unpackLineIndexes(evicted.packed.constData(), static_cast<size_t>(evicted.packed.size()),
+                                      evicted.count, static_cast<uint32_t>(sourceItems.size()));
+        if (lines) {
+            stepList items;
+            items.reserve(static_cast<int>(lines->size()));
+            for (uint32_t const index : *lines)
+                items.push_back(&sourceItems[index]);
+            stepResults[step] = std::move(items);
+        } else
+            stepResults[step] = applyExpression(step - 1, stepInput(step - 1));
+    }
+    return stepResults[step];
+}
+
+void mainWidget::markRowsEdited(size_t row)
+{
+    editedRow = std::min(editedRow, row);
+    /* Rows above the pin, inserted, removed or edited, move or change its step. */
+    if (row < pinnedStep)
+        pinnedStep = 0;
+}
+
+void mainWidget::restoreEvictedSteps()
+{
+    for (size_t step = 1; step < evictedSteps.size() && step < stepResults.size(); ++step)
+        stepInput(step);
+}
+
+auto mainWidget::stepBytes(size_t step) const -> size_t
+{
+    if (evictedSteps[step])
+        return static_cast<size_t>(evictedSteps[step]->packed.size());
+
+    auto const& items = stepResults[step];
+    auto const shares = [&items](stepList const& other) {
+        return !items.empty() && items.constBegin() == other.constBegin();};
+    if (shares(stepResults.back()))
+        return 0;
+    for (size_t before = step; before-- > 0; ) {
+        if (!evictedSteps[before])
+            return shares(stepResults[before]) ? 0 : static_cast<size_t>(items.size()) * sizeof(textItem*);
+    }
+    return 0;
+}
+
+void mainWidget::evictStep(size_t step, bool drop)
+{
+    if (auto& evicted = evictedSteps[step]; evicted) {
+        if (drop && !evicted->dropped)
+            evicted = evictedStep{{}, 0, true};
+        return;
+    }
+
+    if (recentStepKeys[step] != 0)
+        recentSteps.remove(recentStepKeys[step]);
+    stepList const held{std::move(stepResults[step])};
+    stepResults[step] = stepList{};
+    if (drop)
+        evictedSteps[step] = evictedStep{{}, 0, true};
+    else {
+        std::vector<uint32_t> lines;
+        lines.reserve(static_cast<size_t>(held.size()));
+        int const first = firstSourceLine();
+        for (auto const item : held)
+            lines.push_back(static_cast<uint32_t>(item->srcLineNumber - first));
+        evictedStep packed{{}, static_cast<uint32_t>(lines.size()), false};
+        packLineIndexes(lines, packed.packed);
+        packed.packed.squeeze();
+        evictedSteps[step] = std::move(packed);
+    }
+
+    // Following steps that still share the evicted items go with them, up to the pinned step.
+    size_t const last = stepResults.size() - 1;
+    for (size_t next = step + 1; next < last && next != pinnedStep && !evictedSteps[next] && !held.empty()
+                                 && stepResults[next].constBegin() == held.constBegin(); ++next) {
+        stepResults[next] = stepList{};
+        evictedSteps[next] = evictedStep{{}, 0, true};
+    }
+}
+
+void mainWidget::enforceStepBudget()
+{
+    if (streamSource || stepResults.size() < 3 || evictedSteps.size() != stepResults.size())
+        return;
+
+    size_t const last = stepResults.size() - 1;
+    auto const budget = static_cast<size_t>(stepMemoryBudget) << 20;
+    auto const total = [this,last]() {
+        size_t bytes = 0;
+        for (size_t step = 1; step < last; ++step)
+            bytes += stepBytes(step);
+        return bytes;};
+
+    /* Pack the held steps, largest first. */
+    while (total() > budget) {
+        size_t largest = 0;
+        size_t largestBytes = 0;
+        for (size_t step = 1; step < last; ++step) {
+            if (size_t const bytes = stepBytes(step); step != pinnedStep && !evictedSteps[step] && bytes > largestBytes) {
+                largest = step;
+                largestBytes = bytes;
+            }
+        }
+        if (largest == 0)
+            break;
+        evictStep(largest, false);
+    }
+
+    /* Drop packed steps, cheapest to rebuild per byte first. Rebuilding filters
+     * from the nearest step kept, so dropping a step also makes those after it
+     * dearer; the costs are reckoned afresh each time. */
+    while (total() > budget) {
+        size_t cheapest = 0;
+        double cheapestCost = std::numeric_limits<double>::max();
+        qint64 dropped = 0;     // cost to rebuild the step before, if it is dropped
+        for (size_t step = 1; step < last; ++step) {
+            qint64 const rebuildCost = dropped + stepCosts[step];
+            bool const isDropped = evictedSteps[step] && evictedSteps[step]->dropped;
+            dropped = isDropped ? rebuildCost : 0;
+            if (step == pinnedStep || !evictedSteps[step] || isDropped)
+                continue;
+            if (double const cost = static_cast<double>(rebuildCost) / static_cast<double>(std::max<size_t>(stepBytes(step), 1));
+                cost < cheapestCost) {
+                cheapest = step;
+                cheapestCost = cost;
+            }
+        }
+        if (cheapest == 0)
+            break;
+        evictStep(cheapest, true);
+    }
+}
+
+void mainWidget::pinStep()
+{
+    auto const row = filtersTable->currentIndex().row();
+    if (row < 0 || validSteps <= static_cast<size_t>(row) || editedRow <= static_cast<size_t>(row)
+        || static_cast<size_t>(row) + 1 >= stepResults.size() || evictedSteps.size() != stepResults.size())
+        return;
+    if (streamSource || runInFlight) {
+        status->setText(i18n("Cannot pin a step while the filters are running or the source is streaming"));
+        return;
+    }
+
+    pinnedStep = static_cast<size_t>(row) + 1;
+    stepInput(pinnedStep);
+    for (size_t step = 1; step < pinnedStep; ++step)
+        evictStep(step, true);
+    status->setText(i18n("Pinned the result of row %1; earlier steps freed", row + 1));
+}
+
+void mainWidget::stepMemoryBudgetTriggered()
+{
+    bool ok{false};
+    int const budget = QInputDialog::getInt(this, i18n("Step Memory Budget"),
+                                            i18n("Memory for intermediate filter results, in MiB:"),
+                                            stepMemoryBudget, 16, 1 << 20, 256, &ok);
+    if (!ok)
+        return;
+    stepMemoryBudget = budget;
+    KConfigGroup generalConfig{KSharedConfig::openConfig(), generalConfigName};
+    generalConfig.writeEntry(QStringLiteral("stepMemoryBudget"), stepMemoryBudget);
+    enforceStepBudget();
+}
+
+auto mainWidget::recentStep(size_t row, uint64_t key) -> std::optional<stepList>
+{
+    auto const step = recentSteps.object(key);
+    if (!step)
+        return std::nullopt;
+    annotateCachedStep(row, step->size());
+    return *step;
+}
+
+void mainWidget::setRowToolTip(size_t row, QString const& toolTip) const
+{
+    if (row < static_cast<size_t>(filtersModel->rowCount()))
+        filtersModel->setToolTip(static_cast<int>(row), toolTip);
+}
+
+void mainWidget::lintFilterRow(int row)
+{
+    if (row < 0 || row >= filtersModel->rowCount())
+        return;
+    QString const text{filtersModel->entry(row).re};
+    if (text.isEmpty()) {
+        filtersModel->setLint(row, QString{}, false);
+        return;
+    }
+
+    patternLint const lint{lintPattern(text)};
+    filtersModel->setLint(row, (lint.warnings + lint.notes).join(QLatin1Char('\n')), !lint.warnings.isEmpty());
+    if (heldStepInput(static_cast<size_t>(row))
+        && std::find(lintPending.cbegin(), lintPending.cend(), row) == lintPending.cend()) {
+        lintPending.push_back(row);
+        if (!lintWatcher->isRunning())
+            startLintProbe();
+    }
+}
+
+auto mainWidget::heldStepInput(size_t step) const -> stepList const*
+{
+    if (step > validSteps || step > editedRow || step >= stepResults.size() || stepResults[step].isEmpty()
+        || (step < evictedSteps.size() && evictedSteps[step]))
+        return nullptr;
+    return &stepResults[step];
+}
+
+void mainWidget::startLintProbe()
+{
+    while (!lintPending.empty()) {
+        int const row = lintPending.front();
+        lintPending.pop_front();
+        stepList const* input = row < filtersModel->rowCount() ? heldStepInput(static_cast<size_t>(row)) : nullptr;
+        if (!input)
+            continue;
+
+        lintProbe probe{row, filtersModel->entry(row).re, filtersModel->entry(row).ignoreCase, false, 0, input->size()};
+        lintWatcher->setFuture(workScheduler::instance().run(workLane::interactive, [sample = *input, probe]() mutable {
+            /* Time the expression on a sample of its input. A line which reaches
+             * the backtracking limit is enough to know the expression is costly. */
+            utf8RegularExpression const re{probe.text, probe.ignoreCase};
+            if (!re.isValid())
+                return probe;
+            auto const indexes = stratifiedSample(static_cast<size_t>(sample.size()), lintProbeLines);
+            qint64 probed = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (size_t const index : indexes) {
+                if (!re.matchLimited(sample[static_cast<int>(index)]->text, lintMatchLimit)) {
+                    probe.limited = true;
+                    return probe;
+                }
+                ++probed;
+                if (timer.nsecsElapsed() > lintProbeNanos)
+                    break;
+            }
+            if (probed > 0)
+                probe.perLine = std::max<qint64>(timer.nsecsElapsed() / probed, 1);
+            return probe;}));
+        return;
+    }
+}
+
+void mainWidget::lintProbeFinished()
+{
+    lintProbe const probe{lintWatcher->result()};
+    startLintProbe();
+
+    /* The row may have been edited, or its input rerun, while it was probed. */
+    if (probe.row >= filtersModel->rowCount() || filtersModel->entry(probe.row).re != probe.text
+        || filtersModel->entry(probe.row).ignoreCase != probe.ignoreCase
+        || !heldStepInput(static_cast<size_t>(probe.row)))
+        return;
+
+    patternLint const lint{lintPattern(probe.text)};
+    QStringList findings{lint.warnings};
+    auto const step = static_cast<size_t>(probe.row);
+    if (probe.limited)
+        findings << i18n("A sampled line reached the backtracking limit; some lines may take very long to match");
+    else if (probe.perLine > 0) {
+        if (rowLineNanos.size() <= step)
+            rowLineNanos.resize(step + 1);
+        rowLineNanos[step] = probe.perLine;
+        int const threads = workScheduler::instance().pool(workLane::foreground)->maxThreadCount();
+        qint64 const estimate = probe.perLine * probe.lines / std::max(1, threads);
+        if (estimate > lintSlowNanos)
+            findings << i18n("Estimated to take %1 s on %2 lines", estimate / 1000000000, probe.lines);
+    }
+    findings << lint.notes;
+    filtersModel->setLint(probe.row, findings.join(QLatin1Char('\n')), findings.size() > lint.notes.size());
+}
+
+void mainWidget::clearLint()
+{
+    lintPending.clear();
+    lintWatcher->waitForFinished();
+}
+
+void mainWidget::queueLint(int first)
+{
+    bool const queued = lintQueuedFrom >= 0;
+    lintQueuedFrom = queued ? std::min(lintQueuedFrom, std::max(first, 0)) : std::max(first, 0);
+    if (!queued)
+        QMetaObject::invokeMethod(this, [this]() {
+            int const from = std::exchange(lintQueuedFrom, -1);
+            for (int row = from; row < filtersModel->rowCount(); ++row)
+                lintFilterRow(row);}, Qt::QueuedConnection);
+}
+
+void mainWidget::annotateCachedStep(size_t row, int count)
+{
+    setRowToolTip(row,
+        i18nc("@info:tooltip filter table entry when the result was taken from the cache", "%1 of %2 -- cached",
+              count, stepResults[row].size()));
+}
+
+void mainWidget::storeCachedStep(uint64_t key, stepList const& step)
+{
+    std::vector<uint32_t> lines;
+    lines.reserve(static_cast<size_t>(step.size()));
+    int const first = firstSourceLine();
+    for (auto const item : step)
+        lines.push_back(static_cast<uint32_t>(item->srcLineNumber - first));
+    /* Written in the background; a load before the write completes just misses. */
+    workScheduler::instance().run(workLane::background,
+        [cache = resultCache, subject = *subjectHash, key, sourceLines = static_cast<uint32_t>(sourceItems.size()),
+         lines = std::move(lines)]() {cache.store(subject, key, sourceLines, lines);});
+}
+
+void mainWidget::saveSubjectState()
+{
+    auto const subject = cacheSubjectHash();
+    if (!subject)
+        return;
+
+    QJsonArray bookmarks;
+    auto lineNums = bookmarkedLines.values();
+    std::sort(lineNums.begin(), lineNums.end());
+    int const first = firstSourceLine();
+    for (int const lineNo : qAsConst(lineNums)) {
+        if (auto const index = static_cast<size_t>(lineNo - first); index < sourceItems.size())
+            bookmarks.append(QJsonObject{{QStringLiteral("line"), lineNo},
+                                         {QStringLiteral("text"), sourceItems[index].bmText}});
+    }
+
+    QJsonObject state{{QStringLiteral("bookmarks"), bookmarks}};
+    if (auto const line = static_cast<size_t>(result->caretPosition().lineNumber()); line < sourceLineMap.size())
+        state.insert(QStringLiteral("caretLine"), sourceLineMap[line]);
+    resultCache.storeState(*subject, state);
+}
+
+void mainWidget::restoreSubjectState()
+{
+    auto const subject = cacheSubjectHash();
+    if (!subject)
+        return;
+
+    QJsonObject const state{resultCache.loadState(*subject)};
+    int const first = firstSourceLine();
+    for (auto const& value : state.value(QStringLiteral("bookmarks")).toArray()) {
+        QJsonObject const bookmark{value.toObject()};
+        int const lineNo = bookmark.value(QStringLiteral("line")).toInt();
+        if (auto const index = static_cast<size_t>(lineNo - first); index < sourceItems.size()) {
+            auto& item = sourceItems[index];
+            item.bookmarked = true;
+            item.bmText = bookmark.value(QStringLiteral("text")).toString();
+            bookmarkedLines.insert(lineNo);
+        }
+    }
+    updateBookmarkMenu();
+    pendingCaretLine = state.value(QStringLiteral("caretLine")).toInt();
+}
+
+void mainWidget::useResultCacheTriggered(bool checked)
+{
+    KConfigGroup generalConfig{KSharedConfig::openConfig(), generalConfigName};
+    generalConfig.writeEntry(QStringLiteral("useResultCache"), checked);
+}
+
+void mainWidget::clearResultCache()
+{
+    workScheduler::instance().pool(workLane::background)->waitForDone();
+    resultCache.clear();
+}
+
+void mainWidget::workQueueChanged()
+{
+    auto& scheduler = workScheduler::instance();
+    /* Filtering runs QtConcurrent algorithms on the foreground lane, which are
+     * not counted; only the lanes run() counts are shown. */
+    QStringList lanes;
+    for (auto const& [lane, name] : {std::pair{workLane::interactive, i18nc("@info work lane", "Interactive")},
+                                     std::pair{workLane::background, i18nc("@info work lane", "Background")}}) {
+        auto const m = scheduler.metrics(lane);
+        lanes << i18nc("@info:tooltip %1 is the name of a lane of work",
+                       "%1: %2 running, %3 queued, %4 done; %5 threads",
+                       name, m.active, m.queued, m.completed, m.threads);
+    }
+    auto const background = scheduler.metrics(workLane::background);
+    workLabel->setText(i18nc("@info:status", "Background tasks: %1", background.active + background.queued));
+    workLabel->setToolTip(lanes.join(QLatin1Char('\n')));
+    workLabel->setVisible(background.active + background.queued > 0);
+}
+
 auto mainWidget::validateExpressions(int entry) const -> bool
 {
-    auto table = filtersTable;
-    for (int const rows = table->rowCount(); entry < rows; ++entry) {
-        if (table->item(entry, ColEnable)->checkState() == Qt::Checked) {
-            auto* reItem = table->item(entry, ColRegEx);
-            auto const reStr = reItem->text();
-            if (!reStr.isEmpty()) {
-                QRegularExpression const re{reStr};
+    for (int const rows = filtersModel->rowCount(); entry < rows; ++entry) {
+        if (auto const& filter = filtersModel->entry(entry); filter.enabled) {
+            if (!filter.re.isEmpty()) {
+                utf8RegularExpression const re{filter.re, filter.ignoreCase};
                 if (!re.isValid()) {
                     status->setText(QStringLiteral("Invalid RE at %1: '%2'")
                             .arg(entry).arg(re.errorString()));
-                    table->setCurrentCell(entry, ColRegEx);
-                    reItem->setToolTip(status->text());
+                    filtersTable->setCurrentIndex(filtersModel->index(entry, ColRegEx));
+                    setRowToolTip(entry, status->text());
                     return false;
                 }
-                reItem->setToolTip(QString{});
+                setRowToolTip(entry, QString{});
             }
         }
     }
@@ -632,13 +1868,26 @@ void mainWidget::clearResultsAfter(size_t startIndex)
 {
     /* startIndex is zero based item rows. The items in the table start
      * at one, with zero being the header. */
-    int const rowLast{filtersTable->rowCount() + 1};
+    cancelRun(false);
+    int const rowLast{filtersModel->rowCount() + 1};
     stepResults.resize(rowLast);
+    evictedSteps.resize(rowLast);
+    stepCosts.resize(rowLast);
+    recentStepKeys.resize(rowLast);
     for (int rowNumber = startIndex + 1; rowNumber < rowLast; ++rowNumber) {
         stepResults[rowNumber].clear();
-        if (const auto item = filtersTable->item(rowNumber, ColRegEx); item)
-            item->setToolTip(QString{});
+        evictedSteps[rowNumber].reset();
+        setRowToolTip(rowNumber, QString{});
     }
+    validSteps = std::min(validSteps, startIndex);
+    if (startIndex < pinnedStep)
+        pinnedStep = 0;
+    if (rowSlowLines.size() > startIndex)
+        rowSlowLines.resize(startIndex);
+    resultTimeExtentKnown = false;
+    timeRange.reset();
+    histogram->clearSelection();
+    actionClearTimeRange->setEnabled(false);
     clearResults();
     status->clear();
 }
@@ -646,6 +1895,9 @@ void mainWidget::clearResultsAfter(size_t startIndex)
 void mainWidget::clearResults()
 {
     result->clear();
+    collapsedResult.clear();
+    collapsedCounts.clear();
+    maxCollapsedCount = 0;
     actionSaveResults->setEnabled(false);
     actionSaveResultsAs->setEnabled(false);
 }
@@ -653,35 +1905,32 @@ void mainWidget::clearResults()
 void mainWidget::displayResult()
 {
     size_t resultLines{0};
+    bool const collapsed{actionCollapseDuplicates->isChecked()};
 
-    if (!stepResults.empty() && !stepResults.back().empty()) {
-        stepList& items{stepResults.back()};
+    updateGutterWidth();
+    if (stepList const items{collapsed ? collapsedResult : finalItems()}; !items.empty()) {
         std::vector<int> lineMap(items.size());
-        auto mapIt{lineMap.begin()};
+        auto countIt{collapsedCounts.cbegin()};
+        auto const setBadge = [collapsed,&countIt](logTextItem& ltItem) {
+            if (collapsed) {
+                if (auto const count = *(countIt++); count > 1)
+                    ltItem.setBadge(count);
+            }};
         QSignalBlocker const disabler{result};
         result->clear();
         if (actionLineNumbers->isChecked()) {
             const int width{QStringLiteral("%1").arg(items.back()->srcLineNumber).size()};
             lineNoColCount = width + 2;         /* +2 for the '| ' separator */
-            rng::for_each(items, [this,width,&mapIt](auto const& item) {
-                auto ltItem = new resultTextItem{item,
-                    QStringLiteral("%1| %2").arg(item->srcLineNumber, width).arg(item->text),
-                    styleBase};
-                if (item->isBoomkmarked())
-                    ltItem->setPixmap(pixmapIdBookMark);
-                result->append(ltItem);
-                *(mapIt++) = item->srcLineNumber;});
-        } else {
+        } else
             lineNoColCount = 0;
-            rng::for_each(items, [this,&mapIt](auto const& item){
-                auto ltItem = new resultTextItem(item, item->text, styleBase);
-                if (item->isBoomkmarked())
-                    ltItem->setPixmap(pixmapIdBookMark);
-                result->append(ltItem);
-                *(mapIt++) = item->srcLineNumber;});
-        }
+        result->append(items | std::views::transform([this,&setBadge](textItem *item) {
+            auto ltItem = newResultItem(item);
+            setBadge(ltItem);
+            return ltItem;}));
+        rng::transform(items, lineMap.begin(), [](textItem const* item) {return item->srcLineNumber;});
         sourceLineMap = std::move(lineMap);
         resultLines = items.size();
+        updateFindMarkers();
     } else {
         result->clear();
         sourceLineMap.clear();
@@ -693,46 +1942,46 @@ void mainWidget::displayResult()
     status->setText(QStringLiteral("Source: %L1, final %L2 lines").arg(sourceLineCount).arg(resultLines));
 }
 
+auto mainWidget::newResultItem(textItem *item) const -> logTextItem
+{
+    /* The line number is as wide as the last line's, so the prefix is lineNoColCount wide. */
+    logTextItem ltItem{sourcedText{lineNoColCount + decodedLength(item->text)}, styleBase};
+    ltItem.setTag(reinterpret_cast<quintptr>(item));
+    if (item->isBoomkmarked()) {
+        ltItem.setPixmap(pixmapIdBookMark);
+        ltItem.setMarkers(1u << markerBookmark);
+    }
+    return ltItem;
+}
+
+auto mainWidget::resultText(textItem const* item) const -> QString
+{
+    return lineNoColCount == 0 ? item->decoded() :
+        QStringLiteral("%1| %2").arg(item->srcLineNumber, lineNoColCount - 2).arg(item->decoded());
+}
+
 void mainWidget::clearFilters()
 {
-    QSignalBlocker const blocker{filtersTable};
     filtersFileName.clear();
-    filtersTable->setRowCount(0);
+    filtersModel->setFilters({});
     appendEmptyRow();
 }
 
 void mainWidget::appendEmptyRow()
 {
-    insertEmptyRowAt(filtersTable->rowCount());
+    insertEmptyRowAt(filtersModel->rowCount());
 }
 
 void mainWidget::insertEmptyRowAt(int row)
 {
-    QSignalBlocker const blocker{filtersTable};
-    filtersTable->insertRow(row);
-    QTableWidgetItem *item{new QTableWidgetItem()};
-    item->setCheckState(Qt::Checked);
-    item->setFlags(item->flags() & ~(Qt::ItemIsEditable));
-    filtersTable->setItem(row, ColEnable, item);
-
-    item = new QTableWidgetItem();
-    item->setCheckState(Qt::Unchecked);
-    item->setFlags(item->flags() & ~(Qt::ItemIsEditable));
-    filtersTable->setItem(row, ColExclude, item);
-
-    item = new QTableWidgetItem();
-    item->setCheckState(Qt::Unchecked);
-    item->setFlags(item->flags() & ~(Qt::ItemIsEditable));
-    filtersTable->setItem(row, ColCaseIgnore, item);
-
-    item = new QTableWidgetItem();
-    filtersTable->setItem(row, ColRegEx, item);
-    filtersTable->setCurrentCell(row, ColRegEx);
+    filtersModel->insertRow(row);
+    markRowsEdited(static_cast<size_t>(row));
+    filtersTable->setCurrentIndex(filtersModel->index(row, ColRegEx));
 }
 
 void mainWidget::insertEmptyFilterAbove()
 {
-    if (auto const row = filtersTable->currentRow(); row >= 0 && row < filtersTable->rowCount()) {
+    if (auto const row = filtersTable->currentIndex().row(); row >= 0 && row < filtersModel->rowCount()) {
         insertEmptyRowAt(row);
         maybeAutoApply(row);
     }
@@ -740,19 +1989,18 @@ void mainWidget::insertEmptyFilterAbove()
 
 void mainWidget::deleteFilterRow()
 {
-    if (auto const row = filtersTable->currentRow(); row >= 0 && row < filtersTable->rowCount()) {
-        QSignalBlocker blocker{filtersTable};
-        filtersTable->removeRow(row);
-        if (filtersTable->rowCount() == 0)
+    if (auto const row = filtersTable->currentIndex().row(); row >= 0 && row < filtersModel->rowCount()) {
+        filtersModel->removeRow(row);
+        markRowsEdited(static_cast<size_t>(row));
+        if (filtersModel->rowCount() == 0)
             appendEmptyRow();
-        blocker.unblock();
         maybeAutoApply(row);
     }
 }
 
 void mainWidget::clearFilterRow()
 {
-    if (auto const row = filtersTable->currentRow(); row >= 0 && row < filtersTable->rowCount()) {
+    if (auto const row = filtersTable->currentIndex().row(); row >= 0 && row < filtersModel->rowCount()) {
         setFilterRow(row, filterEntry());
         maybeAutoApply(row);
     }
@@ -760,33 +2008,68 @@ void mainWidget::clearFilterRow()
 
 void mainWidget::moveFilterUp()
 {
-    if (auto const row = filtersTable->currentRow(); row > 0 && row <= filtersTable->rowCount())
+    if (auto const row = filtersTable->currentIndex().row(); row > 0 && row <= filtersModel->rowCount())
         swapFiltersRows(row, row - 1);
 }
 
 void mainWidget::moveFilterDown()
 {
-    if (auto const row = filtersTable->currentRow(); row >= 0 && row < filtersTable->rowCount())
+    if (auto const row = filtersTable->currentIndex().row(); row >= 0 && row + 1 < filtersModel->rowCount())
         swapFiltersRows(row, row + 1);
 }
 
 auto mainWidget::getFilterRow(int row) -> filterEntry
 {
-    filterEntry entry;
-    entry.enabled = filtersTable->item(row, ColEnable)->checkState() == Qt::Checked;
-    entry.exclude = filtersTable->item(row, ColExclude)->checkState() == Qt::Checked;
-    entry.ignoreCase = filtersTable->item(row, ColCaseIgnore)->checkState() == Qt::Checked;
-    entry.re = filtersTable->item(row, ColRegEx)->text();
-    return entry;
+    return filtersModel->entry(row);
 }
 
 void mainWidget::setFilterRow(int row, filterEntry const& entry)
 {
-    QSignalBlocker const blocker{filtersTable};
-    filtersTable->item(row, ColEnable)->setCheckState(entry.enabled ? Qt::Checked : Qt::Unchecked);
-    filtersTable->item(row, ColExclude)->setCheckState(entry.exclude ? Qt::Checked : Qt::Unchecked);
-    filtersTable->item(row, ColCaseIgnore)->setCheckState(entry.ignoreCase ? Qt::Checked : Qt::Unchecked);
-    filtersTable->item(row, ColRegEx)->setText(entry.re);
+    filtersModel->setEntry(row, entry);
+    markRowsEdited(static_cast<size_t>(row));
+    lintFilterRow(row);
+}
+
+auto mainWidget::filterRows() -> QList<filterEntry>
+{
+    return filtersModel->filters();
+}
+
+void mainWidget::setFilterRows(QList<filterEntry> const& filters)
+{
+    /* Re-run from the first row that differs; the rows before it keep their results. */
+    QList<filterEntry> const current{filterRows()};
+    int firstChanged = 0;
+    while (firstChanged < current.size() && firstChanged < filters.size() && current[firstChanged] == filters[firstChanged])
+        ++firstChanged;
+
+    filtersModel->setFilters(filters);
+    markRowsEdited(static_cast<size_t>(firstChanged));
+    queueLint(0);
+    if (filters.empty())
+        appendEmptyRow();
+    filtersTable->setCurrentIndex(filtersModel->index(std::min(firstChanged, filtersModel->rowCount() - 1), ColRegEx));
+    recordedFilters = filterRows();
+    maybeAutoApply(firstChanged);
+}
+
+void mainWidget::filtersEdited()
+{
+    if (!filtersEditQueued) {
+        filtersEditQueued = true;
+        QMetaObject::invokeMethod(this, [this](){recordFiltersEdit();}, Qt::QueuedConnection);
+    }
+}
+
+void mainWidget::recordFiltersEdit()
+{
+    filtersEditQueued = false;
+    QList<filterEntry> current{filterRows()};
+    if (current == recordedFilters)
+        return;
+    filtersUndo->push(new filtersEditCommand{recordedFilters, current,
+                                             [this](QList<filterEntry> const& filters) {setFilterRows(filters);}});
+    recordedFilters = std::move(current);
 }
 
 void mainWidget::swapFiltersRows(int a, int b)
@@ -811,37 +2094,36 @@ void mainWidget::dialectChanged([[maybe_unused]] QString const& text)
 }
 
 
-void mainWidget::tableItemChanged(QTableWidgetItem *item)
+void mainWidget::filterEntryEdited(int row, int column)
 {
-    QSignalBlocker const blocker{filtersTable};
     status->clear();
-    auto tbl = filtersTable;
-    if (item->column() == ColRegEx) {
-        int lastRow = tbl->rowCount() - 1;
-        if (item->text().isEmpty()) {
-            if (item->row() == (lastRow - 1) && tbl->item(lastRow, ColRegEx)->text().isEmpty())
-                tbl->removeRow(lastRow);
+    markRowsEdited(static_cast<size_t>(row));
+    if (column == ColRegEx) {
+        int lastRow = filtersModel->rowCount() - 1;
+        QString const text{filtersModel->entry(row).re};
+        if (text.isEmpty()) {
+            if (row == (lastRow - 1) && filtersModel->entry(lastRow).re.isEmpty())
+                filtersModel->removeRow(lastRow);
         } else {
-            QRegularExpression re(item->text());
+            utf8RegularExpression const re{text, filtersModel->entry(row).ignoreCase};
             if (re.isValid()) {
-                item->setForeground(QBrush());
-                item->setToolTip(QString());
-                item->setIcon(QIcon());
-                maybeAutoApply(item->row());
+                filtersModel->setError(row, QString{});
+                lintFilterRow(row);
+                setRowToolTip(static_cast<size_t>(row), QString{});
+                maybeAutoApply(row);
             } else {
-                clearResultsAfter(item->row());
+                clearResultsAfter(row);
                 status->setText(QStringLiteral("<span style=\"color:red;\">bad RE: '%1'</span>").arg(re.errorString()));
-                QBrush brush = item->foreground();
-                brush.setColor(Qt::red);
-                item->setForeground(brush);
-                item->setToolTip(re.errorString());
-                item->setIcon(QIcon::fromTheme(QStringLiteral("error")));
+                filtersModel->setError(row, re.errorString());
             }
-            if (item->row() == lastRow)
+            if (row == lastRow)
                 appendEmptyRow();
         }
-    } else
-        maybeAutoApply(item->row());
+    } else {
+        if (column == ColCaseIgnore)
+            lintFilterRow(row);
+        maybeAutoApply(row);
+    }
 }
 
 
@@ -853,17 +2135,17 @@ QString mainWidget::getFilterFile()
 
 void mainWidget::insertFiltersAbove()
 {
-    auto const row = filtersTable->currentRow();
-    if (row < 0 || row >= filtersTable->rowCount())
+    auto const current = filtersTable->currentIndex();
+    auto const row = current.row();
+    if (row < 0 || row >= filtersModel->rowCount())
         return;
 
     QString const fileName = getFilterFile();
     if (!fileName.isEmpty()) {
         filterData const filters{loadFiltersFile(fileName)};
         if (filters.valid) {
-            QSignalBlocker const blocker{filtersTable};
             insertFiltersAt(row, filters);
-            filtersTable->setCurrentCell(row, filtersTable->currentColumn());
+            filtersTable->setCurrentIndex(filtersModel->index(row, current.column()));
             maybeAutoApply(row);
         }
     }
@@ -891,8 +2173,7 @@ auto mainWidget::loadFiltersTable(const QString& fileName) -> bool
 auto mainWidget::loadFiltersTable(const filterData& filters) -> bool
 {
     if (filters.valid) {
-        QSignalBlocker const blocker{filtersTable};
-        filtersTable->setRowCount(0);
+        filtersModel->setFilters({});
         insertFiltersAt(0, filters);
         appendEmptyRow();
         maybeAutoApply(0);
@@ -930,11 +2211,10 @@ void mainWidget::insertFiltersAt(int at, const filterData& fData)
     if (!fData.dialect.isEmpty())
         actionDialect->setCurrentAction(fData.dialect);
 
-    for (const auto& entry : qAsConst(fData.filters)) {
-        insertEmptyRowAt(at);
-        setFilterRow(at, entry);
-        ++at;
-    }
+    /* One insertion for all rows, rather than a row at a time. */
+    filtersModel->insertFilters(at, fData.filters);
+    markRowsEdited(static_cast<size_t>(std::max(at, 0)));
+    queueLint(at);
 }
 
 void mainWidget::saveFilters()
@@ -962,13 +2242,10 @@ auto mainWidget::doSaveFilters(const QString& fileName) -> bool
 {
     QFile dest(fileName);
     if (dest.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        int const rows = filtersTable->rowCount();
         QJsonArray filterArray;
-        for (int row = 0; row < rows; ++row) {
-            if (!filtersTable->item(row, ColRegEx)->text().isEmpty()) {
-                filterEntry const filter = getFilterRow(row);
+        for (auto const& filter : filtersModel->filters()) {
+            if (!filter.re.isEmpty())
                 filterArray.append(filter.toJson());
-            }
         }
         const KAboutData& app = KAboutData::applicationData();
         QJsonObject about;
@@ -994,36 +2271,44 @@ void mainWidget::toggleBookmark()
     auto const lineNumber = result->caretPosition().lineNumber();      /*!< line number in results */
     if (lineNumber > result->lineCount())   /* shouldn't happen, but be safe */
         return;
-    auto sourceItem = resultTextItem::asResultTextItem(result->item(lineNumber))->sourceItem();
+    auto sourceItem = resultSource(result->item(lineNumber));
     if (!sourceItem->bookmarked) {
         sourceItem->bookmarked = true;
-        QString const& sourceText = sourceItem->text;
+        QString const sourceText = sourceItem->decoded();
         if (auto sel = result->getSelection().normalized(); sel.singleLine()) {
             sel += cell{0, -lineNoColCount};
             auto [start, end] = sel;
-            sourceItem->bmText = sourceText.midRef(
+            sourceItem->bmText = sourceText.mid(
                 start.columnNumber(), end.columnNumber() - start.columnNumber());
         } else
-            sourceItem->bmText = sourceText.leftRef(40);
+            sourceItem->bmText = sourceText.left(40);
         bookmarkedLines.insert(sourceItem->srcLineNumber);
         result->setLinePixmap(lineNumber, pixmapIdBookMark);
+        result->setLineMarkers(lineNumber, static_cast<markerMask_t>(result->lineMarkers(lineNumber) | (1u << markerBookmark)));
     } else {
         sourceItem->bookmarked = false;
         bookmarkedLines.remove(sourceItem->srcLineNumber);
         result->clearLinePixmap(lineNumber);
+        result->setLineMarkers(lineNumber, static_cast<markerMask_t>(result->lineMarkers(lineNumber) & ~(1u << markerBookmark)));
     }
 
+    updateBookmarkMenu();
+    saveSubjectState();
+}
+
+void mainWidget::updateBookmarkMenu()
+{
     auto lineNums = bookmarkedLines.values();
     std::sort(lineNums.begin(), lineNums.end());
     QStringList bms;
     bmLineNums.clear();
-    bmLineNums.reserve(bmLineNums.size());
-    bms.reserve(bmLineNums.size());
+    bmLineNums.reserve(lineNums.size());
+    bms.reserve(lineNums.size());
 
     auto const& items = stepResults[0];
+    int const first = firstSourceLine();
     for(lineNumber_t lineNo : lineNums) {
-        if (lineNo < items.size()) [[likely]] {/* should always be true, but check */
-            auto const srcIdx = std::max(0, lineNo - 1);
+        if (auto const srcIdx = lineNo - first; srcIdx >= 0 && srcIdx < items.size()) [[likely]] {/* should always be true, but check */
             bms.push_back(QStringLiteral("%1: %2").arg(lineNo).arg(items[srcIdx]->bmText));
             bmLineNums.push_back(lineNo);
         } else
@@ -1032,12 +2317,289 @@ void mainWidget::toggleBookmark()
     actionBookmarkMenu->setItems(bms);
 }
 
+auto mainWidget::finalItems() const -> stepList
+{
+    if (stepResults.empty())
+        return {};
+    if (!timeRange)
+        return stepResults.back();
+    auto const [first, last] = *timeRange;
+    return stepResults.back().mid(first, last - first);
+}
+
+void mainWidget::updateHistogram()
+{
+    if (!actionShowHistogram->isChecked())
+        return;
+
+    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    if (sourceTimes.empty() && !sourceItems.empty())
+        sourceTimes = lineTimestamps(sourceItems.size(), [this](size_t n) {return sourceItems[n].text;});
+
+    /* The histogram covers the whole final step; a selected range is within it. */
+    static stepList const noItems;
+    stepList const& items{stepResults.empty() ? noItems : stepResults.back()};
+    auto const count = static_cast<size_t>(items.size());
+    int const first = firstSourceLine();
+    auto const timeOf = [this,&items,first](size_t n) {
+        return sourceTimes[static_cast<size_t>(items[static_cast<int>(n)]->srcLineNumber - first)];};
+    if (!resultTimeExtentKnown) {
+        resultTimeExtent = sourceTimes.empty() ? std::nullopt : timeExtent(count, timeOf);
+        resultTimeExtentKnown = true;
+    }
+
+    timeBuckets buckets;
+    if (resultTimeExtent)
+        buckets = bucketLines(count, timeOf, *resultTimeExtent, bucketWidthCombo->currentData().toLongLong());
+    histogram->setBuckets(std::move(buckets));
+    QGuiApplication::restoreOverrideCursor();
+}
+
+void mainWidget::showHistogramTriggered(bool checked)
+{
+    KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
+    resultsConfig.writeEntry(QStringLiteral("showTimeHistogram"), checked);
+    histogramPanel->setVisible(checked);
+    if (checked)
+        updateHistogram();
+    else if (timeRange)
+        clearTimeRange();
+}
+
+void mainWidget::bucketWidthChanged(int index)
+{
+    KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
+    resultsConfig.writeEntry(QStringLiteral("histogramBucketWidth"), index);
+    if (timeRange)
+        clearTimeRange();
+    updateHistogram();
+}
+
+void mainWidget::timeRangeSelected(int firstBucket, int lastBucket)
+{
+    auto const& ranges = histogram->buckets().ranges;
+    size_t first{std::numeric_limits<size_t>::max()};
+    size_t last{0};
+    for (int bucket = std::max(firstBucket, 0); bucket <= lastBucket && std::cmp_less(bucket, ranges.size()); ++bucket) {
+        if (auto const& range = ranges[static_cast<size_t>(bucket)]; range.second > range.first) {
+            first = std::min(first, range.first);
+            last = std::max(last, range.second);
+        }
+    }
+    if (first >= last) {
+        clearTimeRange();
+        return;
+    }
+
+    /* Lines are narrowed by index range, so no filter is re-run. Lines of other
+     * buckets within the range, from out of order time stamps, are included. */
+    timeRange = {static_cast<int>(first), static_cast<int>(last)};
+    actionClearTimeRange->setEnabled(true);
+    collapseDuplicates();
+    displayResult();
+}
+
+void mainWidget::clearTimeRange()
+{
+    histogram->clearSelection();
+    actionClearTimeRange->setEnabled(false);
+    if (timeRange) {
+        timeRange.reset();
+        collapseDuplicates();
+        displayResult();
+    }
+}
+
+void mainWidget::wrapLinesTriggered(bool checked)
+{
+    KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
+    resultsConfig.writeEntry(QStringLiteral("wrapLines"), checked);
+    result->setWrapLines(checked);
+}
+
+void mainWidget::showMinimapTriggered(bool checked)
+{
+    KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
+    resultsConfig.writeEntry(QStringLiteral("showMinimap"), checked);
+    result->setMinimapVisible(checked);
+    if (checked)
+        updateFindMarkers();
+}
+
+void mainWidget::markResultLines(int channel, std::function<bool(logTextItemView const&)> const& matches)
+{
+    auto const count = static_cast<size_t>(result->lineCount());
+    std::vector<char> hits(count);
+    /* Find and the minimap are waited on by the user, so scan on the interactive lane. */
+    parallelChunks(workScheduler::instance().pool(workLane::interactive), count,
+                   [this,&hits,&matches](size_t first, size_t last) {
+        for (size_t n = first; n < last; ++n)
+            hits[n] = matches(result->item(static_cast<lineNumber_t>(n)));});
+
+    std::vector<lineNumber_t> lines;
+    for (size_t n = 0; n < count; ++n) {
+        if (hits[n])
+            lines.push_back(static_cast<lineNumber_t>(n));
+    }
+    result->setChannelMarkers(channel, lines);
+}
+
+auto mainWidget::findHitMatcher() const -> std::function<bool(QStringView)>
+{
+    if (lastFoundText.isEmpty())
+        return {};
+
+    if (findOptions & KFind::RegularExpression) {
+        QRegularExpression re{lastFoundText};
+        if (!(findOptions & KFind::CaseSensitive))
+            re.setPatternOptions(re.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+        if (!re.isValid())
+            return {};
+        re.optimize();
+        return [re](QStringView text) {
+            return re.match(QString::fromRawData(text.data(), static_cast<int>(text.size()))).hasMatch();};
+    }
+    auto const sensitivity = (findOptions & KFind::CaseSensitive) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    return [found = lastFoundText, sensitivity](QStringView text) {return text.contains(found, sensitivity);};
+}
+
+void mainWidget::updateFindMarkers()
+{
+    if (!result->minimapVisible())
+        return;
+    if (auto const matches = findHitMatcher(); !matches)
+        result->setChannelMarkers(markerFindHit, {});
+    else
+        markResultLines(markerFindHit, [&matches](logTextItemView const& item) {return matches(item.text());});
+}
+
 void mainWidget::actionLineNumbersTriggerd(bool checked)
 {
     KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
     resultsConfig.writeEntry(QStringLiteral("showLineNumbers"), checked);
 }
 
+void mainWidget::showTemplates()
+{
+    stepList const items{finalItems()};
+    if (items.empty()) {
+        status->setText(i18n("No results to group"));
+        return;
+    }
+
+    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    auto const templates = clusterTemplates(static_cast<size_t>(items.size()), [&items](size_t n) {
+        return items[static_cast<int>(n)]->decoded();});
+    std::vector<templateSample> samples;
+    samples.reserve(templates.size());
+    for (auto const& templ : templates) {
+        auto const item = items[static_cast<int>(templ.firstIndex)];
+        samples.push_back({item->srcLineNumber, item->decoded()});
+    }
+    auto dialog = new templatesDialog(templates, samples, this);
+    QGuiApplication::restoreOverrideCursor();
+
+    connect(dialog, SIGNAL(templateActivated(QString const&)), this, SLOT(addTemplateFilter(QString const&)));
+    status->setText(i18n("%1 templates in %2 lines", templates.size(), items.size()));
+    dialog->show();
+}
+
+void mainWidget::showSlowLines()
+{
+    int const row = filtersTable->currentIndex().row();
+    if (row < 0 || row >= filtersModel->rowCount() || static_cast<size_t>(row) >= rowSlowLines.size()
+        || rowSlowLines[row].empty()) {
+        status->setText(i18n("No slow lines of this row; set \"Profile Slow Lines\" and run the filters"));
+        return;
+    }
+
+    auto const& lines = rowSlowLines[row];
+    QStringList texts;
+    int const first = firstSourceLine();
+    for (auto const& line : lines) {
+        auto const index = static_cast<size_t>(line.srcLineNumber - first);
+        texts << (line.srcLineNumber >= first && index < sourceItems.size() ? sourceItems[index].decoded() : QString{});
+    }
+    auto dialog = new slowLinesDialog(filtersModel->entry(row).re, lines, texts, this);
+    connect(dialog, SIGNAL(lineActivated(int)), this, SLOT(jumpToSourceLine(int)));
+    dialog->show();
+}
+
+void mainWidget::addTemplateFilter(QString const& re)
+{
+    /* Reuse a trailing empty row, rather than leaving it between the filters */
+    int row{filtersModel->rowCount() - 1};
+    if (row < 0 || !filtersModel->entry(row).re.isEmpty()) {
+        appendEmptyRow();
+        row = filtersModel->rowCount() - 1;
+    }
+    filterEntry entry;
+    entry.enabled = true;
+    entry.re = re;
+    setFilterRow(row, entry);
+    filtersTable->setCurrentIndex(filtersModel->index(row, ColRegEx));
+    applyFrom(row);
+}
+
+void mainWidget::collapseDuplicatesChanged()
+{
+    KConfigGroup resultsConfig{KSharedConfig::openConfig(), resultsConfigName};
+    resultsConfig.writeEntry(QStringLiteral("collapseDuplicates"), actionCollapseDuplicates->isChecked());
+    resultsConfig.writeEntry(QStringLiteral("collapseMaskTimestamp"), actionCollapseMaskTime->isChecked());
+    actionCollapseMaskTime->setEnabled(actionCollapseDuplicates->isChecked());
+
+    /* Only the final step is affected, so there is no need to re-run the filters. */
+    if (!stepResults.empty() && !stepResults.back().empty()) {
+        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        collapseDuplicates();
+        displayResult();
+        QGuiApplication::restoreOverrideCursor();
+    }
+}
+
+void mainWidget::collapseDuplicates()
+{
+    collapsedResult.clear();
+    collapsedCounts.clear();
+    maxCollapsedCount = 0;
+    if (!actionCollapseDuplicates->isChecked() || stepResults.empty())
+        return;
+
+    stepList const items{finalItems()};
+    size_t const count = items.size();
+    bool const maskTime{actionCollapseMaskTime->isChecked()};
+    auto const keyText = [maskTime](textItem const *item) {
+        std::string_view const text{item->text};
+        return maskTime ? text.substr(timestampLength(text)) : text;};
+
+    /* Hashing is the bulk of the work and is independent per line. */
+    std::vector<uint64_t> hashes(count);
+    parallelChunks(count, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            auto const text = keyText(items[i]);
+            hashes[i] = hash64(text.data(), text.size());
+        }});
+
+    /* Group in line order, so each group is represented by its first occurrence. Lines
+     * with equal hashes are compared, as a collision must not merge distinct lines. */
+    std::unordered_multimap<uint64_t, size_t> groups;
+    groups.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto const text = keyText(items[i]);
+        auto [it, end] = groups.equal_range(hashes[i]);
+        for (; it != end; ++it) {
+            if (keyText(collapsedResult[it->second]) == text)
+                break;
+        }
+        if (it == end) {
+            groups.emplace(hashes[i], collapsedResult.size());
+            collapsedResult.append(items[i]);
+            collapsedCounts.push_back(1);
+        } else
+            maxCollapsedCount = std::max(maxCollapsedCount, ++collapsedCounts[it->second]);
+    }
+}
+
 void mainWidget::gotoLine()
 {
     if (sourceLineMap.empty())
@@ -1089,6 +2651,7 @@ void mainWidget::resultFind()
         resultsConfig.writeEntry(QStringLiteral("findHistory"), findHistory);
 
         findOptions = findDlg.options();
+        updateFindMarkers();
         doResultFind(findOptions);
     }
 }
@@ -1132,11 +2695,24 @@ void mainWidget::saveResultAs()
             resultFileName = localFile;
 }
 
+void mainWidget::saveSelectionAs()
+{
+    if (!result->hasSelectedText())
+        return;
+    QString const localFile = QFileDialog::getSaveFileName(this,
+                i18nc("@title:window title of save to file dialog", "Save Selection To"));
+    if (localFile.isEmpty())
+        return;
+    QFile dest(localFile);
+    if (!dest.open(QIODevice::WriteOnly | QIODevice::Text) || !result->writeSelectedText(dest))
+        QMessageBox::critical(this, i18n("Save Failure"),
+                              i18n("Could not save the selection to %1: %2", localFile, dest.errorString()));
+}
+
 auto mainWidget::doSaveResult(const QString& fileName) -> bool
 {
     QFile dest(fileName);
-    bool const saved = dest.open(QIODevice::WriteOnly | QIODevice::Text) &&
-           dest.write(result->toPlainText().toLatin1()) >= 0;
+    bool const saved = dest.open(QIODevice::WriteOnly | QIODevice::Text) && result->writeText(dest);
     subjModified = !saved;
     if (saved) {
         titleFile = QFileInfo(fileName).fileName();
@@ -1147,11 +2723,11 @@ auto mainWidget::doSaveResult(const QString& fileName) -> bool
 
 void mainWidget::filtersTableMenuRequested(QPoint point)
 {
-    int const row = filtersTable->currentRow();
-    if (row < 0 || row >= filtersTable->rowCount())
+    int const row = filtersTable->currentIndex().row();
+    if (row < 0 || row >= filtersModel->rowCount())
         return;
     actionMoveFilterUp->setEnabled(row > 0);
-    actionMoveFilterDown->setEnabled(row < filtersTable->rowCount()-1);
+    actionMoveFilterDown->setEnabled(row < filtersModel->rowCount()-1);
     filtersTableMenu->exec(filtersTable->mapToGlobal(point));
 }
 
@@ -1162,12 +2738,13 @@ void mainWidget::resultContextClick(lineNumber_t lineNo, QPoint pos, [[maybe_unu
 
     bool const hasSelectedText = result->hasSelectedText();
     actionCopySelection->setEnabled(hasSelectedText);
+    actionSaveSelectionAs->setEnabled(hasSelectedText);
     actionClearSelection->setEnabled(hasSelectedText);
 
     auto const lineNumber = result->caretPosition().lineNumber();      /*!< line number in results */
     if (lineNumber > result->lineCount())   /* shouldn't happen, but be safe */
         return;
-    auto const sourceItem = resultTextItem::asResultTextItem(result->item(lineNumber))->sourceItem();
+    auto const sourceItem = resultSource(result->item(lineNumber));
     if (sourceItem->bookmarked) {
         actionToggleBookmark->setText(i18nc("@action:inmenu remove bookmark", "Clear bookmark"));
         actionToggleBookmark->setToolTip(i18nc("@info:tooltip remove bookmark", "Remove the bookmark on the current line."));
@@ -1195,7 +2772,16 @@ void mainWidget::fontMetricsChanged(int lineHeight, [[maybe_unused]] int charWid
     QPixmap pmA = pixBmAnnotation.scaledToHeight(lineHeight);
     auto pmAWidth = pmA.width();
     result->setPixmap(pixmapIdAnnotation, std::move(pmA));
-    result->setGutter(std::max(pmUWidth, pmAWidth));
+    gutterPixmapWidth = std::max(pmUWidth, pmAWidth);
+    updateGutterWidth();
+}
+
+void mainWidget::updateGutterWidth()
+{
+    int width{gutterPixmapWidth};
+    if (actionCollapseDuplicates->isChecked() && maxCollapsedCount > 1)
+        width = std::max(width, result->fontMetrics().horizontalAdvance(QString::number(maxCollapsedCount)) + 2);
+    result->setGutter(width);
 }
 
 void mainWidget::selectFilterFont()
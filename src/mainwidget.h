@@ -18,66 +18,72 @@
 #define MAINWIDGET_H
 
 #include <QApplication>
+#include <QCache>
 #include <QDialog>
 #include <QFile>
+#include <QFuture>
 #include <QGroupBox>
 #include <QHeaderView>
+#include <QPointer>
 #include <QPlainTextEdit>
 #include <QScopedPointer>
 #include <QSplitter>
 #include <QStringList>
-#include <QTableWidget>
+#include <QTableView>
 #include <QVBoxLayout>
 #include <QVariant>
 #include <QWidget>
 
 #include <KFind>
 
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "filtermodel.h"
+#include "slowlines.h"
+#include "stepcache.h"
 #include "wlogtext.h"
 
 class QCheckBox;
+class QComboBox;
 class QLabel;
 class QMenu;
-class QTableWidgetItem;
+class QThread;
+class QTimer;
+class QUndoStack;
+template <typename T> class QFutureWatcher;
 class KXmlGuiWindow;
 class KRecentFilesAction;
 class KSelectAction;
+class streamReader;
+class timeHistogram;
 struct commandLineOptions;
 
-struct filterEntry {
-    bool enabled = false;
-    bool exclude = false;
-    bool ignoreCase = false;
-    QString re;
-
-    QJsonObject toJson() const;
-    static auto fromJson(const QJsonObject& jentry) -> filterEntry;
-};
-
-struct filterData {
-    bool valid = false;
-    QString dialect;
-    QList<filterEntry> filters;
-};
-
 struct textItem {
     int srcLineNumber = 0;
     bool bookmarked = false;
-    QString text;
-    QStringRef bmText;
+    std::string_view text;      //!< UTF-8 line text, within a subject block
+    QString bmText;
 
-    textItem(int lineNo, QString const& txt) : srcLineNumber{lineNo}, text{txt} {}
-    textItem(int lineNo, QString&& txt) noexcept : srcLineNumber{lineNo}, text{std::move(txt)} {}
+    textItem(int lineNo, std::string_view txt) noexcept : srcLineNumber{lineNo}, text{txt} {}
     textItem(textItem const&) = default;
     textItem(textItem&&) noexcept = default;
     auto operator=(textItem const&) -> textItem& = default;
     auto operator=(textItem&&) noexcept -> textItem& = default;
 
     auto isBoomkmarked() const {return bookmarked;}
+
+    /** @return the line text, decoded for display */
+    auto decoded() const -> QString {return QString::fromUtf8(text.data(), static_cast<int>(text.size()));}
 };
-using itemsList = std::vector<textItem>;
+/** Source items; a deque, so lines streamed in are appended, and trimmed from
+ * the front, without moving the other items. */
+using itemsList = std::deque<textItem>;
 using stepList = QList<textItem*>;
 
 class mainWidget : public QWidget {
@@ -85,54 +91,62 @@ class mainWidget : public QWidget {
     Q_OBJECT
 
 private:
-    /** Constants for column addressing */
-    enum {ColEnable = 0, ColExclude, ColCaseIgnore, ColRegEx, NumCol};
+    /** Constants for column addressing, those of filterModel */
+    enum {ColEnable = filterModel::ColEnable, ColExclude = filterModel::ColExclude,
+          ColCaseIgnore = filterModel::ColCaseIgnore, ColRegEx = filterModel::ColRegEx, NumCol = filterModel::NumCol};
     /** Pixmap ID values */
     enum : pixmapId_t {pixmapIdBookMark = 0, pixmapIdAnnotation = 1};
     /** style IDs */
     enum : styleId_t {styleBase = 0};
-
-    class resultTextItem : public logTextItem {
-    private:
-        textItem* const srcItem;
-
-    public:
-        resultTextItem(textItem* item, const QString& text, styleId_t styleNo = styleBase) :
-                logTextItem{text, styleNo}, srcItem{item} {}
-
-        resultTextItem(textItem* item, QString&& text, styleId_t styleNo = styleBase) :
-                logTextItem{text, styleNo}, srcItem{item} {}
-
-        resultTextItem(resultTextItem const&) = default;
-        resultTextItem(resultTextItem&&) = default;
-
-        static auto asResultTextItem(logTextItem* item) -> resultTextItem* {
-            return static_cast<resultTextItem *>(item);}
-        static auto asResultTextItem(logTextItem const* item) -> resultTextItem const* {
-            return static_cast<resultTextItem const*>(item);}
-
-        auto sourceItem() const {return srcItem;}
+    /** How applyExpression() filters the lines of a step */
+    enum class filterMode {
+        blocking,               //!< filter all lines, returning when done
+        cancellable,            //!< filter in the background, handling events, until the run is cancelled
     };
+    /** minimap marker channels */
+    enum : int {markerBookmark = 0, markerFindHit};
+
+    /**
+     * @brief source item of a result line
+     * @param line result line, appended from newResultItem()
+     * @return the final step item the line displays, from the line's tag
+     */
+    static auto resultSource(logTextItemView const& line) -> textItem* {
+        return reinterpret_cast<textItem*>(line.tag());}
 
 public:
     explicit mainWidget(KXmlGuiWindow *main, QWidget *parent = nullptr);
+    ~mainWidget() override;
 
     auto initialLoad(const commandLineOptions& opts) -> bool;
 
 private Q_SLOTS:
     auto appendEmptyRow() -> void;
     auto actionLineNumbersTriggerd(bool checked) -> void;
+    auto addTemplateFilter(QString const& re) -> void;
     auto autoRunClicked() -> void;
+    auto autoRunTimeout() -> void;
+    auto bucketWidthChanged(int index) -> void;
     auto clearFilterRow() -> void;
     auto clearFilters() -> void;
+    auto clearResultCache() -> void;
+    auto clearTimeRange() -> void;
+    auto collapseDuplicatesChanged() -> void;
     auto deleteFilterRow() -> void;
     auto dialectChanged(QString const& text) -> void;
+    auto filterEntryEdited(int row, int column) -> void;
+    auto filtersEdited() -> void;
     auto filtersTableMenuRequested(QPoint point) -> void;
     auto gotoBookmark(int entry) -> void;
     auto gotoLine() -> void;
     auto insertEmptyFilterAbove() -> void;
     auto insertEmptyRowAt(int row) -> void;
     auto insertFiltersAbove() -> void;
+    /**
+     * go to displayed line for, or nearest previous line displayed for, a source line
+     * @param lineNumber source line number to display
+     */
+    auto jumpToSourceLine(int lineNumber) -> void;
     auto loadFilters() -> void;
     auto loadFiltersTable(const QUrl&) -> void;
     auto fontMetricsChanged(int lineHeight, int charWidth) -> void;
@@ -142,6 +156,11 @@ private Q_SLOTS:
     auto loadSubjectFromCB() -> void;
     auto moveFilterDown() -> void;
     auto moveFilterUp() -> void;
+    auto pinStep() -> void;
+    auto lintProbeFinished() -> void;
+    auto previewFinished() -> void;
+    auto regexEditEnded() -> void;
+    auto regexEdited(int row, QString const& text) -> void;
     auto resultContextClick(lineNumber_t,QPoint,QContextMenuEvent*) -> void;
     auto resultFind() -> void;
     auto resultFindNext() -> void;
@@ -150,15 +169,28 @@ private Q_SLOTS:
     auto saveFiltersAs() -> void;
     auto saveResult() -> void;
     auto saveResultAs() -> void;
+    auto saveSelectionAs() -> void;
     auto selectFilterFont() -> void;
     auto selectResultFont() -> void;
-    auto tableItemChanged(QTableWidgetItem *item) -> void;
+    auto showHistogramTriggered(bool checked) -> void;
+    auto showMinimapTriggered(bool checked) -> void;
+    auto showSlowLines() -> void;
+    auto showTemplates() -> void;
+    auto stepMemoryBudgetTriggered() -> void;
+    auto streamBlockRead(QByteArray const& text) -> void;
+    auto streamFinished(QString const& error) -> void;
+    auto streamLineLimitTriggered() -> void;
+    auto timeRangeSelected(int firstBucket, int lastBucket) -> void;
     auto toggleBookmark() -> void;
+    auto useResultCacheTriggered(bool checked) -> void;
+    auto workQueueChanged() -> void;
+    auto wrapLinesTriggered(bool checked) -> void;
 
 private:
     KXmlGuiWindow *mainWindow = nullptr;
 
-    QTableWidget *filtersTable = nullptr;
+    QTableView *filtersTable = nullptr;
+    filterModel *filtersModel = nullptr;
     wLogText *result = nullptr;
 
     bool doInitialApply = false;
@@ -166,6 +198,184 @@ private:
     bool reModified = false;
     bool subjModified = false;
 
+    /** A block of UTF-8 subject text, and the source line number of its last line */
+    struct subjectBlock {
+        QByteArray text;
+        int lastLine = 0;
+    };
+
+    /** Text of the subject, as UTF-8: a single block for a file or the
+     * clipboard, or the blocks read so far from a stream. Source item texts are
+     * views into these buffers, so lines are neither copied nor converted when
+     * loaded; they are matched as UTF-8, and decoded only for display. */
+    std::deque<subjectBlock> subjectBlocks;
+
+    /** Reader of a streamed subject, while it is being read */
+    QPointer<streamReader> streamSource;
+
+    /** Number of source lines kept from a stream; 0 for no limit. Trimmed as
+     * wLogText::maxLogLines, in batches once the slack is reached. */
+    int streamLineLimit = 0;
+
+    /** Number of filter rows whose step results are current for the source */
+    size_t validSteps = 0;
+
+    /** First filter row edited since a run last reached it; the steps after it
+     * are stale, even below validSteps */
+    size_t editedRow = std::numeric_limits<size_t>::max();
+
+    /** An intermediate step evicted from stepResults, to keep within stepMemoryBudget */
+    struct evictedStep {
+        QByteArray packed;          //!< source line indexes, by packLineIndexes(); empty once dropped
+        uint32_t count = 0;         //!< number of lines of the step
+        bool dropped = false;       //!< not held at all; rebuilt by filtering the step before
+    };
+
+    /** Evicted intermediate steps, indexed as stepResults; the step in
+     * stepResults is empty while evicted. The source and final steps are never
+     * evicted. */
+    std::vector<std::optional<evictedStep>> evictedSteps;
+
+    /** Estimated nanoseconds to compute each step from the one before, indexed as stepResults */
+    std::vector<qint64> stepCosts;
+
+    /** recentSteps key of each step, indexed as stepResults; 0 for none */
+    std::vector<uint64_t> recentStepKeys;
+
+    /** Step pinned as the base: never evicted, and the steps before it dropped; 0 for none */
+    size_t pinnedStep = 0;
+
+    /** Memory for the intermediate steps, in MiB */
+    int stepMemoryBudget = 2048;
+
+    /** Quiet time before an auto-run whose estimate exceeds autoRunLatency, in ms */
+    static constexpr int autoRunDelay = 750;
+
+    /** Auto-runs estimated within this many ms start at once; longer ones wait
+     * for autoRunDelay without further edits */
+    int autoRunLatency = 200;
+
+    /** Starts a pending auto-run */
+    QTimer *autoRunTimer = nullptr;
+
+    /** Status bar indicator of a pending auto-run */
+    QLabel *pendingLabel = nullptr;
+
+    /** Status bar note of the tasks queued on the background lane of the scheduler */
+    QLabel *workLabel = nullptr;
+
+    /** First row of a pending run; SIZE_MAX for none */
+    size_t pendingRun = std::numeric_limits<size_t>::max();
+
+    /** applyFrom() is filtering; events are processed while each row is filtered,
+     * and only its own applyExpression() calls are cancelled */
+    bool runInFlight = false;
+
+    /** The run in flight was cancelled, and is unwinding */
+    bool runCancelled = false;
+
+    /** Filtering of the row in flight */
+    QFuture<stepList> runFuture;
+
+    /** Number of lines of the input step sampled for the preview of a row being edited */
+    static constexpr size_t previewSampleSize = 65536;
+
+    /** Number of lines of the input step matched to probe the cost of an entered expression */
+    static constexpr size_t lintProbeLines = 1000;
+
+    /** Time limit of the probe of an entered expression */
+    static constexpr qint64 lintProbeNanos = 50000000;
+
+    /** Backtracking limit of each probe match, as pcre2_set_match_limit() */
+    static constexpr uint32_t lintMatchLimit = 1000000;
+
+    /** Estimated time to filter a row's input beyond which the row is marked as slow */
+    static constexpr qint64 lintSlowNanos = 5000000000;
+
+    /** Count of sampled lines kept by the expression being edited */
+    struct samplePreview {
+        int row = -1;               //!< row previewed
+        size_t sampled = 0;         //!< lines sampled
+        size_t kept = 0;            //!< sampled lines kept
+        bool tooCostly = false;     //!< a sampled line hit lintMatchLimit
+        QString error;              //!< error of an invalid expression
+    };
+
+    /** Evaluates the expression being edited on the preview sample */
+    QFutureWatcher<samplePreview> *previewWatcher = nullptr;
+
+    /** Sample of the input step of previewRow */
+    stepList previewSample;
+
+    /** Number of lines of the step previewSample was taken from */
+    int previewInputLines = 0;
+
+    /** Row being edited and previewed; -1 for none */
+    int previewRow = -1;
+
+    /** Text edited while a preview was running, to preview next */
+    std::optional<QString> previewPending;
+
+    /** Cost of a row's expression, timed on a sample of its input */
+    struct lintProbe {
+        int row = -1;               //!< row probed
+        QString text;               //!< expression probed
+        bool ignoreCase = false;    //!< case folding of the expression probed
+        bool limited = false;       //!< a sampled line reached lintMatchLimit
+        qint64 perLine = 0;         //!< nanoseconds per sampled line; 0 if none was timed
+        int lines = 0;              //!< lines of the input
+    };
+
+    /** Times an entered expression on the interactive lane */
+    QFutureWatcher<lintProbe> *lintWatcher = nullptr;
+
+    /** Rows waiting for lintWatcher, in the order linted */
+    std::deque<int> lintPending;
+
+    /** Measured nanoseconds per input line of each row, when last filtered; 0 if unknown */
+    std::vector<qint64> rowLineNanos;
+
+    /** Number of slowest lines kept per row while profiling */
+    static constexpr size_t slowLinesKept = 100;
+
+    /** Slowest lines of each row, slowest first, from its last run with profiling on */
+    std::vector<std::vector<slowLine>> rowSlowLines;
+
+    /** Largest total number of items held in recentSteps */
+    static constexpr int recentStepsBudget = (256 << 20) / static_cast<int>(sizeof(textItem*));
+
+    /** Recent step results of the current subject, keyed by the chain of active
+     * filters up to the step (stepKey() from 0), so undoing an edit or toggling a
+     * row back reuses a result rather than filtering again. Cleared when the
+     * source changes. Results share their items with stepResults. */
+    QCache<uint64_t, stepList> recentSteps{recentStepsBudget};
+
+    /** Undo stack of filter table edits */
+    QUndoStack *filtersUndo = nullptr;
+
+    /** Filters as of the last recorded edit */
+    QList<filterEntry> recordedFilters;
+
+    /** A check for a filters edit is queued */
+    bool filtersEditQueued = false;
+
+    /** First row of a queued lint of the rows to the end; -1 for none */
+    int lintQueuedFrom = -1;
+
+    /** Disk cache of step results and per subject state */
+    stepCache resultCache;
+
+    /** The subject is complete, so its step results may be cached; set for a
+     * file or the clipboard, not a stream */
+    bool subjectCacheable = false;
+
+    /** Fingerprint of the subject, once computed for the cache */
+    std::optional<uint64_t> subjectHash;
+
+    /** Source line to move the caret to once the result is displayed, from the
+     * saved state of the subject; 0 for none */
+    int pendingCaretLine = 0;
+
     /** Vector of text originally sourced text items */
     itemsList sourceItems;
 
@@ -174,6 +384,27 @@ private:
      * to results[n+1]. The final displayed result is at results.back(). */
     std::vector<stepList> stepResults;
 
+    /** Final step with duplicate lines collapsed to their first occurrence, when
+     * duplicate collapsing is enabled. */
+    stepList collapsedResult;
+
+    /** Occurrence count of each line in collapsedResult */
+    std::vector<uint32_t> collapsedCounts;
+
+    /** Largest value in collapsedCounts; sizes the gutter for the count badges */
+    uint32_t maxCollapsedCount = 0;
+
+    /** Time stamp of each source line, indexed by source line number - 1. Parsed
+     * when the time histogram is first needed for a subject. */
+    std::vector<qint64> sourceTimes;
+
+    /** Earliest and latest times of the final step, if resultTimeExtentKnown */
+    std::optional<std::pair<qint64, qint64>> resultTimeExtent;
+    bool resultTimeExtentKnown = false;
+
+    /** Range [first, last) of final step indexes selected in the time histogram */
+    std::optional<std::pair<int, int>> timeRange;
+
     /**
      * Map of display line number to source line number. The index into the
      * vector is the display line number, and the entry is the source line
@@ -200,12 +431,16 @@ private:
      * positions to source columns */
     int lineNoColCount = 0;
 
+    /** gutter width needed for the bookmark pixmaps at the current line height */
+    int gutterPixmapWidth = 0;
+
     KRecentFilesAction *recentFileAction = nullptr;
 
     /** subject file name to display in the application title; latest of last loaded or saved */
     QString titleFile;
 
     QAction *actionLoadFromClipboard = nullptr;
+    QAction *actionStreamLineLimit = nullptr;
     QAction *actionSaveResults = nullptr;
     QAction *actionSaveResultsAs = nullptr;
     QString resultFileName;
@@ -218,10 +453,23 @@ private:
     QAction *actionRun = nullptr;
     QAction *actionAutorun = nullptr;
     KSelectAction *actionDialect = nullptr;
+    QAction *actionCollapseDuplicates = nullptr;
+    QAction *actionCollapseMaskTime = nullptr;
+    QAction *actionUseResultCache = nullptr;
     QAction *actionLineNumbers = nullptr;
+    QAction *actionSaveSelectionAs = nullptr;
+    QAction *actionShowMinimap = nullptr;
+    QAction *actionWrapLines = nullptr;
+    QAction *actionShowHistogram = nullptr;
+    QAction *actionClearTimeRange = nullptr;
+    QWidget *histogramPanel = nullptr;
+    timeHistogram *histogram = nullptr;
+    QComboBox *bucketWidthCombo = nullptr;
     QMenu *filtersTableMenu = nullptr;
     QAction *actionMoveFilterUp = nullptr;
     QAction *actionMoveFilterDown = nullptr;
+    QAction *actionPinStep = nullptr;
+    QAction *actionProfileLines = nullptr;
     QAction *actionInsertFilters = nullptr;
 
     QPixmap pixBmUser;         //!< Pixmap to display in the gutter for user bookmarks
@@ -248,9 +496,18 @@ private:
      *
      * @param entry entry number to apply
      * @param src input string list to apply
-     * @return result of the filter applied to the input list @p entry
+     * @param annotate @c true to show the match count and time in the tooltip of the entry
+     * @param mode filterMode::cancellable only from the row loop of applyFrom();
+     * other callers, which may run while a run is unwinding, filter all lines
+     *
+     * With "Profile Slow Lines" on, each line's match is timed, and the slowest
+     * are kept in rowSlowLines; otherwise the lines are matched untimed.
+     *
+     * @return result of the filter applied to the input list @p entry; empty
+     * if @p mode is filterMode::cancellable and the run was cancelled
      */
-    auto applyExpression(size_t entry, stepList src) -> stepList;
+    auto applyExpression(size_t entry, stepList src, bool annotate = false,
+                         filterMode mode = filterMode::blocking) -> stepList;
 
     /**
      * @brief apply filter chain from point and those following
@@ -269,6 +526,28 @@ private:
      */
     auto clearResults() -> void;;
 
+    /**
+     * @brief collapse duplicate lines of the final step
+     *
+     * If duplicate collapsing is enabled, fills collapsedResult with the first
+     * occurrence of each distinct line of the final step, and collapsedCounts with
+     * the number of occurrences of each. Lines are hashed in parallel; lines with
+     * equal hashes are compared, so hash collisions do not merge distinct lines.
+     * Optionally, a leading timestamp is ignored when comparing lines.
+     */
+    auto collapseDuplicates() -> void;
+
+    /**
+     * @brief lines of the final step to display
+     * @return final step, narrowed to the time range if one is selected
+     */
+    auto finalItems() const -> stepList;
+
+    /**
+     * @brief recompute the time histogram of the final step, if it is shown
+     */
+    auto updateHistogram() -> void;
+
     /**
      * @brief update result display with the results of the final evaluation
      */
@@ -298,23 +577,316 @@ private:
 
     auto insertFiltersAt(int at, const filterData& fData) -> void;
 
-    /**
-     * go to displayed line for, or nearest previous line displayed for, a source line
-     * @param lineNumber source line number to display
-     */
-    auto jumpToSourceLine(int lineNumber) -> void;
-
     auto getFilterFile() -> QString;
     auto loadFiltersTable(const QString& localFile) -> bool;
     auto loadFiltersTable(const filterData& filters) -> bool;
     auto loadFiltersFile(const QString& fileName) -> filterData;
 
+    /**
+     * @brief set a minimap marker channel on the result lines which match
+     *
+     * The lines are tested in parallel; @p matches must be safe to call
+     * concurrently.
+     *
+     * @param channel marker channel to set
+     * @param matches predicate for the lines to mark
+     */
+    auto markResultLines(int channel, std::function<bool(logTextItemView const&)> const& matches) -> void;
+
+    /**
+     * @brief predicate for a line containing the last find text
+     * @return the predicate; empty if there is no valid find text
+     */
+    auto findHitMatcher() const -> std::function<bool(QStringView)>;
+
+    /**
+     * @brief mark the result lines containing the last find text in the minimap
+     */
+    auto updateFindMarkers() -> void;
+
+    /**
+     * @brief replace the subject with new text
+     *
+     * Takes over @p text as the subject buffer, splits it into lines in place
+     * and makes the source items refer into it. The results must have been
+     * cleared already.
+     *
+     * @param text UTF-8 subject text
+     */
+    auto setSubjectText(QByteArray&& text) -> void;
+
+    /**
+     * @brief append text to the subject
+     * @param text UTF-8 subject text; split into lines in place, as setSubjectText()
+     * @return the source items added
+     */
+    auto appendSubjectText(QByteArray&& text) -> stepList;
+
+    /** @return source line number of the first source item */
+    auto firstSourceLine() const -> int;
+
+    /**
+     * @brief start streaming the subject from stdin or a named pipe
+     * @param fileName named pipe to read; empty to read stdin
+     */
+    auto startStream(QString const& fileName) -> void;
+
+    /**
+     * @brief stop reading a streamed subject; the lines read so far are kept
+     */
+    auto stopStream() -> void;
+
+    /**
+     * @brief trim the oldest source lines to the stream line limit
+     *
+     * Once the source exceeds the slacked streamLineLimit, the oldest lines are
+     * removed from the source, each step and the display.
+     */
+    auto trimSource() -> void;
+
+    /**
+     * @brief make the display item for a final step item
+     * @param item final step item
+     * @return display item, with the line number if shown and the bookmark, tagged with @p item
+     */
+    auto newResultItem(textItem *item) const -> logTextItem;
+
+    /**
+     * @brief text of a result line, as the result widget's text source
+     * @param item source item the line is tagged with
+     * @return the line text, after the line number if shown
+     */
+    auto resultText(textItem const* item) const -> QString;
+
+    /**
+     * @brief fill the bookmarks menu from bookmarkedLines
+     */
+    auto updateBookmarkMenu() -> void;
+
+    /**
+     * @brief fingerprint of the subject for the result cache
+     * @return the fingerprint, computed on first use; nullopt if the cache is
+     * not in use or the subject is not cacheable
+     */
+    auto cacheSubjectHash() -> std::optional<uint64_t>;
+
+    /**
+     * @brief whether a filter row changes its input
+     * @param row filter table row
+     * @return @c true if the row is enabled and has an expression
+     */
+    auto isActiveFilter(size_t row) const -> bool;
+
+    /**
+     * @brief chain the cache key of a filter row
+     * @param row filter table row
+     * @param key cache key of the row's input
+     * @return cache key of the row's result; @p key if the row is not active
+     */
+    auto chainStepKey(size_t row, uint64_t key) -> uint64_t;
+
+    /**
+     * @brief a step, rebuilt if it was evicted
+     *
+     * A packed step is unpacked; a dropped step is rebuilt by filtering the step
+     * before it, itself rebuilt first if need be. A dropped step after editedRow
+     * is left evicted and empty, as the rows which made it have changed.
+     *
+     * @param step index into stepResults
+     * @return the step, held in stepResults again
+     */
+    auto stepInput(size_t step) -> stepList const&;
+
+    /**
+     * @brief rebuild every evicted step, before the steps are changed in place
+     */
+    auto restoreEvictedSteps() -> void;
+
+    /**
+     * @brief note that filter rows from row on were edited, inserted or removed
+     *
+     * Lowers editedRow, and drops the pin if its step follows the row.
+     *
+     * @param row first filter row changed
+     */
+    auto markRowsEdited(size_t row) -> void;
+
+    /**
+     * @brief memory held by an intermediate step
+     * @param step index into stepResults
+     * @return bytes held; 0 if the items are shared with the step before or the final step
+     */
+    auto stepBytes(size_t step) const -> size_t;
+
+    /**
+     * @brief evict an intermediate step from stepResults
+     *
+     * The following steps which share its items (those of inactive rows) are
+     * dropped with it, as they are rebuilt by copying.
+     *
+     * @param step index into stepResults
+     * @param drop @c true to drop the step; @c false to pack it
+     */
+    auto evictStep(size_t step, bool drop) -> void;
+
+    /**
+     * @brief evict intermediate steps until they fit stepMemoryBudget
+     *
+     * Held steps are packed first, largest first, as unpacking needs no
+     * filtering. If that is not enough, packed steps are dropped, those which
+     * cost least to rebuild from the nearest step still kept, per byte freed,
+     * first. The pinned step is kept.
+     */
+    auto enforceStepBudget() -> void;
+
+    /**
+     * @brief find a step result in recentSteps
+     * @param row filter table row, annotated as cached if found
+     * @param key cache key of the row's result, from stepKey() chained from 0
+     * @return the step result, or nullopt if not held
+     */
+    auto recentStep(size_t row, uint64_t key) -> std::optional<stepList>;
+
+    /**
+     * @brief set the tool tip of a filter row, without signalling an edit
+     * @param row filter table row
+     * @param toolTip text of the tool tip; the row's lint findings are appended
+     */
+    auto setRowToolTip(size_t row, QString const& toolTip) const -> void;
+
+    /**
+     * @brief check the expression of a filter row for costly constructs
+     *
+     * Runs lintPattern(), and where the row's input is current and held,
+     * queues a probe timing the expression on a sample of it, with a
+     * backtracking limit per line. The measured cost seeds rowLineNanos. A
+     * row with warnings, or estimated to take longer than lintSlowNanos, is
+     * marked with a warning icon; the findings are kept in the filter model
+     * and shown in its tool tip.
+     *
+     * @param row filter table row
+     */
+    auto lintFilterRow(int row) -> void;
+
+    /**
+     * @brief the input of a step, if it is current and held
+     *
+     * A step after editedRow is stale. An evicted step is not rebuilt; the
+     * lint probe is not worth a rerun.
+     *
+     * @param step index into stepResults
+     * @return the step's input, or nullptr
+     */
+    auto heldStepInput(size_t step) const -> stepList const*;
+
+    /**
+     * @brief start the probe of the next row queued by lintFilterRow()
+     */
+    auto startLintProbe() -> void;
+
+    /**
+     * @brief drop queued lint probes, and wait for one running, before the source items change
+     */
+    auto clearLint() -> void;
+
+    /**
+     * @brief lint the rows from a row to the end, once control returns to the event loop
+     *
+     * Loading filters and undo replace many rows at once; their lint is
+     * coalesced and left until the table is shown.
+     *
+     * @param first first filter table row to lint
+     */
+    auto queueLint(int first) -> void;
+
+    /**
+     * @brief annotate a filter row whose result was taken from a cache
+     * @param row filter table row
+     * @param count number of lines in the result
+     */
+    auto annotateCachedStep(size_t row, int count) -> void;
+
+    /**
+     * @brief load a step result from the result cache
+     * @param row filter table row, annotated as cached if found
+     * @param key cache key of the row's result
+     * @return the step result, or nullopt if not cached or not valid for the source
+     */
+    auto loadCachedStep(size_t row, uint64_t key) -> std::optional<stepList>;
+
+    /**
+     * @brief store a step result in the result cache
+     * @param key cache key of the result
+     * @param step result of the step
+     */
+    auto storeCachedStep(uint64_t key, stepList const& step) -> void;
+
+    /**
+     * @brief save the bookmarks and caret line of a cacheable subject
+     */
+    auto saveSubjectState() -> void;
+
+    /**
+     * @brief restore the bookmarks and caret line saved for the subject
+     */
+    auto restoreSubjectState() -> void;
+
     /**
      * @brief run expressions, if auto-apply option is enabled
+     *
+     * Cancels a run in flight, and schedules a run from the earliest row
+     * changed: at once if estimateRunNanos() is within autoRunLatency, otherwise
+     * after autoRunDelay without further edits, with a pending indicator shown.
+     *
      * @param entry table entry number to start applying from
      */
     auto maybeAutoApply(int entry) -> void;
 
+    /**
+     * @brief estimate the time to run the filters
+     *
+     * Rows whose result is in recentSteps cost nothing; the others cost their
+     * measured time per line, or a nominal time if not yet measured, for each
+     * line of the first step run. Filters only remove lines, so this is an
+     * upper bound on the lines each row sees.
+     *
+     * @param start first row to run
+     * @return estimated nanoseconds
+     */
+    auto estimateRunNanos(size_t start) -> qint64;
+
+    /**
+     * @brief evaluate an expression on the preview sample in the background
+     * @param text expression being edited in previewRow
+     */
+    auto startPreview(QString const& text) -> void;
+
+    /**
+     * @brief end any preview, and wait for one running, before the source items change
+     */
+    auto clearPreview() -> void;
+
+    /**
+     * @brief cancel the run in flight, if any
+     * @param wait @c true to wait for the filtering threads to stop, before the
+     * source items are changed
+     */
+    auto cancelRun(bool wait) -> void;
+
+    /** @return entries of all rows of the filters table */
+    auto filterRows() -> QList<filterEntry>;
+
+    /**
+     * @brief replace the filters table rows, as an undo or redo
+     * @param filters entries of the rows
+     */
+    auto setFilterRows(QList<filterEntry> const& filters) -> void;
+
+    /**
+     * @brief push an undo step if the filters changed since the last one
+     */
+    auto recordFiltersEdit() -> void;
+
     auto swapFiltersRows(int a, int b) -> void;
     auto getFilterRow(int row) -> filterEntry;
     auto setFilterRow(int row, filterEntry const& entry) -> void;
@@ -324,6 +896,11 @@ private:
      */
     auto showEvent(QShowEvent *ev) -> void override;
 
+    /**
+     * @brief size the result gutter for the pixmaps and count badges
+     */
+    auto updateGutterWidth() -> void;
+
     auto updateApplicationTitle() -> void;
 
     /**
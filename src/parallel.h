@@ -0,0 +1,122 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file parallel.h Helpers for running index ranges in parallel */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/** half open range of indexes [first, second) */
+using indexRange = std::pair<size_t, size_t>;
+
+/**
+ * @brief split [0, count) into contiguous ranges
+ *
+ * Splits the index range into a few chunks per pool thread, so a slow chunk
+ * does not hold up the rest, but small enough in number that the per-chunk
+ * overhead is negligible.
+ *
+ * @param count number of indexes
+ * @param minChunk smallest chunk worth scheduling on its own
+ * @param pool thread pool the chunks will run on
+ * @return vector of ranges covering [0, count)
+ */
+inline auto splitRanges(size_t count, size_t minChunk = 4096, QThreadPool const* pool = QThreadPool::globalInstance())
+    -> std::vector<indexRange>
+{
+    std::vector<indexRange> ranges;
+    if (count == 0)
+        return ranges;
+    size_t const threads = std::max(1, pool->maxThreadCount());
+    size_t const chunks = std::clamp<size_t>(count / std::max<size_t>(minChunk, 1), 1, threads * 4);
+    size_t const step = (count + chunks - 1) / chunks;
+    ranges.reserve(chunks);
+    for (size_t first = 0; first < count; first += step)
+        ranges.emplace_back(first, std::min(first + step, count));
+    return ranges;
+}
+
+/**
+ * @brief run a function over chunks of [0, count) in parallel
+ *
+ * Calls @p fn(first, last) for each chunk of the index range, blocking until
+ * all chunks are complete. Chunks are disjoint, so @p fn may write to
+ * pre-sized outputs at its own indexes without locking.
+ *
+ * @param count number of indexes
+ * @param fn function called as fn(size_t first, size_t last)
+ */
+template <typename Fn>
+auto parallelChunks(size_t count, Fn&& fn) -> void
+{
+    auto ranges = splitRanges(count);
+    if (ranges.size() == 1)
+        fn(ranges.front().first, ranges.front().second);
+    else if (!ranges.empty())
+        QtConcurrent::blockingMap(ranges, [&fn](indexRange const& r) {fn(r.first, r.second);});
+}
+
+/**
+ * @brief run a function over each of @p ranges on a thread pool
+ *
+ * As QtConcurrent::blockingMap(), which in Qt 5 only runs on the global pool:
+ * each range is a task of @p pool, and the call blocks until all are
+ * complete. @p fn is passed a reference into @p ranges, so may find the
+ * chunk's index from its address.
+ *
+ * @param pool thread pool to run on
+ * @param ranges chunks, as from splitRanges()
+ * @param fn function called as fn(indexRange const& r)
+ */
+template <typename Fn>
+auto blockingMapRanges(QThreadPool* pool, std::vector<indexRange> const& ranges, Fn&& fn) -> void
+{
+    if (ranges.size() == 1) {
+        fn(ranges.front());
+        return;
+    }
+    std::vector<QFuture<void>> futures;
+    futures.reserve(ranges.size());
+    for (indexRange const& r : ranges)
+        futures.push_back(QtConcurrent::run(pool, [&fn, &r]() {fn(r);}));
+    /* A chunk not yet started is run by the waiting thread. */
+    for (auto& future : futures)
+        future.waitForFinished();
+}
+
+/**
+ * @brief run a function over chunks of [0, count) on a thread pool
+ *
+ * As parallelChunks(), on @p pool rather than the global pool.
+ *
+ * @param pool thread pool to run on
+ * @param count number of indexes
+ * @param fn function called as fn(size_t first, size_t last)
+ */
+template <typename Fn>
+auto parallelChunks(QThreadPool* pool, size_t count, Fn&& fn) -> void
+{
+    blockingMapRanges(pool, splitRanges(count, 4096, pool), [&fn](indexRange const& r) {fn(r.first, r.second);});
+}
+
+#endif // PARALLEL_H
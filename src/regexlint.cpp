@@ -0,0 +1,343 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "regexlint.h"
+
+#include <KLocalizedString>
+
+#include <vector>
+
+namespace {
+
+/** First character an alternative can match */
+struct firstChar {
+    enum kind_t : uint8_t {none, literal, digit, word, space, any};
+    kind_t kind = none;
+    char16_t c = 0;
+};
+
+auto inClass(char16_t c, firstChar::kind_t kind) -> bool
+{
+    QChar const ch{c};
+    switch (kind) {
+    case firstChar::digit: return ch >= QLatin1Char('0') && ch <= QLatin1Char('9');
+    case firstChar::word: return ch.isLetterOrNumber() || ch == QLatin1Char('_');
+    case firstChar::space: return ch.isSpace();
+    case firstChar::any: return true;
+    default: return false;
+    }
+}
+
+/** @return whether two alternatives starting with @p a and @p b can start on the same character */
+auto overlaps(firstChar a, firstChar b) -> bool
+{
+    if (a.kind == firstChar::none || b.kind == firstChar::none)
+        return false;
+    if (a.kind == firstChar::literal && b.kind == firstChar::literal)
+        return a.c == b.c;
+    if (a.kind == firstChar::literal)
+        return inClass(a.c, b.kind);
+    if (b.kind == firstChar::literal)
+        return inClass(b.c, a.kind);
+    return a.kind == b.kind || a.kind == firstChar::any || b.kind == firstChar::any
+           || (a.kind == firstChar::digit && b.kind == firstChar::word)
+           || (a.kind == firstChar::word && b.kind == firstChar::digit);
+}
+
+/** A group being parsed; the top level is also a frame */
+struct groupFrame {
+    bool unbounded = false;             //!< contains an unbounded quantifier
+    bool atomic = false;                //!< atomic group or lookaround, which does not backtrack into
+    std::vector<firstChar> firsts = std::vector<firstChar>(1); //!< first character of each alternative
+    bool atAlternativeStart = true;
+};
+
+/** A parsed atom, before its quantifier */
+struct parsedAtom {
+    enum kind_t : uint8_t {literal, charClass, dot, group, anchor};
+    kind_t kind = literal;
+    firstChar first;
+    groupFrame contents;                //!< for a group
+};
+
+/** A parsed quantifier */
+struct quantifier {
+    bool present = false;
+    bool optional = false;              //!< may match zero times
+    bool unbounded = false;             //!< no upper bound
+    bool possessive = false;
+};
+
+auto parseQuantifier(QString const& pattern, int& i) -> quantifier
+{
+    quantifier q;
+    int const n = pattern.size();
+    if (i >= n)
+        return q;
+    QChar const c = pattern[i];
+    if (c == QLatin1Char('*') || c == QLatin1Char('+') || c == QLatin1Char('?')) {
+        q = {true, c != QLatin1Char('+'), c != QLatin1Char('?'), false};
+        ++i;
+    } else if (c == QLatin1Char('{')) {
+        /* {n}, {n,} or {n,m}; anything else is a literal brace */
+        int j = i + 1;
+        int const minStart = j;
+        while (j < n && pattern[j].isDigit())
+            ++j;
+        if (j == minStart)
+            return q;
+        bool const optional = pattern.midRef(minStart, j - minStart).toInt() == 0;
+        bool unbounded = false;
+        if (j < n && pattern[j] == QLatin1Char(',')) {
+            int const maxStart = ++j;
+            while (j < n && pattern[j].isDigit())
+                ++j;
+            unbounded = j == maxStart;
+        }
+        if (j >= n || pattern[j] != QLatin1Char('}'))
+            return q;
+        q = {true, optional, unbounded, false};
+        i = j + 1;
+    } else
+        return q;
+
+    if (i < n && pattern[i] == QLatin1Char('+')) {
+        q.possessive = true;
+        ++i;
+    } else if (i < n && pattern[i] == QLatin1Char('?'))
+        ++i;
+    return q;
+}
+
+/** @return the class of an escape letter, as "\d" */
+auto escapeClass(QChar e) -> firstChar::kind_t
+{
+    switch (e.unicode()) {
+    case u'd': return firstChar::digit;
+    case u'w': return firstChar::word;
+    case u's': return firstChar::space;
+    default: return firstChar::any;
+    }
+}
+
+/** @return whether an escape letter is a zero width assertion */
+auto isAssertion(QChar e) -> bool
+{
+    return QStringLiteral("bBAzZG").contains(e);
+}
+
+} // namespace
+
+auto lintPattern(QString const& pattern) -> patternLint
+{
+    patternLint lint;
+    int const n = pattern.size();
+    int i = 0;
+    if (pattern.startsWith(QLatin1Char('^')) || pattern.startsWith(QLatin1String("\\A")))
+        lint.anchored = true;
+
+    std::vector<groupFrame> groups(1);
+    bool literalOnly = true;
+    bool topAlternation = false;
+    bool leadingAtom = true;            // no atom yet at the top level
+    bool prefixOpen = lint.anchored;    // every atom so far is a literal, or the leading anchor
+    QString run;                        // literal text at the top level since the last break
+    auto const breakRun = [&run,&lint]() {
+        if (run.size() > lint.requiredLiteral.size())
+            lint.requiredLiteral = run;
+        run.clear();};
+
+    while (i < n) {
+        QChar const c = pattern[i];
+        parsedAtom atom;
+        if (c == QLatin1Char('\\') && i + 1 < n) {
+            QChar const e = pattern[i + 1];
+            i += 2;
+            if (!e.isLetterOrNumber()) {
+                atom.kind = parsedAtom::literal;
+                atom.first = {firstChar::literal, e.unicode()};
+            } else if (isAssertion(e)) {
+                atom.kind = parsedAtom::anchor;
+            } else {
+                atom.kind = parsedAtom::charClass;
+                atom.first = {escapeClass(e), 0};
+                /* \x{...}, \p{...} and the like */
+                if (i < n && pattern[i] == QLatin1Char('{')) {
+                    if (auto const close = pattern.indexOf(QLatin1Char('}'), i); close >= 0)
+                        i = close + 1;
+                }
+            }
+        } else if (c == QLatin1Char('[')) {
+            int j = i + 1;
+            if (j < n && pattern[j] == QLatin1Char('^'))
+                ++j;
+            if (j < n && pattern[j] == QLatin1Char(']'))
+                ++j;
+            for (; j < n && pattern[j] != QLatin1Char(']'); ++j) {
+                if (pattern[j] == QLatin1Char('\\'))
+                    ++j;
+            }
+            i = j + 1;
+            atom.kind = parsedAtom::charClass;
+            atom.first = {firstChar::any, 0};
+        } else if (c == QLatin1Char('(')) {
+            groupFrame frame;
+            prefixOpen = false;
+            ++i;
+            if (i < n && pattern[i] == QLatin1Char('?')) {
+                ++i;
+                QChar const k = i < n ? pattern[i] : QChar{};
+                if (k == QLatin1Char(':'))
+                    ++i;
+                else if (k == QLatin1Char('>') || k == QLatin1Char('=') || k == QLatin1Char('!')) {
+                    frame.atomic = true;
+                    ++i;
+                } else if (k == QLatin1Char('<') && i + 1 < n
+                           && (pattern[i + 1] == QLatin1Char('=') || pattern[i + 1] == QLatin1Char('!'))) {
+                    frame.atomic = true;
+                    i += 2;
+                } else if (k == QLatin1Char('<') || k == QLatin1Char('P') || k == QLatin1Char('\'')) {
+                    if (auto const close = pattern.indexOf(k == QLatin1Char('\'') ? QLatin1Char('\'') : QLatin1Char('>'), i + 1);
+                        close >= 0)
+                        i = close + 1;
+                } else {
+                    /* Options, as "(?i)", or a group with options, as "(?i:...)" */
+                    int j = i;
+                    while (j < n && (pattern[j].isLetter() || pattern[j] == QLatin1Char('-')))
+                        ++j;
+                    if (j < n && pattern[j] == QLatin1Char(')')) {
+                        i = j + 1;
+                        literalOnly = false;
+                        continue;
+                    }
+                    if (j < n && pattern[j] == QLatin1Char(':'))
+                        i = j + 1;
+                }
+            }
+            groups.push_back(std::move(frame));
+            literalOnly = false;
+            continue;
+        } else if (c == QLatin1Char(')')) {
+            ++i;
+            if (groups.size() < 2)
+                continue;
+            atom.kind = parsedAtom::group;
+            atom.contents = std::move(groups.back());
+            groups.pop_back();
+            auto const& firsts = atom.contents.firsts;
+            atom.first = firsts.size() == 1 ? firsts.front() : firstChar{firstChar::any, 0};
+        } else if (c == QLatin1Char('|')) {
+            ++i;
+            groups.back().firsts.emplace_back();
+            groups.back().atAlternativeStart = true;
+            if (groups.size() == 1) {
+                topAlternation = true;
+                breakRun();
+            }
+            literalOnly = false;
+            continue;
+        } else if (c == QLatin1Char('.')) {
+            ++i;
+            atom.kind = parsedAtom::dot;
+            atom.first = {firstChar::any, 0};
+        } else if (c == QLatin1Char('^') || c == QLatin1Char('$')) {
+            ++i;
+            atom.kind = parsedAtom::anchor;
+        } else if (c.isSurrogate()) {
+            /* A character beyond the BMP; not taken as literal text, so a
+             * quantifier never splits its surrogate pair. */
+            i += c.isHighSurrogate() && i + 1 < n && pattern[i + 1].isLowSurrogate() ? 2 : 1;
+            atom.kind = parsedAtom::charClass;
+            atom.first = {firstChar::any, 0};
+        } else {
+            ++i;
+            atom.kind = parsedAtom::literal;
+            atom.first = {firstChar::literal, c.unicode()};
+        }
+
+        if (atom.kind != parsedAtom::literal && !(atom.kind == parsedAtom::anchor && i == 1 && lint.anchored))
+            literalOnly = false;
+
+        auto& frame = groups.back();
+        if (atom.kind != parsedAtom::anchor && frame.atAlternativeStart) {
+            frame.firsts.back() = atom.first;
+            frame.atAlternativeStart = false;
+        }
+
+        quantifier q = parseQuantifier(pattern, i);
+        if (q.present)
+            literalOnly = false;
+        else if (i < n && pattern[i] == QLatin1Char('{')) {
+            /* Not a quantifier here, but newer PCRE2 accepts more forms, as
+             * "{,3}"; the atom is not counted as literal text either way. */
+            q.optional = true;
+            literalOnly = false;
+        }
+
+        if (atom.kind == parsedAtom::group && q.unbounded && !q.possessive && !atom.contents.atomic) {
+            if (atom.contents.unbounded)
+                lint.warnings << i18n("Nested unbounded quantifiers, as \"(a+)+\", may backtrack exponentially on "
+                                      "lines which nearly match");
+            auto const& firsts = atom.contents.firsts;
+            bool overlap = false;
+            for (size_t a = 0; a < firsts.size() && !overlap; ++a) {
+                for (size_t b = a + 1; b < firsts.size() && !overlap; ++b)
+                    overlap = overlaps(firsts[a], firsts[b]);
+            }
+            if (overlap)
+                lint.warnings << i18n("Alternatives which can start with the same character under a repeat, as "
+                                      "\"(a|ab)*\", may backtrack exponentially");
+        }
+        frame.unbounded |= q.unbounded || (atom.kind == parsedAtom::group && atom.contents.unbounded);
+
+        if (groups.size() == 1) {
+            if (leadingAtom && atom.kind == parsedAtom::dot && q.unbounded && !lint.anchored)
+                lint.warnings << i18n("A leading \".*\" without \"^\" is tried from every position of a line "
+                                      "which does not match; anchor it with \"^\", or remove it");
+            if (prefixOpen && atom.kind == parsedAtom::literal && !q.optional) {
+                lint.literalPrefix.append(QChar{atom.first.c});
+                prefixOpen = !q.present;
+            } else if (!(leadingAtom && atom.kind == parsedAtom::anchor))
+                prefixOpen = false;
+            if (atom.kind != parsedAtom::anchor)
+                leadingAtom = false;
+
+            if (atom.kind == parsedAtom::literal && !q.optional) {
+                run.append(QChar{atom.first.c});
+                if (q.present)
+                    breakRun();
+            } else
+                breakRun();
+        }
+    }
+    breakRun();
+    if (topAlternation) {
+        lint.requiredLiteral.clear();
+        lint.literalPrefix.clear();
+    }
+    lint.literal = literalOnly && !topAlternation && groups.size() == 1;
+
+    if (lint.literal)
+        lint.notes << (lint.anchored ? i18n("Literal text at the start of the line, matched by a prefix comparison")
+                                     : i18n("Literal text; a substring search would do"));
+    else if (!lint.literalPrefix.isEmpty())
+        lint.notes << i18n("Lines not starting with \"%1\" are rejected by a prefix comparison", lint.literalPrefix);
+    else if (lint.requiredLiteral.size() >= 3)
+        lint.notes << i18n("Every match contains \"%1\"; a literal prefilter can be used", lint.requiredLiteral);
+    else if (lint.anchored)
+        lint.notes << i18n("Anchored at the start of the line, so a line which does not match is rejected quickly");
+    return lint;
+}
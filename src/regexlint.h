@@ -0,0 +1,55 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file regexlint.h Static checks of regular expressions for costly constructs */
+
+#ifndef REGEXLINT_H
+#define REGEXLINT_H
+
+#include <QString>
+#include <QStringList>
+
+/** Findings of lintPattern() */
+struct patternLint {
+    QStringList warnings;       //!< constructs which may backtrack badly, or scan needlessly
+    QStringList notes;          //!< observations on how the pattern can be matched quickly
+    QString requiredLiteral;    //!< longest literal text every match contains; empty if none
+    QString literalPrefix;      //!< literal text every match starts with, for an anchored pattern; empty if none
+    bool literal = false;       //!< the whole pattern is literal text
+    bool anchored = false;      //!< the pattern is anchored at the start of the line
+};
+
+/**
+ * @brief check a pattern for costly constructs
+ *
+ * A single pass over the PCRE syntax, which warns of:
+ * - nested unbounded quantifiers, as "(a+)+", which backtrack exponentially
+ *   on a near miss;
+ * - alternatives which can start with the same character under an unbounded
+ *   quantifier, as "(a|ab)*", which backtrack the same way;
+ * - a leading ".*" or ".+" without a "^", which is retried from every position
+ *   of a line that does not match.
+ *
+ * Possessive quantifiers and atomic groups do not backtrack, and are not
+ * warned of. The checks are heuristic: character classes are assumed to
+ * overlap any character, so some warnings are for patterns which are fine.
+ *
+ * @param pattern regular expression
+ * @return findings; empty if nothing was noticed
+ */
+auto lintPattern(QString const& pattern) -> patternLint;
+
+#endif // REGEXLINT_H
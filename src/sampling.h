@@ -0,0 +1,87 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file sampling.h Stratified sampling of lines, and binomial confidence intervals */
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief choose a stratified sample of indexes
+ *
+ * Divides [0, count) into @p sampleSize equal strata, and picks one index at
+ * random from each, so the sample covers the whole input evenly, as a log's
+ * content changes along its length. The generator has a fixed seed, so the
+ * same input is always sampled the same way.
+ *
+ * @param count number of indexes to sample from
+ * @param sampleSize number of indexes to pick
+ * @return ascending sample indexes; all of [0, count) if @p count is no more than @p sampleSize
+ */
+inline auto stratifiedSample(size_t count, size_t sampleSize) -> std::vector<size_t>
+{
+    std::vector<size_t> sample;
+    if (count <= sampleSize) {
+        sample.resize(count);
+        for (size_t n = 0; n < count; ++n)
+            sample[n] = n;
+        return sample;
+    }
+
+    std::mt19937_64 random{count};
+    sample.reserve(sampleSize);
+    for (size_t stratum = 0; stratum < sampleSize; ++stratum) {
+        size_t const first = stratum * count / sampleSize;
+        size_t const last = (stratum + 1) * count / sampleSize;
+        sample.push_back(first + random() % (last - first));
+    }
+    return sample;
+}
+
+/**
+ * @brief Wilson score interval of a binomial proportion
+ *
+ * Unlike the normal approximation, the interval stays within [0, 1] and is
+ * sound for proportions near 0 or 1, as filter selectivities often are. For a
+ * stratified sample it is conservative, as stratifying only reduces the
+ * variance.
+ *
+ * @param successes number of successes, e.g. lines kept
+ * @param trials number of trials, e.g. lines sampled
+ * @param z standard score of the confidence level; 1.96 for 95%
+ * @return lower and upper bounds of the proportion
+ */
+inline auto wilsonInterval(size_t successes, size_t trials, double z = 1.96) -> std::pair<double, double>
+{
+    if (trials == 0)
+        return {0.0, 1.0};
+    double const n = static_cast<double>(trials);
+    double const p = static_cast<double>(successes) / n;
+    double const z2 = z * z;
+    double const scale = 1.0 + z2 / n;
+    double const centre = (p + z2 / (2.0 * n)) / scale;
+    double const half = z * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / scale;
+    return {std::max(0.0, centre - half), std::min(1.0, centre + half)};
+}
+
+#endif // SAMPLING_H
@@ -0,0 +1,150 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "scheduler.h"
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/** Default threads of the interactive and background lanes */
+constexpr int defaultLaneThreads = 2;
+
+/** Niceness of the background lane's threads */
+constexpr int backgroundNice = 10;
+
+} // namespace
+
+auto workScheduler::instance() -> workScheduler&
+{
+    static workScheduler scheduler;
+    return scheduler;
+}
+
+workScheduler::workScheduler()
+{
+    m_interactive.setMaxThreadCount(defaultLaneThreads);
+    m_background.setMaxThreadCount(defaultLaneThreads);
+}
+
+workScheduler::~workScheduler()
+{
+    waitForDone();
+}
+
+auto workScheduler::pool(workLane lane) -> QThreadPool*
+{
+    switch (lane) {
+    case workLane::interactive: return &m_interactive;
+    case workLane::background: return &m_background;
+    case workLane::foreground: break;
+    }
+    return QThreadPool::globalInstance();
+}
+
+void workScheduler::setThreadCount(workLane lane, int count)
+{
+    if (count <= 0)
+        count = lane == workLane::foreground ? QThread::idealThreadCount() : defaultLaneThreads;
+    pool(lane)->setMaxThreadCount(count);
+}
+
+void workScheduler::setCpuAffinity(workLane lane, std::vector<int> const& cpus)
+{
+    std::lock_guard const lock{m_affinityMutex};
+    m_affinity[index(lane)] = cpus;
+    ++m_affinityGeneration[index(lane)];
+}
+
+auto workScheduler::metrics(workLane lane) const -> laneMetrics
+{
+    auto const& counts = m_counts[index(lane)];
+    int const threads = lane == workLane::interactive ? m_interactive.maxThreadCount()
+                        : lane == workLane::background ? m_background.maxThreadCount()
+                        : QThreadPool::globalInstance()->maxThreadCount();
+    return {threads, counts.active.load(), counts.queued.load(), counts.completed.load()};
+}
+
+void workScheduler::waitForDone()
+{
+    m_interactive.waitForDone();
+    m_background.waitForDone();
+}
+
+void workScheduler::prepareThread(workLane lane)
+{
+    /* A pool thread only ever runs the tasks of its own lane, so it applies
+     * the lane's settings once, and again after they change. */
+    thread_local unsigned appliedGeneration = 0;
+    thread_local bool niced = false;
+    if (lane == workLane::foreground)
+        return;
+
+#ifdef Q_OS_LINUX
+    if (lane == workLane::background && !niced) {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), backgroundNice);
+        niced = true;
+    }
+
+    unsigned const generation = m_affinityGeneration[index(lane)].load();
+    if (generation == appliedGeneration)
+        return;
+    std::vector<int> cpus;
+    {
+        std::lock_guard const lock{m_affinityMutex};
+        cpus = m_affinity[index(lane)];
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpus.empty()) {
+        for (long cpu = 0, count = sysconf(_SC_NPROCESSORS_CONF); cpu < count && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET(static_cast<size_t>(cpu), &set);
+    } else {
+        for (int const cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(static_cast<size_t>(cpu), &set);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+    appliedGeneration = generation;
+#else
+    Q_UNUSED(niced)
+    Q_UNUSED(appliedGeneration)
+#endif
+}
+
+workScheduler::taskScope::taskScope(workScheduler& scheduler, workLane lane) :
+    m_scheduler{scheduler}, m_lane{lane}
+{
+    auto& counts = m_scheduler.m_counts[index(m_lane)];
+    --counts.queued;
+    ++counts.active;
+    m_scheduler.prepareThread(m_lane);
+    Q_EMIT m_scheduler.queueChanged();
+}
+
+workScheduler::taskScope::~taskScope()
+{
+    auto& counts = m_scheduler.m_counts[index(m_lane)];
+    --counts.active;
+    ++counts.completed;
+    Q_EMIT m_scheduler.queueChanged();
+}
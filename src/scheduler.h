@@ -0,0 +1,163 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file scheduler.h Application wide scheduling of work over lanes of threads */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Lanes of work, highest priority first */
+enum class workLane : uint8_t {
+    interactive,        //!< short tasks a user is waiting on: the typing preview, find and minimap marking
+    foreground,         //!< filtering a run of the filters
+    background,         //!< bulk work: writing and evicting the result cache, indexing wrapped lines
+};
+
+/** Number of work lanes */
+inline constexpr size_t workLaneCount = 3;
+
+/** Queue depth and throughput of a lane */
+struct laneMetrics {
+    int threads = 0;            //!< largest number of threads
+    int active = 0;             //!< tasks running
+    int queued = 0;             //!< tasks submitted, not yet started
+    quint64 completed = 0;      //!< tasks finished since start up
+};
+
+/**
+ * @brief thread pools of the application, one per lane of work
+ *
+ * Each lane has its own threads, so bulk filtering can not starve the tasks
+ * a user is waiting on, nor background work hold up either. The foreground
+ * lane is QtConcurrent's global pool, which the filter algorithms use; the
+ * other lanes have pools of their own, on which parallel.h's pool taking
+ * helpers split scans into chunks. Background threads run at a lower
+ * scheduling priority.
+ *
+ * The thread count of each lane, and the CPUs the interactive and background
+ * lanes run on, may be set; a changed CPU set is applied by each thread as it
+ * starts its next task. Tasks run by run() are counted for metrics(), and
+ * queueChanged() is signalled as they start and finish; the QtConcurrent
+ * algorithms on the foreground lane, and the chunks of parallel.h, are not
+ * counted.
+ */
+class workScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    /** @return the scheduler of the application */
+    static auto instance() -> workScheduler&;
+
+    ~workScheduler() override;
+
+    /** @return thread pool of @p lane */
+    auto pool(workLane lane) -> QThreadPool*;
+
+    /**
+     * @brief run a function on a lane
+     * @param lane lane to run on
+     * @param fn function to run, taking no arguments
+     * @return future of the result of @p fn
+     */
+    template <typename Fn>
+    auto run(workLane lane, Fn&& fn) -> QFuture<std::invoke_result_t<std::decay_t<Fn>&>>
+    {
+        auto& counts = m_counts[index(lane)];
+        ++counts.queued;
+        Q_EMIT queueChanged();
+        return QtConcurrent::run(pool(lane), [this, lane, fn = std::forward<Fn>(fn)]() mutable {
+            taskScope const scope{*this, lane};
+            return fn();});
+    }
+
+    /**
+     * @brief set the largest number of threads of a lane
+     * @param lane lane to set
+     * @param count number of threads; 0 for the default
+     */
+    auto setThreadCount(workLane lane, int count) -> void;
+
+    /**
+     * @brief set the CPUs a lane runs on
+     *
+     * Supported on Linux, for the interactive and background lanes; the
+     * foreground lane's threads are shared with other QtConcurrent users.
+     *
+     * @param lane lane to set
+     * @param cpus CPU numbers; empty for any CPU
+     */
+    auto setCpuAffinity(workLane lane, std::vector<int> const& cpus) -> void;
+
+    /** @return queue depth and throughput of @p lane */
+    auto metrics(workLane lane) const -> laneMetrics;
+
+    /** @brief wait for the tasks of all lanes to finish */
+    auto waitForDone() -> void;
+
+Q_SIGNALS:
+    /** A task was queued, started or finished; may be signalled from any thread */
+    void queueChanged();
+
+private:
+    workScheduler();
+
+    /** Task counts of a lane */
+    struct laneCounts {
+        std::atomic<int> queued{0};
+        std::atomic<int> active{0};
+        std::atomic<quint64> completed{0};
+    };
+
+    /** Counts a task running from construction to destruction */
+    class taskScope {
+    public:
+        taskScope(workScheduler& scheduler, workLane lane);
+        ~taskScope();
+        taskScope(taskScope const&) = delete;
+        auto operator=(taskScope const&) -> taskScope& = delete;
+
+    private:
+        workScheduler& m_scheduler;
+        workLane m_lane;
+    };
+
+    static constexpr auto index(workLane lane) -> size_t {return static_cast<size_t>(lane);}
+
+    /** @brief apply the CPU set and priority of @p lane to the calling thread, if changed */
+    auto prepareThread(workLane lane) -> void;
+
+    QThreadPool m_interactive;
+    QThreadPool m_background;
+    std::array<laneCounts, workLaneCount> m_counts;
+
+    std::mutex m_affinityMutex;
+    std::array<std::vector<int>, workLaneCount> m_affinity;         //!< CPUs of each lane; empty for any
+    std::array<std::atomic<unsigned>, workLaneCount> m_affinityGeneration{}; //!< changed with m_affinity
+};
+
+#endif // SCHEDULER_H
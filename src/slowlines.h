@@ -0,0 +1,86 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file slowlines.h The slowest lines matched by a filter row, kept while profiling */
+
+#ifndef SLOWLINES_H
+#define SLOWLINES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/** Time taken to match one line */
+struct slowLine {
+    int64_t nanos = 0;          //!< match time, in nanoseconds
+    int srcLineNumber = 0;      //!< source line number of the line
+};
+
+/**
+ * @brief the slowest lines seen, of any number offered
+ *
+ * Keeps a min-heap of the @p capacity slowest lines offered by add(), which
+ * may be called from several threads at once. Once the heap is full, its
+ * fastest time is a threshold below which a line is rejected without taking
+ * the lock, so the cost per line is a relaxed atomic load.
+ */
+class slowLinesReservoir {
+public:
+    /** @param capacity number of lines to keep */
+    explicit slowLinesReservoir(size_t capacity) : m_capacity{capacity} {m_heap.reserve(capacity + 1);}
+
+    /**
+     * @brief offer a line
+     * @param nanos time the line took to match
+     * @param srcLineNumber source line number of the line
+     */
+    auto add(int64_t nanos, int srcLineNumber) -> void
+    {
+        if (nanos <= m_threshold.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard const lock{m_mutex};
+        m_heap.push_back({nanos, srcLineNumber});
+        std::push_heap(m_heap.begin(), m_heap.end(), slower);
+        if (m_heap.size() > m_capacity) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), slower);
+            m_heap.pop_back();
+        }
+        if (m_heap.size() == m_capacity)
+            m_threshold.store(m_heap.front().nanos, std::memory_order_relaxed);
+    }
+
+    /** @return the lines kept, slowest first */
+    auto lines() const -> std::vector<slowLine>
+    {
+        std::lock_guard const lock{m_mutex};
+        std::vector<slowLine> sorted{m_heap};
+        std::sort(sorted.begin(), sorted.end(), slower);
+        return sorted;
+    }
+
+private:
+    /** Heap order putting the fastest line at the front */
+    static auto slower(slowLine const& a, slowLine const& b) -> bool {return a.nanos > b.nanos;}
+
+    size_t const m_capacity;
+    std::vector<slowLine> m_heap;
+    std::atomic<int64_t> m_threshold{-1};
+    mutable std::mutex m_mutex;
+};
+
+#endif // SLOWLINES_H
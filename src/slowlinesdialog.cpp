@@ -0,0 +1,78 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "slowlinesdialog.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+
+slowLinesDialog::slowLinesDialog(QString const& expression, std::vector<slowLine> const& lines,
+                                 QStringList const& texts, QWidget *parent) :
+    QDialog{parent}
+{
+    setWindowTitle(i18n("Slowest Lines of %1", expression));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    table = new QTableWidget(static_cast<int>(lines.size()), NumCol, this);
+    table->setObjectName(QStringLiteral("slowLinesTable"));
+    table->setHorizontalHeaderLabels({i18n("Time (µs)"), i18n("Line"), i18n("Text")});
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setWordWrap(false);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->setToolTip(i18n("Activate a line to show it, or the closest line of the result"));
+
+    for (size_t n = 0; n < lines.size(); ++n) {
+        int const row = static_cast<int>(n);
+
+        auto item = new QTableWidgetItem;
+        item->setData(Qt::DisplayRole, static_cast<double>(lines[n].nanos) / 1000.0);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table->setItem(row, ColTime, item);
+
+        item = new QTableWidgetItem;
+        item->setData(Qt::DisplayRole, lines[n].srcLineNumber);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table->setItem(row, ColLine, item);
+
+        table->setItem(row, ColText, new QTableWidgetItem(texts.value(row)));
+    }
+    table->setSortingEnabled(true);
+    table->sortItems(ColTime, Qt::DescendingOrder);
+    table->resizeColumnToContents(ColTime);
+    table->resizeColumnToContents(ColLine);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(table, &QTableWidget::cellActivated, this, [this](int row, int) {activateRow(row);});
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addWidget(buttons);
+    resize(fontMetrics().averageCharWidth() * 120, fontMetrics().height() * 30);
+}
+
+void slowLinesDialog::activateRow(int row)
+{
+    if (row >= 0 && row < table->rowCount())
+        Q_EMIT lineActivated(table->item(row, ColLine)->data(Qt::DisplayRole).toInt());
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SLOWLINESDIALOG_H
+#define SLOWLINESDIALOG_H
+
+#include <QDialog>
+
+#include <vector>
+
+#include "slowlines.h"
+
+class QTableWidget;
+
+/**
+ * @brief the slowest lines of a filter row
+ *
+ * Lists the lines which took longest to match when the row was last run with
+ * profiling on, with their match time and source line number, sortable on
+ * any column. Activating a line emits lineActivated() with its source line
+ * number.
+ */
+class slowLinesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief constructor
+     * @param expression regular expression of the row, for the title
+     * @param lines slowest lines, from slowLinesReservoir::lines()
+     * @param texts text of each entry in @p lines
+     * @param parent parent widget
+     */
+    slowLinesDialog(QString const& expression, std::vector<slowLine> const& lines, QStringList const& texts,
+                    QWidget *parent = nullptr);
+
+Q_SIGNALS:
+    /**
+     * @brief a line was selected to be shown
+     * @param srcLineNumber source line number of the line
+     */
+    void lineActivated(int srcLineNumber);
+
+private:
+    /** Constants for column addressing */
+    enum {ColTime = 0, ColLine, ColText, NumCol};
+
+    QTableWidget *table = nullptr;
+
+    auto activateRow(int row) -> void;
+};
+
+#endif // SLOWLINESDIALOG_H
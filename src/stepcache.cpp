@@ -0,0 +1,238 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "stepcache.h"
+#include "hashing.h"
+#include "mainwidget.h"
+#include "parallel.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+
+/** Identifies a step file, and its format version; bump to invalidate all entries */
+constexpr char stepMagic[8] = {'F', 'S', 'T', 'E', 'P', '0', '0', '1'};
+
+/** Step file header; the line indexes follow, packed by packLineIndexes() */
+struct stepHeader {
+    char magic[8];
+    uint64_t subject;
+    uint64_t key;
+    uint32_t sourceLines;
+    uint32_t count;
+};
+
+/** Chunk size for the fingerprint; fixed, so the result is independent of the thread count */
+constexpr size_t fingerprintChunk = size_t{16} << 20;
+
+auto hexName(uint64_t value) -> QString
+{
+    return QStringLiteral("%1").arg(value, 16, 16, QLatin1Char('0'));
+}
+
+} // namespace
+
+auto subjectFingerprint(std::string_view text) -> uint64_t
+{
+    size_t const chunks = (text.size() + fingerprintChunk - 1) / fingerprintChunk;
+    std::vector<uint64_t> hashes(chunks);
+    auto ranges = splitRanges(chunks, 1);
+    QtConcurrent::blockingMap(ranges, [&](indexRange const& r) {
+        for (size_t n = r.first; n < r.second; ++n) {
+            size_t const offset = n * fingerprintChunk;
+            hashes[n] = hash64(text.data() + offset, std::min(fingerprintChunk, text.size() - offset), n);
+        }});
+
+    uint64_t h = hashCombine(hashSecret0, text.size());
+    for (uint64_t const chunkHash : hashes)
+        h = hashCombine(h, chunkHash);
+    return h;
+}
+
+auto packLineIndexes(std::vector<uint32_t> const& lines, QByteArray& out) -> void
+{
+    uint32_t next = 0;
+    for (uint32_t const line : lines) {
+        for (uint32_t gap = line - next; ; gap >>= 7) {
+            if (gap < 0x80) {
+                out.append(static_cast<char>(gap));
+                break;
+            }
+            out.append(static_cast<char>((gap & 0x7f) | 0x80));
+        }
+        next = line + 1;
+    }
+}
+
+auto unpackLineIndexes(char const *data, size_t size, uint32_t count, uint32_t limit)
+    -> std::optional<std::vector<uint32_t>>
+{
+    if (count > limit)
+        return std::nullopt;
+    std::vector<uint32_t> lines;
+    lines.reserve(count);
+    auto p = reinterpret_cast<unsigned char const*>(data);
+    auto const end = p + size;
+    uint64_t next = 0;          // smallest index the next line may have
+    while (lines.size() < count) {
+        uint64_t gap = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (p == end || shift > 28)
+                return std::nullopt;
+            gap |= static_cast<uint64_t>(*p & 0x7f) << shift;
+            if (!(*p++ & 0x80))
+                break;
+        }
+        next += gap;
+        if (next >= limit)
+            return std::nullopt;
+        lines.push_back(static_cast<uint32_t>(next++));
+    }
+    if (p != end)
+        return std::nullopt;
+    return lines;
+}
+
+auto stepKey(uint64_t previous, filterEntry const& entry, QString const& dialect) -> uint64_t
+{
+    uint64_t const flags = (entry.enabled ? 1u : 0u) | (entry.exclude ? 2u : 0u) | (entry.ignoreCase ? 4u : 0u);
+    uint64_t h = hashCombine(previous, flags);
+    h = hashCombine(h, hash64(dialect.constData(), static_cast<size_t>(dialect.size()) * sizeof(QChar)));
+    return hashCombine(h, hash64(entry.re.constData(), static_cast<size_t>(entry.re.size()) * sizeof(QChar)));
+}
+
+
+stepCache::stepCache(QString directory) :
+    m_directory{std::move(directory)}
+{
+    if (m_directory.isEmpty())
+        m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/steps");
+}
+
+auto stepCache::subjectDirectory(uint64_t subject, bool touch) const -> QString
+{
+    QString const path{m_directory + QLatin1Char('/') + hexName(subject)};
+    if (touch)
+        ::utimensat(AT_FDCWD, QFile::encodeName(path).constData(), nullptr, 0);
+    return path;
+}
+
+auto stepCache::load(uint64_t subject, uint64_t key, uint32_t sourceLines) const -> std::optional<std::vector<uint32_t>>
+{
+    QFile file{subjectDirectory(subject, true) + QLatin1Char('/') + hexName(key)};
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+    QByteArray const data{file.readAll()};
+
+    stepHeader header;
+    if (static_cast<size_t>(data.size()) < sizeof header)
+        return std::nullopt;
+    std::memcpy(&header, data.constData(), sizeof header);
+    if (std::memcmp(header.magic, stepMagic, sizeof stepMagic) != 0 || header.subject != subject
+        || header.key != key || header.sourceLines != sourceLines)
+        return std::nullopt;
+    return unpackLineIndexes(data.constData() + sizeof header, static_cast<size_t>(data.size()) - sizeof header,
+                             header.count, sourceLines);
+}
+
+auto stepCache::store(uint64_t subject, uint64_t key, uint32_t sourceLines, std::vector<uint32_t> const& lines) const -> void
+{
+    QString const directory{subjectDirectory(subject, false)};
+    if (!QDir{}.mkpath(directory))
+        return;
+
+    stepHeader header;
+    std::memcpy(header.magic, stepMagic, sizeof stepMagic);
+    header.subject = subject;
+    header.key = key;
+    header.sourceLines = sourceLines;
+    header.count = static_cast<uint32_t>(lines.size());
+
+    QByteArray data;
+    data.reserve(static_cast<int>(sizeof header + lines.size() * 2));
+    data.append(reinterpret_cast<char const*>(&header), sizeof header);
+    packLineIndexes(lines, data);
+
+    QSaveFile file{directory + QLatin1Char('/') + hexName(key)};
+    if (file.open(QIODevice::WriteOnly) && file.write(data) == data.size())
+        file.commit();
+}
+
+auto stepCache::loadState(uint64_t subject) const -> QJsonObject
+{
+    QFile file{subjectDirectory(subject, false) + QStringLiteral("/state.json")};
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+auto stepCache::storeState(uint64_t subject, QJsonObject const& state) const -> void
+{
+    QString const directory{subjectDirectory(subject, false)};
+    if (!QDir{}.mkpath(directory))
+        return;
+    QSaveFile file{directory + QStringLiteral("/state.json")};
+    if (file.open(QIODevice::WriteOnly) && file.write(QJsonDocument{state}.toJson(QJsonDocument::Compact)) >= 0)
+        file.commit();
+}
+
+auto stepCache::evict() const -> void
+{
+    struct subjectUse {
+        QString path;
+        QDateTime used;
+        qint64 size = 0;
+    };
+    std::vector<subjectUse> subjects;
+    qint64 total = 0;
+    for (QDirIterator it{m_directory, QDir::Dirs | QDir::NoDotAndDotDot}; it.hasNext(); ) {
+        it.next();
+        subjectUse use{it.filePath(), it.fileInfo().lastModified(), 0};
+        for (QDirIterator files{use.path, QDir::Files}; files.hasNext(); ) {
+            files.next();
+            use.size += files.fileInfo().size();
+        }
+        total += use.size;
+        subjects.push_back(std::move(use));
+    }
+    if (total <= m_sizeLimit)
+        return;
+
+    std::sort(subjects.begin(), subjects.end(), [](auto const& a, auto const& b) {return a.used < b.used;});
+    for (auto const& use : subjects) {
+        if (total <= m_sizeLimit)
+            break;
+        if (QDir{use.path}.removeRecursively())
+            total -= use.size;
+    }
+}
+
+auto stepCache::clear() const -> void
+{
+    QDir{m_directory}.removeRecursively();
+}
@@ -0,0 +1,153 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file stepcache.h Persistent cache of filter step results */
+
+#ifndef STEPCACHE_H
+#define STEPCACHE_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+struct filterEntry;
+
+/**
+ * @brief fingerprint of subject content
+ *
+ * Hashes fixed size chunks in parallel and combines them in order, so the
+ * fingerprint does not depend on the number of threads.
+ *
+ * @param text subject text
+ * @return 64-bit fingerprint
+ */
+auto subjectFingerprint(std::string_view text) -> uint64_t;
+
+/**
+ * @brief pack ascending line indexes
+ *
+ * Each index is stored as the LEB128 encoded gap from the previous one, so a
+ * dense result takes about a byte per line.
+ *
+ * @param lines ascending line indexes
+ * @param out buffer the packed indexes are appended to
+ */
+auto packLineIndexes(std::vector<uint32_t> const& lines, QByteArray& out) -> void;
+
+/**
+ * @brief unpack line indexes packed by packLineIndexes()
+ * @param data packed indexes
+ * @param size size of @p data; all of it must be consumed
+ * @param count number of indexes
+ * @param limit bound on the indexes
+ * @return the indexes, or nullopt if the data is not valid
+ */
+auto unpackLineIndexes(char const *data, size_t size, uint32_t count, uint32_t limit)
+    -> std::optional<std::vector<uint32_t>>;
+
+/**
+ * @brief key of a filter step result
+ *
+ * Chained from the key of the previous step, so each key identifies the
+ * subject and the whole filter prefix up to and including @p entry.
+ *
+ * @param previous key of the previous step; the subject fingerprint for the first step
+ * @param entry filter of this step; the expression and each flag are hashed
+ * @param dialect expression dialect
+ * @return key of the step result
+ */
+auto stepKey(uint64_t previous, filterEntry const& entry, QString const& dialect) -> uint64_t;
+
+/**
+ * @brief disk cache of filter step results, and state saved per subject
+ *
+ * Each step result is stored as the delta encoded indexes of its source lines,
+ * in a file named for its key, in a directory for the subject fingerprint. The
+ * file header repeats the fingerprint, key and source line count, and a file
+ * which does not match, or is damaged, is treated as absent. Keys derive from
+ * the content and the filters, so a changed subject or filter simply has a new
+ * key; evict() removes the least recently used subjects over the size limit.
+ */
+class stepCache {
+public:
+    /** Default limit on the total size of the cache */
+    static constexpr qint64 defaultSizeLimit = qint64{1} << 30;
+
+    /**
+     * @brief constructor
+     * @param directory cache directory; empty for "steps" in the application cache location
+     */
+    explicit stepCache(QString directory = {});
+
+    /**
+     * @brief load a step result
+     * @param subject subject fingerprint
+     * @param key step key
+     * @param sourceLines number of source lines
+     * @return ascending source line indexes of the result, or nullopt if not cached
+     */
+    auto load(uint64_t subject, uint64_t key, uint32_t sourceLines) const -> std::optional<std::vector<uint32_t>>;
+
+    /**
+     * @brief store a step result
+     * @param subject subject fingerprint
+     * @param key step key
+     * @param sourceLines number of source lines
+     * @param lines ascending source line indexes of the result
+     */
+    auto store(uint64_t subject, uint64_t key, uint32_t sourceLines, std::vector<uint32_t> const& lines) const -> void;
+
+    /**
+     * @brief load the state saved for a subject
+     * @param subject subject fingerprint
+     * @return saved state; empty if none
+     */
+    auto loadState(uint64_t subject) const -> QJsonObject;
+
+    /**
+     * @brief save the state of a subject
+     * @param subject subject fingerprint
+     * @param state state to save, e.g. bookmarks and view position
+     */
+    auto storeState(uint64_t subject, QJsonObject const& state) const -> void;
+
+    /**
+     * @brief remove the least recently used subjects until within the size limit
+     */
+    auto evict() const -> void;
+
+    /**
+     * @brief remove all cached results and state
+     */
+    auto clear() const -> void;
+
+    auto setSizeLimit(qint64 bytes) -> void {m_sizeLimit = bytes;}
+    auto sizeLimit() const {return m_sizeLimit;}
+
+private:
+    QString m_directory;
+    qint64 m_sizeLimit = defaultSizeLimit;
+
+    /** @return directory of the subject's files; marked used if @p touch */
+    auto subjectDirectory(uint64_t subject, bool touch) const -> QString;
+};
+
+#endif // STEPCACHE_H
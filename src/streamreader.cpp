@@ -0,0 +1,47 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "streamreader.h"
+#include "blockreader.h"
+
+#include <QFile>
+
+#include <cstring>
+
+#include <unistd.h>
+
+streamReader::streamReader(QString fileName, QObject *parent) :
+    QObject{parent}, m_fileName{std::move(fileName)}
+{
+}
+
+void streamReader::run()
+{
+    QFile file{m_fileName};
+    int fd = STDIN_FILENO;
+    if (!m_fileName.isEmpty()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            Q_EMIT finished(file.errorString());
+            return;
+        }
+        fd = file.handle();
+    }
+
+    blockReader reader{fd, &m_stop};
+    while (auto const block = reader.next())
+        Q_EMIT blockRead(QByteArray{block->data(), static_cast<int>(block->size())});
+    Q_EMIT finished(reader.error() == 0 ? QString{} : QString::fromLocal8Bit(std::strerror(reader.error())));
+}
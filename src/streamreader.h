@@ -0,0 +1,77 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file streamreader.h Reading a stream subject on a background thread */
+
+#ifndef STREAMREADER_H
+#define STREAMREADER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+
+/**
+ * @brief reads stdin, or a named pipe, in blocks of whole lines
+ *
+ * Moved to a thread of its own, run() reads until end of input or stop(),
+ * emitting blockRead() for each block of lines as it arrives.
+ */
+class streamReader : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief constructor
+     * @param fileName named pipe or file to read; empty to read stdin
+     * @param parent parent object
+     */
+    explicit streamReader(QString fileName, QObject *parent = nullptr);
+
+    /**
+     * @brief request reading stop; may be called from any thread
+     *
+     * Reading stops at the next wait for input. Opening a named pipe waits
+     * for a writer, and is not interrupted.
+     */
+    auto stop() -> void {m_stop = true;}
+
+public Q_SLOTS:
+    /**
+     * @brief read until end of input or stop()
+     */
+    auto run() -> void;
+
+Q_SIGNALS:
+    /**
+     * @brief a block of lines was read
+     * @param text UTF-8 lines; the last ends with a newline unless it is the end of input
+     */
+    void blockRead(QByteArray const& text);
+
+    /**
+     * @brief reading has ended
+     * @param error description of the error which ended reading; empty at end of input
+     */
+    void finished(QString const& error);
+
+private:
+    QString m_fileName;
+    std::atomic<bool> m_stop{false};
+};
+
+#endif // STREAMREADER_H
@@ -0,0 +1,91 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "templatesdialog.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+
+templatesDialog::templatesDialog(std::vector<logTemplate> const& templates,
+                                 std::vector<templateSample> const& samples, QWidget *parent) :
+    QDialog{parent}
+{
+    setWindowTitle(i18n("Line Templates"));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    table = new QTableWidget(static_cast<int>(templates.size()), NumCol, this);
+    table->setObjectName(QStringLiteral("templatesTable"));
+    table->setHorizontalHeaderLabels({i18n("Count"), i18n("Template"), i18n("Line"), i18n("Sample")});
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setWordWrap(false);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    for (size_t n = 0; n < templates.size(); ++n) {
+        int const row = static_cast<int>(n);
+        auto const& templ = templates[n];
+
+        /* Numeric columns hold numbers rather than text, so they sort numerically. */
+        auto item = new QTableWidgetItem;
+        item->setData(Qt::DisplayRole, static_cast<qulonglong>(templ.count));
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table->setItem(row, ColCount, item);
+
+        item = new QTableWidgetItem(displayTemplate(templ.text));
+        item->setData(Qt::UserRole, templateRegularExpression(templ.text));
+        table->setItem(row, ColTemplate, item);
+
+        item = new QTableWidgetItem;
+        item->setData(Qt::DisplayRole, samples[n].srcLineNumber);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table->setItem(row, ColLine, item);
+
+        table->setItem(row, ColSample, new QTableWidgetItem(samples[n].text));
+    }
+    table->setSortingEnabled(true);
+    table->sortItems(ColCount, Qt::DescendingOrder);
+    table->resizeColumnToContents(ColCount);
+    table->resizeColumnToContents(ColLine);
+    table->setColumnWidth(ColTemplate, fontMetrics().averageCharWidth() * 60);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    filterButton = buttons->addButton(i18n("Filter to Template"), QDialogButtonBox::ActionRole);
+    filterButton->setToolTip(i18n("Add a filter selecting the lines of this template"));
+    filterButton->setEnabled(false);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(filterButton, &QPushButton::clicked, this, [this]() {activateRow(table->currentRow());});
+    connect(table, &QTableWidget::itemSelectionChanged, this, [this]() {
+        filterButton->setEnabled(!table->selectedItems().isEmpty());});
+    connect(table, &QTableWidget::cellActivated, this, [this](int row, int) {activateRow(row);});
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addWidget(buttons);
+    resize(fontMetrics().averageCharWidth() * 140, fontMetrics().height() * 30);
+}
+
+void templatesDialog::activateRow(int row)
+{
+    if (row >= 0 && row < table->rowCount())
+        Q_EMIT templateActivated(table->item(row, ColTemplate)->data(Qt::UserRole).toString());
+}
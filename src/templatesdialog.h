@@ -0,0 +1,72 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#ifndef TEMPLATESDIALOG_H
+#define TEMPLATESDIALOG_H
+
+#include <QDialog>
+
+#include <vector>
+
+#include "logtemplate.h"
+
+class QPushButton;
+class QTableWidget;
+
+/** Sample line of a template group */
+struct templateSample {
+    int srcLineNumber = 0;      //!< source line number of the sample
+    QString text;               //!< text of the sample line
+};
+
+/**
+ * @brief summary of line templates
+ *
+ * Lists each template with its line count and a sample line, sortable on any
+ * column. Activating a template emits templateActivated() with a regular
+ * expression matching the lines of that template.
+ */
+class templatesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief constructor
+     * @param templates template groups, from clusterTemplates()
+     * @param samples sample line for each entry in @p templates
+     * @param parent parent widget
+     */
+    templatesDialog(std::vector<logTemplate> const& templates, std::vector<templateSample> const& samples,
+                    QWidget *parent = nullptr);
+
+Q_SIGNALS:
+    /**
+     * @brief a template was selected for filtering
+     * @param re regular expression matching the lines of the template
+     */
+    void templateActivated(QString const& re);
+
+private:
+    /** Constants for column addressing */
+    enum {ColCount = 0, ColTemplate, ColLine, ColSample, NumCol};
+
+    QTableWidget *table = nullptr;
+    QPushButton *filterButton = nullptr;
+
+    auto activateRow(int row) -> void;
+};
+
+#endif // TEMPLATESDIALOG_H
@@ -0,0 +1,301 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "timehistogram.h"
+
+#include <QDateTime>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+
+namespace {
+
+constexpr qint64 msPerDay = 24 * 60 * 60 * 1000;
+
+/** @return character at @p pos, or 0 if beyond the end */
+inline auto charAt(std::string_view text, size_t pos) -> char
+{
+    return pos < text.size() ? text[pos] : '\0';
+}
+
+/**
+ * @brief parse a fixed number of decimal digits
+ * @return value of the digits, or -1 if any is not a digit
+ */
+inline auto digitsAt(std::string_view text, size_t pos, size_t count) -> int
+{
+    int value = 0;
+    for (size_t n = 0; n < count; ++n) {
+        char const c = charAt(text, pos + n);
+        if (c < '0' || c > '9')
+            return -1;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+/** Days since 1970-01-01 of a civil date; see H. Hinnant, "chrono-Compatible Low-Level Date Algorithms" */
+constexpr auto daysFromCivil(int y, int m, int d) -> qint64
+{
+    y -= m <= 2;
+    int const era = (y >= 0 ? y : y - 399) / 400;
+    int const yoe = y - era * 400;
+    int const doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<qint64>(era) * 146097 + doe - 719468;
+}
+
+/** @return month 1-12 of a three letter English month abbreviation at @p pos, or 0 */
+auto monthAt(std::string_view text, size_t pos) -> int
+{
+    static constexpr char const *months[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    for (int m = 0; m < 12; ++m) {
+        if (charAt(text, pos) == months[m][0] && charAt(text, pos + 1) == months[m][1]
+            && charAt(text, pos + 2) == months[m][2])
+            return m + 1;
+    }
+    return 0;
+}
+
+/** A time stamp at the start of a line, as recognized by matchTimestamp() */
+struct timestampMatch {
+    qint64 time = noTimestamp;  //!< milliseconds since the epoch, or noTimestamp
+    size_t end = 0;             //!< offset just after the date, or the time and its fraction
+    bool hasTime = false;       //!< a time of day was found, not just a date
+};
+
+/** @brief the grammar shared by parseTimestamp() and timestampLength() */
+auto matchTimestamp(std::string_view text) -> timestampMatch
+{
+    size_t pos = 0;
+    if (char const c = charAt(text, pos); c == '[' || c == '(')
+        ++pos;
+
+    std::optional<qint64> days;
+    size_t dateEnd = 0;
+    if (int const year = digitsAt(text, pos, 4); year >= 0) {
+        char const sep = charAt(text, pos + 4);
+        int const month = digitsAt(text, pos + 5, 2);
+        int const day = digitsAt(text, pos + 8, 2);
+        if ((sep == '-' || sep == '/') && charAt(text, pos + 7) == sep && month >= 1 && month <= 12
+            && day >= 1 && day <= 31) {
+            days = daysFromCivil(year, month, day);
+            pos += 10;
+            dateEnd = pos;
+            if (char const c = charAt(text, pos); c == ' ' || c == 'T')
+                ++pos;
+        }
+    } else if (int const month = monthAt(text, pos); month != 0 && charAt(text, pos + 3) == ' ') {
+        // syslog: "Oct 16 12:34:56" or "Oct  6 12:34:56"
+        pos += 4;
+        if (charAt(text, pos) == ' ')
+            ++pos;
+        int day = digitsAt(text, pos, 2);
+        if (day >= 0)
+            pos += 2;
+        else if ((day = digitsAt(text, pos, 1)) >= 0)
+            pos += 1;
+        if (day >= 1 && day <= 31 && charAt(text, pos) == ' ') {
+            days = daysFromCivil(1970, month, day);
+            dateEnd = pos;
+            ++pos;
+        }
+    }
+
+    int const hour = digitsAt(text, pos, 2);
+    int const minute = digitsAt(text, pos + 3, 2);
+    int const second = digitsAt(text, pos + 6, 2);
+    if (hour < 0 || minute < 0 || second < 0 || charAt(text, pos + 2) != ':' || charAt(text, pos + 5) != ':')
+        return days ? timestampMatch{*days * msPerDay, dateEnd, false} : timestampMatch{};
+    pos += 8;
+
+    /* Milliseconds are kept; any finer digits are only skipped. */
+    int msec = 0;
+    if (char const c = charAt(text, pos); (c == '.' || c == ',') && digitsAt(text, pos + 1, 1) >= 0) {
+        ++pos;
+        for (int scale = 100; digitsAt(text, pos, 1) >= 0; scale /= 10, ++pos)
+            msec += digitsAt(text, pos, 1) * scale;
+    }
+    return {days.value_or(0) * msPerDay + ((hour * 60 + minute) * 60 + second) * qint64{1000} + msec, pos, true};
+}
+
+} // namespace
+
+auto parseTimestamp(std::string_view text) -> qint64
+{
+    return matchTimestamp(text).time;
+}
+
+auto timestampLength(std::string_view text) -> size_t
+{
+    timestampMatch const match{matchTimestamp(text)};
+    if (!match.hasTime)
+        return 0;
+
+    size_t pos = match.end;
+    if (char const c = charAt(text, pos); c == 'Z')
+        ++pos;
+    else if ((c == '+' || c == '-') && digitsAt(text, pos + 1, 2) >= 0) {
+        // "+02:00" or "+0200"
+        pos += 3;
+        if (charAt(text, pos) == ':' && digitsAt(text, pos + 1, 2) >= 0)
+            pos += 3;
+        else if (digitsAt(text, pos, 2) >= 0)
+            pos += 2;
+    }
+    if (char const open = charAt(text, 0); (open == '[' && charAt(text, pos) == ']')
+                                           || (open == '(' && charAt(text, pos) == ')'))
+        ++pos;
+    while (charAt(text, pos) == ' ' || charAt(text, pos) == '\t')
+        ++pos;
+    return pos;
+}
+
+timeHistogram::timeHistogram(QWidget *parent) :
+    QWidget{parent}
+{
+    setMouseTracking(true);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+auto timeHistogram::sizeHint() const -> QSize
+{
+    return {400, fontMetrics().height() * 5};
+}
+
+void timeHistogram::setBuckets(timeBuckets&& newBuckets)
+{
+    m_buckets = std::move(newBuckets);
+    m_maxCount = m_buckets.empty() ? 0 : *std::ranges::max_element(m_buckets.counts);
+    m_selection.reset();
+    m_dragStart = -1;
+    update();
+}
+
+void timeHistogram::clearSelection()
+{
+    m_selection.reset();
+    m_dragStart = -1;
+    update();
+}
+
+auto timeHistogram::bucketAt(int x) const -> int
+{
+    if (m_buckets.empty() || width() <= 0)
+        return -1;
+    auto const bucket = static_cast<qint64>(std::clamp(x, 0, width() - 1)) * static_cast<qint64>(m_buckets.size()) / width();
+    return static_cast<int>(bucket);
+}
+
+auto timeHistogram::bucketX(qint64 bucket) const -> int
+{
+    return m_buckets.empty() ? 0 : static_cast<int>(bucket * width() / static_cast<qint64>(m_buckets.size()));
+}
+
+auto timeHistogram::bucketTime(qint64 bucket) const -> QString
+{
+    qint64 const t = m_buckets.origin + bucket * m_buckets.width;
+    auto const when = QDateTime::fromMSecsSinceEpoch(t, Qt::UTC);
+    if (t >= 0 && t < msPerDay)     // time only stamps
+        return when.toString(QStringLiteral("hh:mm:ss.zzz"));
+    return when.toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz"));
+}
+
+void timeHistogram::paintEvent([[maybe_unused]] QPaintEvent *event)
+{
+    QPainter painter{this};
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+    if (m_buckets.empty() || m_maxCount == 0) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect(), Qt::AlignCenter, i18n("No time stamps"));
+        return;
+    }
+
+    int const labelHeight = fontMetrics().height();
+    int const barHeight = std::max(1, height() - labelHeight);
+    auto const barTop = [barHeight,this](uint32_t count) {
+        return barHeight - static_cast<int>(static_cast<qint64>(count) * barHeight / m_maxCount);};
+
+    if (m_selection) {
+        auto const [first, last] = *m_selection;
+        int const x0 = bucketX(first);
+        painter.fillRect(x0, 0, std::max(1, bucketX(last + 1) - x0), barHeight, palette().color(QPalette::Highlight));
+    }
+
+    QColor const barColor = palette().color(QPalette::Text);
+    qint64 const bucketCount = static_cast<qint64>(m_buckets.size());
+    if (bucketCount <= width()) {
+        for (qint64 b = 0; b < bucketCount; ++b) {
+            if (auto const count = m_buckets.counts[static_cast<size_t>(b)]; count != 0) {
+                int const x0 = bucketX(b);
+                int const top = barTop(count);
+                painter.fillRect(x0, top, std::max(1, bucketX(b + 1) - x0 - 1), barHeight - top, barColor);
+            }
+        }
+    } else {
+        // More buckets than pixels; draw the largest bucket of each pixel column.
+        for (int x = 0; x < width(); ++x) {
+            auto const first = m_buckets.counts.begin() + static_cast<qint64>(x) * bucketCount / width();
+            auto const last = m_buckets.counts.begin() + static_cast<qint64>(x + 1) * bucketCount / width();
+            if (first == last)
+                continue;
+            if (auto const count = *std::max_element(first, last); count != 0) {
+                int const top = barTop(count);
+                painter.fillRect(x, top, 1, barHeight - top, barColor);
+            }
+        }
+    }
+
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(QRect{0, barHeight, width(), labelHeight}, Qt::AlignLeft | Qt::AlignVCenter, bucketTime(0));
+    painter.drawText(QRect{0, barHeight, width(), labelHeight}, Qt::AlignRight | Qt::AlignVCenter, bucketTime(bucketCount));
+}
+
+void timeHistogram::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && !m_buckets.empty()) {
+        m_dragStart = bucketAt(event->pos().x());
+        m_selection = std::pair{m_dragStart, m_dragStart};
+        update();
+    }
+}
+
+void timeHistogram::mouseMoveEvent(QMouseEvent *event)
+{
+    int const bucket = bucketAt(event->pos().x());
+    if (bucket < 0)
+        return;
+    if (m_dragStart >= 0 && (event->buttons() & Qt::LeftButton)) {
+        m_selection = std::minmax(m_dragStart, bucket);
+        update();
+    }
+    QToolTip::showText(event->globalPos(), i18n("%1: %2 lines", bucketTime(bucket),
+                                                 m_buckets.counts[static_cast<size_t>(bucket)]), this);
+}
+
+void timeHistogram::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_dragStart >= 0) {
+        m_dragStart = -1;
+        if (m_selection)
+            Q_EMIT rangeSelected(m_selection->first, m_selection->second);
+    }
+}
@@ -0,0 +1,274 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file timehistogram.h Line time stamps, and a histogram of lines per time bucket */
+
+#ifndef TIMEHISTOGRAM_H
+#define TIMEHISTOGRAM_H
+
+#include <QWidget>
+#include <QtConcurrent>
+
+#include <limits>
+#include <string_view>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+/** Time value of a line without a time stamp */
+inline constexpr qint64 noTimestamp = std::numeric_limits<qint64>::min();
+
+/** Largest number of buckets in a histogram; wider buckets are used beyond this */
+inline constexpr qint64 maxTimeBuckets = 1000000;
+
+/**
+ * @brief parse a leading time stamp
+ *
+ * Recognizes a time stamp at the start of a line, optionally after a '[' or
+ * '(': "2021-10-16 12:34:56.789", "2021/10/16T12:34:56", "Oct 16 12:34:56"
+ * (syslog, in 1970) or "12:34:56,789" (time only, on day zero). The time is
+ * taken as is, without time zone conversion.
+ *
+ * @param text UTF-8 line text
+ * @return milliseconds since the epoch, or noTimestamp if there is none
+ */
+auto parseTimestamp(std::string_view text) -> qint64;
+
+/**
+ * @brief length of a leading time stamp
+ *
+ * Recognizes the time stamps of parseTimestamp(), which must include a time
+ * of day, followed by an optional "Z" or "+hh:mm" zone and the closing ']' or
+ * ')'. Text after the time stamp is not part of it, so "12:00:01 200 GET"
+ * keeps "200 GET".
+ *
+ * @param text UTF-8 line text
+ * @return number of bytes in the time stamp, including trailing blanks; or 0 if none
+ */
+auto timestampLength(std::string_view text) -> size_t;
+
+/**
+ * @brief time stamp of each line
+ *
+ * Lines are parsed in parallel chunks. A line without a time stamp takes the
+ * time of the closest preceding line which has one, so continuation lines are
+ * counted at the time of their message.
+ *
+ * @param count number of lines
+ * @param textOf function returning the UTF-8 text of line n, as a std::string_view
+ * @return time of each line; noTimestamp before the first time stamp
+ */
+template <typename TextOf>
+auto lineTimestamps(size_t count, TextOf&& textOf) -> std::vector<qint64>
+{
+    std::vector<qint64> times(count);
+    auto ranges = splitRanges(count);
+    QtConcurrent::blockingMap(ranges, [&times,&textOf](indexRange const& r) {
+        qint64 last = noTimestamp;
+        for (size_t n = r.first; n < r.second; ++n) {
+            if (qint64 const t = parseTimestamp(textOf(n)); t != noTimestamp)
+                last = t;
+            times[n] = last;
+        }});
+
+    // Carry the time over the leading untimed lines of each chunk:
+    qint64 carry = noTimestamp;
+    for (auto const& [first, last] : ranges) {
+        for (size_t n = first; n < last && times[n] == noTimestamp; ++n)
+            times[n] = carry;
+        if (last > first)
+            carry = times[last - 1];
+    }
+    return times;
+}
+
+/** Line counts per time bucket */
+struct timeBuckets {
+    qint64 origin = 0;                  //!< start time of bucket 0, in milliseconds
+    qint64 width = 1000;                //!< width of each bucket, in milliseconds
+    std::vector<uint32_t> counts;       //!< number of lines in each bucket
+    std::vector<indexRange> ranges;     //!< range of line indexes in each bucket; empty for an empty bucket
+
+    auto size() const {return counts.size();}
+    auto empty() const {return counts.empty();}
+};
+
+/**
+ * @brief earliest and latest line times
+ * @param count number of lines
+ * @param timeOf function returning the time of line n
+ * @return pair of earliest and latest time, or nullopt if no line has a time
+ */
+template <typename TimeOf>
+auto timeExtent(size_t count, TimeOf&& timeOf) -> std::optional<std::pair<qint64, qint64>>
+{
+    auto ranges = splitRanges(count);
+    std::vector<std::pair<qint64, qint64>> extents(ranges.size(),
+        {std::numeric_limits<qint64>::max(), std::numeric_limits<qint64>::min()});
+    QtConcurrent::blockingMap(ranges, [&](indexRange const& r) {
+        auto& [low, high] = extents[static_cast<size_t>(&r - ranges.data())];
+        for (size_t n = r.first; n < r.second; ++n) {
+            if (qint64 const t = timeOf(n); t != noTimestamp) {
+                low = std::min(low, t);
+                high = std::max(high, t);
+            }
+        }});
+
+    std::pair<qint64, qint64> extent{std::numeric_limits<qint64>::max(), std::numeric_limits<qint64>::min()};
+    for (auto const& [low, high] : extents) {
+        extent.first = std::min(extent.first, low);
+        extent.second = std::max(extent.second, high);
+    }
+    if (extent.first > extent.second)
+        return std::nullopt;
+    return extent;
+}
+
+/**
+ * @brief count lines per time bucket
+ *
+ * A single parallel pass over the lines. Each chunk keeps dense counts over
+ * just the buckets its lines fall in, which for time ordered logs is a small
+ * span, and the chunks are then summed.
+ *
+ * @param count number of lines
+ * @param timeOf function returning the time of line n
+ * @param extent earliest and latest line times, from timeExtent()
+ * @param width bucket width in milliseconds; widened if needed to stay within maxTimeBuckets
+ * @return the buckets
+ */
+template <typename TimeOf>
+auto bucketLines(size_t count, TimeOf&& timeOf, std::pair<qint64, qint64> extent, qint64 width) -> timeBuckets
+{
+    timeBuckets buckets;
+    width = std::max<qint64>(width, 1);
+    width = std::max(width, (extent.second - extent.first) / maxTimeBuckets + 1);
+    buckets.width = width;
+    buckets.origin = extent.first - extent.first % width - (extent.first % width < 0 ? width : 0);
+    auto const bucketCount = static_cast<size_t>((extent.second - buckets.origin) / width + 1);
+
+    struct chunk {
+        indexRange range;
+        size_t offset = 0;                  //!< bucket number of counts[0]
+        std::vector<uint32_t> counts;
+        std::vector<indexRange> ranges;
+    };
+    std::vector<chunk> chunks;
+    for (auto const& range : splitRanges(count))
+        chunks.push_back(chunk{range, 0, {}, {}});
+
+    QtConcurrent::blockingMap(chunks, [&timeOf,&buckets](chunk& c) {
+        for (size_t n = c.range.first; n < c.range.second; ++n) {
+            qint64 const t = timeOf(n);
+            if (t == noTimestamp)
+                continue;
+            auto const b = static_cast<size_t>((t - buckets.origin) / buckets.width);
+            if (c.counts.empty())
+                c.offset = b;
+            else if (b < c.offset) {
+                c.counts.insert(c.counts.begin(), c.offset - b, 0);
+                c.ranges.insert(c.ranges.begin(), c.offset - b, indexRange{0, 0});
+                c.offset = b;
+            }
+            size_t const i = b - c.offset;
+            if (i >= c.counts.size()) {
+                c.counts.resize(i + 1);
+                c.ranges.resize(i + 1);
+            }
+            if (c.counts[i]++ == 0)
+                c.ranges[i] = {n, n + 1};
+            else
+                c.ranges[i].second = n + 1;
+        }});
+
+    buckets.counts.resize(bucketCount);
+    buckets.ranges.resize(bucketCount);
+    for (auto const& c : chunks) {
+        for (size_t i = 0; i < c.counts.size(); ++i) {
+            if (c.counts[i] == 0)
+                continue;
+            size_t const b = c.offset + i;
+            auto& range = buckets.ranges[b];
+            range = buckets.counts[b] == 0 ? c.ranges[i] :
+                    indexRange{std::min(range.first, c.ranges[i].first), std::max(range.second, c.ranges[i].second)};
+            buckets.counts[b] += c.counts[i];
+        }
+    }
+    return buckets;
+}
+
+/**
+ * @brief histogram of lines per time bucket
+ *
+ * Draws a bar per bucket, or where there are more buckets than pixels, the
+ * largest bucket per pixel column, so painting is independent of the line
+ * count. Dragging over the histogram selects a range of buckets.
+ */
+class timeHistogram : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit timeHistogram(QWidget *parent = nullptr);
+
+    /**
+     * @brief set the buckets to display, clearing any selection
+     * @param newBuckets line counts per bucket
+     */
+    auto setBuckets(timeBuckets&& newBuckets) -> void;
+
+    /** @return the displayed buckets */
+    auto buckets() const -> timeBuckets const& {return m_buckets;}
+
+    /**
+     * @brief clear the selected range of buckets
+     */
+    auto clearSelection() -> void;
+
+    auto sizeHint() const -> QSize override;
+
+Q_SIGNALS:
+    /**
+     * @brief a range of buckets was selected
+     * @param firstBucket first bucket of the range
+     * @param lastBucket last bucket of the range, inclusive
+     */
+    void rangeSelected(int firstBucket, int lastBucket);
+
+protected:
+    auto paintEvent(QPaintEvent *event) -> void override;
+    auto mousePressEvent(QMouseEvent *event) -> void override;
+    auto mouseMoveEvent(QMouseEvent *event) -> void override;
+    auto mouseReleaseEvent(QMouseEvent *event) -> void override;
+
+private:
+    timeBuckets m_buckets;
+    uint32_t m_maxCount = 0;            //!< largest bucket count, for scaling
+    std::optional<std::pair<int, int>> m_selection; //!< selected buckets, inclusive
+    int m_dragStart = -1;               //!< bucket where a selection drag started
+
+    /** @return bucket at widget x coordinate @p x */
+    auto bucketAt(int x) const -> int;
+
+    /** @return widget x coordinate of the start of bucket @p bucket */
+    auto bucketX(qint64 bucket) const -> int;
+
+    /** @return text of the time at the start of bucket @p bucket */
+    auto bucketTime(qint64 bucket) const -> QString;
+};
+
+#endif // TIMEHISTOGRAM_H
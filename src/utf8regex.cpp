@@ -0,0 +1,207 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+#include "utf8regex.h"
+#include "regexlint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace {
+
+struct matchDataDeleter {
+    auto operator()(pcre2_match_data *data) const -> void {pcre2_match_data_free(data);}
+};
+
+struct matchContextDeleter {
+    auto operator()(pcre2_match_context *context) const -> void {pcre2_match_context_free(context);}
+};
+
+constexpr auto asciiLower(char c) -> char
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+struct jitStackDeleter {
+    auto operator()(pcre2_jit_stack *stack) const -> void {pcre2_jit_stack_free(stack);}
+};
+
+/** Match data and contexts of a matching thread */
+struct threadMatchState {
+    /** Only whether there is a match is used */
+    std::unique_ptr<pcre2_match_data, matchDataDeleter> data{pcre2_match_data_create(1, nullptr)};
+    std::unique_ptr<pcre2_jit_stack, jitStackDeleter> jitStack{
+        pcre2_jit_stack_create(32 * 1024, utf8RegularExpression::jitStackMax, nullptr)};
+    std::unique_ptr<pcre2_match_context, matchContextDeleter> context{pcre2_match_context_create(nullptr)};
+    std::unique_ptr<pcre2_match_context, matchContextDeleter> limitedContext{pcre2_match_context_create(nullptr)};
+
+    threadMatchState()
+    {
+        // Without a stack, as without JIT support, PCRE2 uses its own.
+        pcre2_jit_stack_assign(context.get(), nullptr, jitStack.get());
+        pcre2_jit_stack_assign(limitedContext.get(), nullptr, jitStack.get());
+    }
+};
+
+auto threadState() -> threadMatchState&
+{
+    thread_local threadMatchState state;
+    return state;
+}
+
+} // namespace
+
+utf8RegularExpression::utf8RegularExpression(QString const& pattern, bool ignoreCase)
+{
+    uint32_t options = PCRE2_UTF;
+#ifdef PCRE2_MATCH_INVALID_UTF
+    options |= PCRE2_MATCH_INVALID_UTF;
+#endif
+    if (ignoreCase)
+        options |= PCRE2_CASELESS;
+
+    QByteArray const utf8{pattern.toUtf8()};
+    int errorCode = 0;
+    PCRE2_SIZE errorOffset = 0;
+    m_code = pcre2_compile(reinterpret_cast<PCRE2_SPTR>(utf8.constData()), static_cast<PCRE2_SIZE>(utf8.size()),
+                           options, &errorCode, &errorOffset, nullptr);
+    if (!m_code) {
+        PCRE2_UCHAR message[256];
+        pcre2_get_error_message(errorCode, message, sizeof message);
+        m_error = QStringLiteral("%1 at offset %2")
+                      .arg(QString::fromUtf8(reinterpret_cast<char const*>(message))).arg(errorOffset);
+        return;
+    }
+    // Without JIT support the interpreter is used; that is not an error.
+    pcre2_jit_compile(m_code, PCRE2_JIT_COMPLETE);
+
+    patternLint const lint{lintPattern(pattern)};
+    m_prefix = lint.literalPrefix.toStdString();
+    m_prefixOnly = lint.literal;
+    m_prefixIgnoreCase = ignoreCase;
+    if (ignoreCase && std::ranges::any_of(m_prefix, [](char c) {return static_cast<unsigned char>(c) >= 0x80;})) {
+        // Case folding beyond ASCII is left to PCRE2.
+        m_prefix.clear();
+    }
+}
+
+utf8RegularExpression::~utf8RegularExpression()
+{
+    pcre2_code_free(m_code);
+}
+
+utf8RegularExpression::utf8RegularExpression(utf8RegularExpression&& other) noexcept :
+    m_code{std::exchange(other.m_code, nullptr)}, m_error{std::move(other.m_error)},
+    m_prefix{std::move(other.m_prefix)}, m_prefixOnly{other.m_prefixOnly}, m_prefixIgnoreCase{other.m_prefixIgnoreCase},
+    m_matchErrors{other.m_matchErrors.load()}, m_matchError{other.m_matchError.load()}
+{
+}
+
+auto utf8RegularExpression::operator=(utf8RegularExpression&& other) noexcept -> utf8RegularExpression&
+{
+    std::swap(m_code, other.m_code);
+    std::swap(m_error, other.m_error);
+    std::swap(m_prefix, other.m_prefix);
+    std::swap(m_prefixOnly, other.m_prefixOnly);
+    std::swap(m_prefixIgnoreCase, other.m_prefixIgnoreCase);
+    m_matchErrors = other.m_matchErrors.exchange(m_matchErrors.load());
+    m_matchError = other.m_matchError.exchange(m_matchError.load());
+    return *this;
+}
+
+auto utf8RegularExpression::comparePrefix(std::string_view subject) const -> prefixMatch
+{
+    /* A caseless ASCII letter may also match a longer non-ASCII character, as
+     * "K" the Kelvin sign, but never fewer bytes, so a short subject fails. */
+    if (subject.size() < m_prefix.size())
+        return prefixMatch::mismatch;
+    if (!m_prefixIgnoreCase)
+        return std::memcmp(subject.data(), m_prefix.data(), m_prefix.size()) == 0 ? prefixMatch::match
+                                                                                   : prefixMatch::mismatch;
+
+    for (size_t n = 0; n < m_prefix.size(); ++n) {
+        char const c = subject[n];
+        if (c == m_prefix[n])
+            continue;
+        if (static_cast<unsigned char>(c) >= 0x80)
+            return prefixMatch::unknown;
+        if (asciiLower(c) != asciiLower(m_prefix[n]))
+            return prefixMatch::mismatch;
+    }
+    return prefixMatch::match;
+}
+
+auto utf8RegularExpression::prefixDecides(std::string_view subject) const -> std::optional<bool>
+{
+    if (m_prefix.empty())
+        return std::nullopt;
+    prefixMatch const prefix = comparePrefix(subject);
+    if (prefix == prefixMatch::mismatch)
+        return false;
+    if (prefix == prefixMatch::match && m_prefixOnly)
+        return true;
+    return std::nullopt;
+}
+
+auto utf8RegularExpression::match(std::string_view subject) const -> bool
+{
+    if (!m_code)
+        return false;
+    if (auto const decided = prefixDecides(subject))
+        return *decided;
+    auto& state = threadState();
+    int const rc = pcre2_match(m_code, reinterpret_cast<PCRE2_SPTR>(subject.data()), subject.size(),
+                               0, 0, state.data.get(), state.context.get());
+    return matched(rc);
+}
+
+auto utf8RegularExpression::matchLimited(std::string_view subject, uint32_t matchLimit) const -> std::optional<bool>
+{
+    if (!m_code)
+        return false;
+    if (auto const decided = prefixDecides(subject))
+        return *decided;
+    auto& state = threadState();
+    pcre2_set_match_limit(state.limitedContext.get(), matchLimit);
+    int const rc = pcre2_match(m_code, reinterpret_cast<PCRE2_SPTR>(subject.data()), subject.size(),
+                               0, 0, state.data.get(), state.limitedContext.get());
+    if (rc == PCRE2_ERROR_MATCHLIMIT)
+        return std::nullopt;
+    return matched(rc);
+}
+
+auto utf8RegularExpression::matched(int rc) const -> bool
+{
+    if (rc >= 0)
+        return true;
+    if (rc < PCRE2_ERROR_NOMATCH) {
+        m_matchError.store(rc, std::memory_order_relaxed);
+        m_matchErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    return false;
+}
+
+auto utf8RegularExpression::matchErrorString() const -> QString
+{
+    int const rc = m_matchError.load(std::memory_order_relaxed);
+    if (rc == 0)
+        return {};
+    PCRE2_UCHAR message[256];
+    pcre2_get_error_message(rc, message, sizeof message);
+    return QString::fromUtf8(reinterpret_cast<char const*>(message));
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+ ** A program to interactively apply regular expressions to an input file.
+ ** Copyright (C) 2021 Rick Wagner
+ **
+ ** This program is free software: you can redistribute it and/or modify it under the terms of
+ ** the GNU General Public License as published by the Free Software Foundation, either
+ ** version 3 of the License, or (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ ** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ ** See the GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along with this program.
+ ** If not, see <https://www.gnu.org/licenses/>.
+ **/
+
+/** @file utf8regex.h Regular expressions matched directly against UTF-8 text */
+
+#ifndef UTF8REGEX_H
+#define UTF8REGEX_H
+
+#include <QString>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+
+/**
+ * @brief a regular expression matching UTF-8 text
+ *
+ * Compiles a pattern with 8-bit PCRE2 in UTF mode, JIT compiled where
+ * available, so lines kept as UTF-8 are matched without conversion. The
+ * syntax is that of QRegularExpression, which is also PCRE2. Invalid UTF-8 in
+ * a subject does not match a character, rather than failing the match.
+ *
+ * A pattern anchored at the start of the line with a literal prefix, as
+ * "^\[WARN\]", is first checked by comparing the prefix with the start of
+ * the subject, so most lines are rejected without calling PCRE2; a pattern
+ * which is all prefix is not matched by PCRE2 at all. Case insensitive
+ * prefixes are compared as ASCII, deferring to PCRE2 where the subject has
+ * other characters, which may fold to ASCII ones.
+ *
+ * match() may be called from several threads at once; each thread keeps its
+ * own match data, and a JIT stack of up to jitStackMax bytes, rather than the
+ * 32 KiB PCRE2 gives a match without one, which long lines can exhaust. A
+ * match which fails with an error, as on reaching a resource limit, counts
+ * as not matching, and is counted in matchErrors() for the caller to report.
+ */
+class utf8RegularExpression {
+public:
+    /** Largest JIT stack of a matching thread */
+    static constexpr size_t jitStackMax = size_t{8} << 20;
+
+    /**
+     * @brief compile a pattern
+     * @param pattern regular expression
+     * @param ignoreCase @c true for a case insensitive match
+     */
+    utf8RegularExpression(QString const& pattern, bool ignoreCase);
+    ~utf8RegularExpression();
+
+    utf8RegularExpression(utf8RegularExpression const&) = delete;
+    auto operator=(utf8RegularExpression const&) -> utf8RegularExpression& = delete;
+    utf8RegularExpression(utf8RegularExpression&& other) noexcept;
+    auto operator=(utf8RegularExpression&& other) noexcept -> utf8RegularExpression&;
+
+    /** @return @c true if the pattern compiled */
+    auto isValid() const -> bool {return m_code != nullptr;}
+
+    /** @return description of the compile error, if not valid */
+    auto errorString() const -> QString const& {return m_error;}
+
+    /**
+     * @brief test for a match
+     * @param subject UTF-8 text to search
+     * @return @c true if the expression matches anywhere in @p subject
+     */
+    auto match(std::string_view subject) const -> bool;
+
+    /**
+     * @brief test for a match, giving up after a number of backtracking steps
+     * @param subject UTF-8 text to search
+     * @param matchLimit largest number of internal match calls, as pcre2_set_match_limit()
+     * @return whether the expression matches, or nullopt if the limit was reached first
+     */
+    auto matchLimited(std::string_view subject, uint32_t matchLimit) const -> std::optional<bool>;
+
+    /** @return number of matches which failed with an error, since compiling */
+    auto matchErrors() const -> size_t {return m_matchErrors.load(std::memory_order_relaxed);}
+
+    /** @return description of the last match error; empty if there was none */
+    auto matchErrorString() const -> QString;
+
+private:
+    /** Outcome of comparing the literal prefix */
+    enum class prefixMatch : uint8_t {mismatch, match, unknown};
+
+    pcre2_code *m_code = nullptr;
+    QString m_error;
+    std::string m_prefix;               //!< UTF-8 literal prefix of an anchored pattern; empty if none
+    bool m_prefixOnly = false;          //!< the pattern is just the prefix
+    bool m_prefixIgnoreCase = false;    //!< compare the prefix ignoring ASCII case
+    mutable std::atomic<size_t> m_matchErrors{0};   //!< matches failed with an error
+    mutable std::atomic<int> m_matchError{0};       //!< PCRE2 error code of the last of them
+
+    /** @return whether @p rc, from pcre2_match(), is a match; counts an error */
+    auto matched(int rc) const -> bool;
+
+    /** @return whether @p subject starts with the literal prefix */
+    auto comparePrefix(std::string_view subject) const -> prefixMatch;
+
+    /** @return whether @p subject matches, if the literal prefix alone decides it */
+    auto prefixDecides(std::string_view subject) const -> std::optional<bool>;
+};
+
+#endif // UTF8REGEX_H
@@ -16,9 +16,9 @@
  * displayed with a fixed pitch font, with all lines having the same height.
  * This simplifies position calculation and rendering.
  **/
-//#define TIME_DRAW_REQUEST
-
 #include "wlogtextprivate.h"
+#include "parallel.h"
+#include "scheduler.h"
 
 // Qt includes
 #include <QActionEvent>
@@ -28,15 +28,21 @@
 #include <QDebug>
 #include <QDrag>
 #include <QFontDatabase>
+#include <QIODevice>
 #include <QLabel>
 #include <QMimeData>
 #include <QRegularExpression>
 #include <QPainter>
+#include <QScreen>
 #include <QScrollBar>
 
 #include <KFind>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <numeric>
 #include <ranges>
 
 /** Application specific QEvent type to signal a need for screen refresh */
@@ -49,6 +55,25 @@ static const QString defaultPaletteNameString = QStringLiteral("default");
 static constexpr int gutterBorder = 1;
 /** Size in pixels of the border between the gutter and the text */
 static constexpr int textBorder = 1;
+/** Width in pixels of the minimap strip */
+static constexpr int minimapWidth = 12;
+
+/** Narrowest wrap width, in characters, however narrow the view */
+static constexpr int minWrapColumns = 16;
+
+/** Longest text copied to the clipboard as is; longer is built when pasted */
+static constexpr qint64 lazyCopyChars = 1 << 20;
+
+/** Characters encoded per block when writing text to a device */
+static constexpr int writeBlockChars = 1 << 20;
+
+/** @return up to @p count characters of @p text from column @p pos; empty if @p pos is past its end */
+static auto midView(QStringView text, int pos, int count) -> QStringView
+{
+    if (pos >= text.size())
+        return {};
+    return text.mid(pos, std::min<qsizetype>(count, text.size() - pos));
+}
 
 
 wLogText::wLogText(QWidget *parent) :
@@ -75,12 +100,16 @@ wLogText::wLogText(QWidget *parent) :
              SLOT(vScrollChange(int)));
     connect(horizontalScrollBar(), SIGNAL(valueChanged(int)),
              SLOT(hScrollChange(int)));
+
+    d->minimap = new logTextMinimap(d.get(), this);
+    d->minimap->setCursor(Qt::ArrowCursor);
+    d->minimap->hide();
 }
 
 
 wLogText::~wLogText()
 {
-    qDeleteAll(items);
+    d->releaseCopies();
 }
 
 QDebug operator<<(QDebug dbg, cell const& c)
@@ -99,13 +128,13 @@ QDebug operator<<(QDebug dbg, region const& r)
 
 auto wLogText::pointToCell(QPoint const& point) const -> cell
 {
-    return {std::min(d->yToLine(point.y()), m_lineCount), d->xToCharColumn(point.x())};
+    return d->pointToCell(point);
 }
 
 void wLogText::finalize()
 {
     trimLines();
-    items.shrink_to_fit();
+    items.shrinkToFit();
     finalized = true;
 }
 
@@ -134,17 +163,15 @@ void wLogText::timerEvent(QTimerEvent *event)
         if (m_hoverTime) {
             int const elapsed = mouseHoverOnTime.elapsed();
             if (  !mouseHovering && (elapsed - 5) > m_hoverTime) {
-                int const line = std::min(d->yToLine(mouseRawPos.y()), m_lineCount);
+                cell const at = d->pointToCell(mouseRawPos);
+                int const line = at.lineNumber();
                 if (validLineNumber(line)) {
                     if (d->inTheGutter(mouseRawPos.x())) {
                         mouseHovering = true;
                         Q_EMIT hover(line, -1);
-                    } else {
-                        int const col = d->xToCharColumn(mouseRawPos.x());
-                        if (col < items[line]->m_text.length()) {
-                            mouseHovering = true;
-                            Q_EMIT hover(line, col);
-                        }
+                    } else if (int const col = at.columnNumber(); col < items.length(line)) {
+                        mouseHovering = true;
+                        Q_EMIT hover(line, col);
                     }
                 }
             }
@@ -161,20 +188,35 @@ void wLogText::timerEvent(QTimerEvent *event)
         }
     } else if (event->timerId() == d->selectScrollTimerId) {
         verticalScrollBar()->setValue(verticalScrollBar()->value() + d->timedVScrollStep );
+    } else if (event->timerId() == refreshTimerId) {
+        killTimer(refreshTimerId);
+        refreshTimerId = 0;
+        QApplication::postEvent(this, new QEvent(updatesNeededEvent));
     }
 }
 
 
 void wLogText::setUpdatesNeeded(updateLevel level)
 {
+    ++d->paintStats.refreshRequests;
     if (level > updatesNeeded) {
         updatesNeeded = level;
         // It's OK to err on the side of extra posts; we just don't
-        // want to overdose on them.
+        // want to overdose on them. Lines arriving faster than the screen
+        // refreshes are shown once a frame, deferring the update to the next
+        // frame if the last one was within this frame.
         if (updatesEnabled() && (updatePosted++ == 0)) {
-            QApplication::postEvent(this, new QEvent(updatesNeededEvent));
+            qreal const rate = screen() ? screen()->refreshRate() : 60.0;
+            int const frameMillis = std::max(1, qRound(1000.0 / std::max(rate, 1.0)));
+            if (auto const elapsed = lastRefresh.isValid() ? lastRefresh.elapsed() : frameMillis; elapsed < frameMillis) {
+                if (refreshTimerId == 0)
+                    refreshTimerId = startTimer(frameMillis - static_cast<int>(elapsed), Qt::PreciseTimer);
+            } else
+                QApplication::postEvent(this, new QEvent(updatesNeededEvent));
+            return;
         }
     }
+    ++d->paintStats.mergedRefreshes;
 }
 
 
@@ -183,15 +225,17 @@ void wLogText::customEvent(QEvent *event)
     Q_UNUSED(event);
     updatePosted = 0;
     if (updatesNeeded && updatesEnabled()) {
+        lastRefresh.start();
         d->setContentSize();
 
         if (d->isScrollable()) {
             QScrollBar *vsb = verticalScrollBar();
-            if ((m_lineCount * d->m_textLineHeight) <= vsb->maximum()) {
+            qint64 const rows = d->totalRows();
+            if ((rows * d->m_textLineHeight) <= vsb->maximum()) {
                 vsb->setValue(0);
             } else {
                 int showable = viewport()->size().height() / d->m_textLineHeight;
-                if (m_lineCount <= showable) {
+                if (rows <= showable) {
                     vsb->setValue(0);
                 } else
                     vsb->setValue(vsb->maximum());
@@ -200,6 +244,7 @@ void wLogText::customEvent(QEvent *event)
             horizontalScrollBar()->setValue(0);
             viewport()->update();
         }
+        d->minimap->update();
         d->updateCaretPos(m_lineCount, 0);
         updatesNeeded = noUpdate;
     }
@@ -235,11 +280,8 @@ void wLogText::paintEvent(QPaintEvent *event)
 
 void wLogTextPrivate::drawContents(const QRect& bounds)
 {
-#ifdef TIME_DRAW_REQUEST
-    if (timeDraw) {
-        qDebug() << "Draw start dT " << drawTimer.elapsed();
-    }
-#endif
+    QElapsedTimer paintTimer;
+    paintTimer.start();
 
     if (!activePalette)
         activatePalette(defaultPaletteNameString);
@@ -306,83 +348,86 @@ void wLogTextPrivate::drawContents(const QRect& bounds)
     // We may actually only need a frament of the line (or even the interline
     // white-space).  But we'll draw the whole first line, and let the clipping
     // region sort it out.  Same for the last line.
+    // Rows are lines, unless wrapping, when long lines take several rows.
     int const visibleLines = (verticalClip + m_textLineHeight-1) / m_textLineHeight;
-    lineNumber_t line, lastDrawLine;
-    if (visibleLines < q->m_lineCount) [[likely]] {
-        line = (q->verticalScrollBar()->value() /  m_textLineHeight);
-        lastDrawLine = line + visibleLines;
-        if (lastDrawLine > q->m_lineCount) {
-            line = q->m_lineCount - visibleLines;
-            lastDrawLine = q->m_lineCount;
+    auto const rowCount = static_cast<lineNumber_t>(totalRows());
+    lineNumber_t row, lastDrawRow;
+    if (visibleLines < rowCount) [[likely]] {
+        row = (q->verticalScrollBar()->value() /  m_textLineHeight);
+        lastDrawRow = row + visibleLines;
+        if (lastDrawRow > rowCount) {
+            row = rowCount - visibleLines;
+            lastDrawRow = rowCount;
         }
     } else {
-        line = 0;
-        lastDrawLine = q->m_lineCount;
-        //last = std::max(q->m_lineCount-1, 0);
+        row = 0;
+        lastDrawRow = rowCount;
     }
-    const int lastPaintLine = std::min(lastDrawLine,
-            (line + (bounds.height() + m_textLineHeight + 1) / m_textLineHeight));
+    const int lastPaintRow = std::min(lastDrawRow,
+            (row + (bounds.height() + m_textLineHeight + 1) / m_textLineHeight));
 
     // If drawing at first line, paint it flush to top; else paint the final
     // pixmap so the bottom line is flush to bottom.
-    int pmYTop = (line == 0) ? 0 : (verticalClip - (visibleLines * m_textLineHeight)); // Top of text line
+    int pmYTop = (row == 0) ? 0 : (verticalClip - (visibleLines * m_textLineHeight)); // Top of text line
     int pmYBase = pmYTop + m_textLineHeight - textLineBaselineOffset;           // Baseline for text
     int const eraseWidth = std::min(pmSize.width(), bounds.width()) - m_gutterOffset;
-    int const pmChars = (eraseWidth + m_characterWidth - 1) / m_characterWidth;   //!< Displayable characters in pixma
-    logItemsImplCIt it = q->items.cbegin() + line;
-    logItemsImplCIt itemsEnd = q->items.cbegin() + lastPaintLine;
-    int const firstChar = q->horizontalScrollBar()->value();
-
-    // Initially set out of range, to skip selection drawing.  If we determine
-    // that this redraw event is in the selection region, set these values in
-    // range, until we're done; then we'll set them out of range again:
-    lineNumber_t firstSelectionLine = std::numeric_limits<lineNumber_t>::max();
-    lineNumber_t lastSelectionLine  = std::numeric_limits<lineNumber_t>::max();
-    int selectionLeftCol = firstChar;
-    int selectionRightCol = firstChar;
-    if (selecting) {
-        if (selectTop.lineNumber() <= selectBottom.lineNumber()) {
-            firstSelectionLine = std::max(selectTop.lineNumber(), line);
-            selectionLeftCol = std::max(0, selectTop.columnNumber() - firstChar);
-            lastSelectionLine = std::min(selectBottom.lineNumber(), lastDrawLine);
-            selectionRightCol = std::max(0, selectBottom.columnNumber() - firstChar);
-        } else {
-            firstSelectionLine = std::max(selectBottom.lineNumber(), line);
-            selectionLeftCol = std::max(0, selectBottom.columnNumber() - firstChar);
-            lastSelectionLine = std::min(selectTop.lineNumber(), lastDrawLine);
-            selectionRightCol = std::max(0, selectTop.columnNumber() - firstChar);
-        }
+    bool const wrap = isWrapping();
+    int const wrapCols = wrap ? wrapColumns() : 0;
+    int const pmChars = wrap ? wrapCols : (eraseWidth + m_characterWidth - 1) / m_characterWidth;   //!< Displayable characters in pixmap
+    int const firstChar = wrap ? 0 : q->horizontalScrollBar()->value();
+    qint64 const caretRow = cellToRow(caretPosition);
+
+    // The selection, ordered top to bottom. Each row paints the columns of the
+    // selection falling in its window of the line.
+    auto const [selFirst, selLast] = std::minmax(selectTop, selectBottom);
+
+    // Line and first column of the first row to paint:
+    logTextStore const& items = q->items;
+    lineNumber_t line = row;
+    int rowColumn = firstChar;
+    if (wrap) {
+        auto const [rowLine, subRow] = wrapped().lineAt(row);
+        line = rowLine;
+        rowColumn = subRow * wrapCols;
     }
 
     // Remember last style, so we don't do so many font changes:
+    lineNumber_t const firstPaintRow = row;
     styleId_t lastStyleId = activePalette->numStyles() + 1;
     const styleItem *style= &activePalette->style(0);
-    for (; it != itemsEnd;  ++it, ++line,
+    for (; row < lastPaintRow;  ++row,
                 pmYTop += m_textLineHeight, pmYBase += m_textLineHeight) {
-        logTextItemCPtr item = *it;
-        const QString text(item->text().mid(firstChar, pmChars));
+        // Wrap just the visible columns of the line, without copying; the
+        // cost of a line is independent of its length.
+        QStringView const lineText = items.text(line);
+        auto const window = midView(lineText, rowColumn, pmChars);
+        QString const text = QString::fromRawData(window.data(), static_cast<int>(window.size()));
         int const lineCharacters = text.length();
 
         // Can we avoid a font change?
-        if (lastStyleId != item->styleId()) [[unlikely]] {
-            lastStyleId = item->styleId();
-            style = &activePalette->style(item->styleId());
+        if (styleId_t const styleId = items.styleId(line); lastStyleId != styleId) [[unlikely]] {
+            lastStyleId = styleId;
+            style = &activePalette->style(styleId);
             pixmapPainter.setFont(style->font);
+            ++paintStats.styleCacheMisses;
+        } else
+            ++paintStats.styleCacheHits;
+
+        // Selected columns within this row:
+        int selLeft = 0;
+        int selRight = 0;
+        if (selecting && line >= selFirst.lineNumber() && line <= selLast.lineNumber()) [[unlikely]] {
+            int const from = (line == selFirst.lineNumber()) ? selFirst.columnNumber() : 0;
+            int const to = (line == selLast.lineNumber()) ? selLast.columnNumber() : std::numeric_limits<int>::max();
+            selLeft = std::clamp(from - rowColumn, 0, lineCharacters);
+            selRight = std::clamp(to - rowColumn, selLeft, lineCharacters);
         }
 
-        // See if the current line is in the selection range:
-        if (line >= firstSelectionLine) [[unlikely]] {
+        if (selRight > selLeft) [[unlikely]] {
             // Draw selection background:
-            int right = lineCharacters;
-            if (line == lastSelectionLine) {
-                right = selectionRightCol;
-                // After this one, we're done drawing selection for this event,
-                // so set the values out of range as a flag.
-                firstSelectionLine = lastSelectionLine = std::numeric_limits<lineNumber_t>::max();
-            }
-            QStringRef const leftChars(text.midRef(0, selectionLeftCol));
-            QStringRef const selChars(text.midRef(selectionLeftCol, right - selectionLeftCol));
-            QStringRef const rightChars(text.midRef(right));
+            QStringRef const leftChars(text.midRef(0, selLeft));
+            QStringRef const selChars(text.midRef(selLeft, selRight - selLeft));
+            QStringRef const rightChars(text.midRef(selRight));
 
             if (leftChars.size() != 0 || rightChars.size() != 0) {
                 // There may be normal text to left of first selection line,
@@ -407,18 +452,15 @@ void wLogTextPrivate::drawContents(const QRect& bounds)
                 }
             }
 
-            if (selChars.size() != 0) {
-                int const x = leftChars.size() * m_characterWidth + m_gutterOffset;
-                pixmapPainter.setBackground(m_qpalette.color(QPalette::Active,
-                                                             QPalette::Highlight));
-                pixmapPainter.setPen(m_qpalette.color(QPalette::Active,
-                                                      QPalette::HighlightedText));
+            int const x = leftChars.size() * m_characterWidth + m_gutterOffset;
+            pixmapPainter.setBackground(m_qpalette.color(QPalette::Active,
+                                                         QPalette::Highlight));
+            pixmapPainter.setPen(m_qpalette.color(QPalette::Active,
+                                                  QPalette::HighlightedText));
 
-                pixmapPainter.eraseRect(x, pmYTop, selChars.size() * m_characterWidth,
-                                        m_textLineHeight);
-                pixmapPainter.drawText(x, pmYBase, selChars.toString());
-            }
-            selectionLeftCol = 0;
+            pixmapPainter.eraseRect(x, pmYTop, selChars.size() * m_characterWidth,
+                                    m_textLineHeight);
+            pixmapPainter.drawText(x, pmYBase, selChars.toString());
         } else {
             // Outside selection, this is easy:
             auto const bgColor = (caretPosition.lineNumber() == line)  ?
@@ -435,9 +477,12 @@ void wLogTextPrivate::drawContents(const QRect& bounds)
                 pixmapPainter.setBackground(defBGColor);
         }
 
+        // The gutter pixmap and badge go on the first row of a line.
+        bool const firstRow = !wrap || rowColumn == 0;
+
         // If the gutter is showing, and this item has a pixmap, draw it now:
-        if (gutterWidth > 0 && item->hasPixmap()) [[unlikely]] {
-            if (auto const it = itemPixMaps.constFind(item->pixmapId()); it != itemPixMaps.cend()) {
+        if (auto const pixmapId = gutterWidth > 0 && firstRow ? items.pixmapId(line) : std::nullopt; pixmapId) [[unlikely]] {
+            if (auto const it = itemPixMaps.constFind(*pixmapId); it != itemPixMaps.cend()) {
                 int y = pmYTop;       // Start at top of line
                 int dy = 0;
                 QPixmap const& pm = *it;
@@ -452,33 +497,95 @@ void wLogTextPrivate::drawContents(const QRect& bounds)
             }
         }
 
-        // If this is the caret line and the caret is blinkOn state, draw it here:
-        if ((caretPosition.lineNumber() == line) && caretBlinkOn) [[unlikely]] {
-            drawCaret(pixmapPainter, caretPosition.columnNumber() * m_characterWidth + m_gutterOffset,
+        // Count badges are drawn right aligned in the gutter, over any pixmap:
+        if (auto const badge = gutterWidth > 0 && firstRow ? items.badge(line) : 0; badge != 0) [[unlikely]] {
+            pixmapPainter.setPen(m_qpalette.color(QPalette::Active, QPalette::ToolTipText));
+            pixmapPainter.drawText(QRect{0, pmYTop, gutterWidth - 1, m_textLineHeight},
+                                   Qt::AlignRight | Qt::AlignVCenter, QString::number(badge));
+        }
+
+        // If this is the caret row and the caret is blinkOn state, draw it here:
+        if ((caretRow == row) && caretBlinkOn) [[unlikely]] {
+            drawCaret(pixmapPainter, (caretPosition.columnNumber() - rowColumn) * m_characterWidth + m_gutterOffset,
                     pmYTop + textLineBaselineOffset,
                     pmYBase + textLineBaselineOffset);
         }
-    }       // for items...
+
+        // Step to the next row: the next part of a wrapped line, or the next line.
+        if (wrap && rowColumn + wrapCols < lineText.size())
+            rowColumn += wrapCols;
+        else {
+            ++line;
+            rowColumn = firstChar;
+        }
+    }       // for rows...
 
     // Handle the caret follows last line case:
-    if ((caretPosition.lineNumber() == line) && caretBlinkOn) {
+    if ((caretRow == row) && caretBlinkOn) {
         drawCaret(pixmapPainter, m_gutterOffset, pmYTop + textLineBaselineOffset,
                 pmYBase + textLineBaselineOffset);
 
     }
 
+    if (showPaintStats) [[unlikely]]
+        drawPaintStats(pixmapPainter);
+
     // Close off pixmap for blt onto screen:
     pixmapPainter.end();
 
     // Draw the off-screen pixmap onto the screen:
     QPainter(q->viewport()).drawPixmap(0, 0, *drawPixMap);
 
-#ifdef TIME_DRAW_REQUEST
-    if (timeDraw) {
-        timeDraw = false;
-        qDebug() << "Draw complete dT " << drawTimer.elapsed();
+    countPaint(paintTimer.nsecsElapsed(), row - firstPaintRow);
+}
+
+
+void wLogTextPrivate::countPaint(qint64 nanos, qint64 rows)
+{
+    ++paintStats.paints;
+    paintStats.totalPaintNanos += nanos;
+    paintStats.lastPaintNanos = nanos;
+    paintStats.maxPaintNanos = std::max(paintStats.maxPaintNanos, nanos);
+    paintStats.rowsDrawn += rows;
+    paintStats.lastRowsDrawn = rows;
+
+    // Rates are over intervals of at least a second, ending at a paint.
+    if (!statsClock.isValid()) {
+        statsMark = paintStats;
+        statsClock.start();
+    } else if (qint64 const elapsed = statsClock.elapsed(); elapsed >= 1000) {
+        paintsPerSecond = (paintStats.paints - statsMark.paints) * 1000 / elapsed;
+        mergedPerSecond = (paintStats.mergedRefreshes - statsMark.mergedRefreshes) * 1000 / elapsed;
+        statsMark = paintStats;
+        statsClock.restart();
     }
-#endif
+}
+
+
+void wLogTextPrivate::drawPaintStats(QPainter& painter) const
+{
+    // Times are of the paint before this one, which is still being drawn.
+    auto const millis = [](qint64 nanos) {return QString::number(static_cast<double>(nanos) / 1e6, 'f', 2);};
+    QStringList const lines{
+        QStringLiteral("paint %1 ms, %2 rows").arg(millis(paintStats.lastPaintNanos)).arg(paintStats.lastRowsDrawn),
+        QStringLiteral("slowest %1 ms").arg(millis(paintStats.maxPaintNanos)),
+        QStringLiteral("style cache %1 hits, %2 misses").arg(paintStats.styleCacheHits).arg(paintStats.styleCacheMisses),
+        QStringLiteral("%1 paints/s, %2 merged/s").arg(paintsPerSecond).arg(mergedPerSecond)};
+
+    painter.setFont(activePalette->style(0).font);
+    QFontMetrics const fm = painter.fontMetrics();
+    int textWidth = 0;
+    for (auto const& line : lines)
+        textWidth = std::max(textWidth, fm.horizontalAdvance(line));
+    int const margin = m_characterWidth;
+    QRect const box{pmSize.width() - textWidth - 3 * margin, margin,
+                    textWidth + 2 * margin, static_cast<int>(lines.size()) * fm.lineSpacing() + margin};
+    QColor background = m_qpalette.color(QPalette::Active, QPalette::ToolTipBase);
+    background.setAlpha(224);
+    painter.fillRect(box, background);
+    painter.setPen(m_qpalette.color(QPalette::Active, QPalette::ToolTipText));
+    painter.drawText(box.adjusted(margin, margin / 2, -margin, 0), Qt::AlignLeft | Qt::AlignTop,
+                     lines.join(QLatin1Char('\n')));
 }
 
 
@@ -518,7 +625,7 @@ void wLogTextPrivate::updateCellRange(const cell& top, const cell& bottom)
         // all of all the lines from top.line() to bottom.line();
         x = m_gutterOffset;
         y = (t->line() * m_textLineHeight) - q->verticalScrollBar()->value();
-        w = q->m_maxLineChars * m_characterWidth;
+        w = q->viewport()->width() - m_gutterOffset;
         h = (b->line() - t->line() + 1)  * m_textLineHeight;
     }
     qDebug() << __FUNCTION__ << top << bottom << x << y << w << h;
@@ -547,8 +654,9 @@ void wLogText::setUpdatesEnabled(bool newState)
 inline void wLogTextPrivate::setContentSize()
 {
     int const i = q->viewport()->size().height() / m_textLineHeight;
-    int const j =  (q->m_lineCount > i) ? ((q->m_lineCount - i) * m_textLineHeight) : 0;
-    q->verticalScrollBar()->setMaximum(j);
+    qint64 const rows = totalRows();
+    qint64 const j =  (rows > i) ? ((rows - i) * m_textLineHeight) : 0;
+    q->verticalScrollBar()->setMaximum(static_cast<int>(std::min<qint64>(j, std::numeric_limits<int>::max())));
     q->adjustHorizontalScrollBar();
 }
 
@@ -578,7 +686,17 @@ void wLogTextPrivate::adjustTextMetrics()
 
 inline auto wLogTextPrivate::firstVisibleLine() const -> int
 {
-    return q->verticalScrollBar()->value() / m_textLineHeight;
+    return yToLine(0);
+}
+
+
+auto wLogTextPrivate::longestVisibleLine() const -> int
+{
+    int longest = 0;
+    lineNumber_t const last = std::min(lastVisibleLine() + 1, q->m_lineCount);
+    for (lineNumber_t line = std::max(firstVisibleLine(), 0); line < last; ++line)
+        longest = std::max(longest, q->items.length(line));
+    return longest;
 }
 
 
@@ -590,17 +708,24 @@ inline auto wLogTextPrivate::linesPerPage() const -> int
 
 inline auto wLogTextPrivate::lastVisibleLine() const -> int
 {
-    return (q->verticalScrollBar()->value() + q->viewport()->size().height())
-              / m_textLineHeight;
+    return yToLine(q->viewport()->size().height());
 }
 
 
 void wLogText::adjustHorizontalScrollBar() const
 {
-    if (d->m_characterWidth != 0) {
+    if (d->isWrapping()) {
+        // Wrapped lines fit the view's width.
+        horizontalScrollBar()->setMaximum(0);
+    } else if (d->m_characterWidth != 0) {
         int const visibleChars = (viewport()->size().width() - d->m_gutterOffset) / d->m_characterWidth;
-        int const j = (m_maxLineChars > visibleChars ) ? (m_maxLineChars - visibleChars) : 0;
-        horizontalScrollBar()->setMaximum(j);
+        // The range covers the lines in view, rather than the longest of all
+        // lines, so a few megabyte long lines elsewhere don't shrink the
+        // slider to a sliver. It is kept wide enough for the current position,
+        // so scrolling vertically doesn't jump the view sideways.
+        int const longest = d->longestVisibleLine();
+        int const j = (longest > visibleChars ) ? (longest - visibleChars) : 0;
+        horizontalScrollBar()->setMaximum(std::max(j, horizontalScrollBar()->value()));
         horizontalScrollBar()->setPageStep( visibleChars );
         horizontalScrollBar()->setSingleStep(1);
     }
@@ -634,23 +759,37 @@ void wLogText::resizeEvent(QResizeEvent *event)
     QAbstractScrollArea::resizeEvent(event);
     d->visibleLines = viewport()->size().height() / d->m_textLineHeight;
     verticalScrollBar()->setPageStep(d->visibleLines * d->m_textLineHeight);
+    if (d->isWrapping())
+        d->setContentSize();
+}
+
+
+auto wLogText::viewportEvent(QEvent *event) -> bool
+{
+    if (event->type() == QEvent::Resize)
+        d->layoutMinimap();
+    return QAbstractScrollArea::viewportEvent(event);
 }
 
 
-// Defining our word break characters: not (alpha, numa, '_', '-'):
-static const QRegularExpression wordBreakRe(QLatin1String("[^\\w-]"));
+/** @return whether @p c is part of a word for double click selection: alpha, numeric, '_', '-' */
+static auto isWordChar(QChar c) -> bool
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_') || c == QLatin1Char('-');
+}
 
 void wLogText::mouseDoubleClickEvent(QMouseEvent *event)
 {
-    int const line = d->yToLine(event->y());
+    cell const at = d->pointToCell(event->pos());
+    int const line = at.lineNumber();
 
     if (validLineNumber(line)) {
         if (d->inTheGutter(event->x())) {
             Q_EMIT gutterDoubleClicked(line);
         } else {
-            const QString& str = items[line]->m_text;
-            const int textLen = str.length();
-            const int col=std::min(d->xToCharColumn(event->x()), textLen-1);
+            QStringView const str = items.text(line);
+            const int textLen = static_cast<int>(str.size());
+            const int col=std::min(at.columnNumber(), textLen-1);
             d->updateCaretPos(line, col);
             if (textLen) {
                 int selLeft = 0;
@@ -668,22 +807,26 @@ void wLogText::mouseDoubleClickEvent(QMouseEvent *event)
                 //   the word.  Serch left from there for the left end of the
                 //   word.
 
-                // Note in the lines below, we can use "selLeft = foundAt + 1"
-                // because find and lastIndexOf return -1 for not found, and in
-                // these cases, -1+1 = 0, which is the first column.
+                // The scans below go only as far as the word extends, so a
+                // double click in a very long line stays cheap.
+                auto const wordStart = [&str](int from) {
+                    while (from > 0 && isWordChar(str[from - 1]))
+                        --from;
+                    return from;};
 
                 if (str[col].isLetterOrNumber()) {
                     // We're starting on a word character
-                    // Search left for left word boundary
-                    selLeft = str.lastIndexOf(wordBreakRe, col) + 1;
-                    int const foundAt = str.indexOf(wordBreakRe, col);
-                    selRight = (foundAt > -1) ? foundAt : textLen;
+                    // Search left for left word boundary, and right for the right one
+                    selLeft = wordStart(col);
+                    selRight = col;
+                    while (selRight < textLen && isWordChar(str[selRight]))
+                        ++selRight;
                     haveWord = true;
                 } else if ((col > 1) && str[col-1].isLetterOrNumber()) {
                     // So we are starting on a white space.  Search left for
                     // the left-most non-whitespace before click
                     selRight = col;
-                    selLeft = str.lastIndexOf(wordBreakRe, selRight-1) + 1;
+                    selLeft = wordStart(selRight);
                     haveWord = true;
                 }
                 if (haveWord) {
@@ -763,10 +906,8 @@ void wLogText::mouseMoveEvent(QMouseEvent *event)
             d->dragState = dragStates::dragDragging;
 
             // Do not delete the mimeData or drag objects; that is handled by Qt.
-            QMimeData *mimeData = new QMimeData;
-            mimeData->setText(selectedText());
             QDrag *drag = new QDrag(this);
-            drag->setMimeData(mimeData);
+            drag->setMimeData(d->regionMimeData({d->selectTop, d->selectBottom}));
             drag->exec(Qt::CopyAction);
         }
         event->accept();
@@ -815,10 +956,11 @@ void wLogText::mouseMoveEvent(QMouseEvent *event)
         if (delta)
             d->selectScrollTimerId = startTimer(200);
 
-        const int line = std::min(d->yToLine(event->y()), m_lineCount);
+        cell const point = d->pointToCell(event->pos());
+        int const line = point.lineNumber();
         int col=0;
         if (validLineNumber(line))
-            col = std::min(d->xToCharColumn(event->x()), items[line]->m_text.length());
+            col = std::min(point.columnNumber(), items.length(line));
         cell const at(line, col);
         d->updateCaretPos(at);
         d->setSelection(at);
@@ -857,8 +999,8 @@ void wLogText::mousePressEvent(QMouseEvent *event)
         if (m_lineCount > 0) {
             d->updateCaretPos(at);
             if (validLineNumber(at.lineNumber())) {
-                if (at.columnNumber() > items[at.lineNumber()]->m_text.length())
-                    at.setColumnNumber(items[at.lineNumber()]->m_text.length());
+                if (at.columnNumber() > items.length(at.lineNumber()))
+                    at.setColumnNumber(items.length(at.lineNumber()));
             } else
                 at.setColumnNumber(0);
 
@@ -951,7 +1093,13 @@ void wLogText::wheelEvent(QWheelEvent *event)
         Q_EMIT hover(-1, -1);
     }
 
-    switch(modifiers) {
+    if (QPoint const angle = event->angleDelta(); modifiers == Qt::NoModifier && std::abs(angle.x()) > std::abs(angle.y())) {
+        // Horizontal wheel or trackpad swipe. Partial steps are accumulated,
+        // so slow swipes scroll smoothly rather than not at all.
+        d->hWheelDelta -= angle.x() * qApp->wheelScrollLines() * 2;
+        hDelta = d->hWheelDelta / 120;
+        d->hWheelDelta %= 120;
+    } else switch(modifiers) {
     case 0:
         // Normal scroll:
         vDelta = dir * qApp->wheelScrollLines() * d->m_textLineHeight;
@@ -960,10 +1108,6 @@ void wLogText::wheelEvent(QWheelEvent *event)
     case Qt::ShiftModifier:
         // Scroll page:
         vDelta = dir * vsb->pageStep();
-#ifdef TIME_DRAW_REQUEST
-        d->timeDraw = true;
-        d->drawTimer.start();
-#endif
         break;
 
     case Qt::ControlModifier | Qt::ShiftModifier:
@@ -978,8 +1122,7 @@ void wLogText::wheelEvent(QWheelEvent *event)
 
     case Qt::ControlModifier | Qt::AltModifier:
         // Scroll horizontal 1 character:
-        if (d->m_characterWidth != 0)
-            hDelta = dir * d->m_characterWidth;
+        hDelta = dir;
         break;
 
     case Qt::ControlModifier:
@@ -1071,7 +1214,150 @@ void wLogText::keyPressEvent (QKeyEvent *event)
 void wLogTextPrivate::copySelToClipboard(QClipboard::Mode cbMode) const
 {
     if (selecting)
-        QApplication::clipboard()->setText(q->selectedText(), cbMode);
+        QApplication::clipboard()->setMimeData(regionMimeData({selectTop, selectBottom}), cbMode);
+}
+
+
+template <typename Sink>
+auto wLogTextPrivate::forRegionText(region const& r, Sink&& sink) const -> void
+{
+    logTextStore const& items = q->items;
+    auto const [first, last] = std::minmax(r.first(), r.second());
+    lineNumber_t line = first.lineNumber();
+    if (line < 0 || line >= items.size())
+        return;
+    if (line == last.lineNumber()) {
+        sink(midView(items.text(line), first.columnNumber(), last.columnNumber() - first.columnNumber()));
+        return;
+    }
+
+    QStringView const newLine{u"\n"};
+    sink(midView(items.text(line), first.columnNumber(), std::numeric_limits<int>::max()));
+    sink(newLine);
+    lineNumber_t const end = std::min(last.lineNumber(), items.size());
+    for (++line; line < end; ++line) {
+        sink(items.text(line));
+        sink(newLine);
+    }
+    if (line < items.size())
+        sink(midView(items.text(line), 0, last.columnNumber()));
+}
+
+
+auto wLogTextPrivate::regionLength(region const& r) const -> qint64
+{
+    /* Summed from the line lengths, as forRegionText() would give the text,
+     * without reading it; sourced text is not decoded. */
+    logTextStore const& items = q->items;
+    auto const [first, last] = std::minmax(r.first(), r.second());
+    lineNumber_t line = first.lineNumber();
+    if (line < 0 || line >= items.size())
+        return 0;
+    auto const midLength = [](int length, int pos, int count) -> qint64 {
+        return pos >= length ? 0 : std::max(0, std::min(count, length - pos));};
+    if (line == last.lineNumber())
+        return midLength(items.length(line), first.columnNumber(), last.columnNumber() - first.columnNumber());
+
+    qint64 length = midLength(items.length(line), first.columnNumber(), std::numeric_limits<int>::max()) + 1;
+    lineNumber_t const end = std::min(last.lineNumber(), items.size());
+    for (++line; line < end; ++line)
+        length += items.length(line) + 1;
+    if (line < items.size())
+        length += midLength(items.length(line), 0, last.columnNumber());
+    return length;
+}
+
+
+auto wLogTextPrivate::regionText(region const& r) const -> QString
+{
+    qint64 const length = regionLength(r);
+    if (length > std::numeric_limits<int>::max()) {
+        qWarning() << "text of" << r << "is too long for a string:" << length << "characters";
+        return {};
+    }
+    QString text;
+    text.reserve(static_cast<int>(length));
+    forRegionText(r, [&text](QStringView piece) {text.append(piece.data(), static_cast<int>(piece.size()));});
+    return text;
+}
+
+
+auto wLogTextPrivate::writeRegion(QIODevice& device, region const& r) const -> bool
+{
+    QString block;
+    block.reserve(writeBlockChars);
+    bool ok = true;
+    auto const flush = [&]() {
+        ok = ok && device.write(block.toUtf8()) >= 0;
+        block.resize(0);};
+    forRegionText(r, [&](QStringView piece) {
+        // Long lines go in block sized pieces, so no block outgrows the reserve.
+        while (ok && !piece.isEmpty()) {
+            auto const part = midView(piece, 0, writeBlockChars - block.size());
+            block.append(part.data(), static_cast<int>(part.size()));
+            piece = piece.mid(part.size());
+            if (block.size() >= writeBlockChars)
+                flush();
+        }});
+    flush();
+    return ok;
+}
+
+
+auto wLogTextPrivate::regionMimeData(region const& r) const -> QMimeData *
+{
+    if (regionLength(r) <= lazyCopyChars) {
+        auto mimeData = new QMimeData;
+        mimeData->setText(regionText(r));
+        return mimeData;
+    }
+    std::erase_if(lazyCopies, [](auto const& copy) {return copy.isNull();});
+    auto const [first, last] = std::minmax(r.first(), r.second());
+    logTextStore const& items = q->items;
+    auto mimeData = new selectionMimeData(this, {items.generation(), items.key(first.lineNumber()), first.columnNumber(),
+                                                 items.key(last.lineNumber()), last.columnNumber()});
+    lazyCopies.emplace_back(mimeData);
+    return mimeData;
+}
+
+
+auto wLogTextPrivate::keyedRegionText(keyedRegion const& k) const -> std::optional<QString>
+{
+    logTextStore const& items = q->items;
+    auto const first = items.lineOf(k.firstKey, k.generation);
+    auto const last = items.lineOf(k.lastKey, k.generation);
+    if (!first || !last)
+        return std::nullopt;
+    return regionText({cell{*first, k.firstColumn}, cell{*last, k.lastColumn}});
+}
+
+
+void wLogTextPrivate::releaseCopies()
+{
+    for (auto const& copy : lazyCopies) {
+        if (copy)
+            copy->release();
+    }
+    lazyCopies.clear();
+}
+
+
+auto selectionMimeData::formats() const -> QStringList
+{
+    return {QStringLiteral("text/plain")};
+}
+
+
+auto selectionMimeData::retrieveData(QString const& mimeType, QVariant::Type type) const -> QVariant
+{
+    if (mimeType != QLatin1String("text/plain"))
+        return QMimeData::retrieveData(mimeType, type);
+    auto text = d ? d->keyedRegionText(m_selection) : std::nullopt;
+    if (!text) {
+        qWarning() << "the copied lines are no longer in the view";
+        return QString{};
+    }
+    return *text;
 }
 
 
@@ -1114,7 +1400,7 @@ void wLogText::setCaretPosition(lineNumber_t line, int col)
 
     // If l is a valid line number (i.e. not lastLine + 1), get its text length.
     // Otherwise use zero.
-    const int textlen = validLineNumber(l) ? items[l]->m_text.length() : 0;
+    const int textlen = validLineNumber(l) ? items.length(l) : 0;
 
     // If new column (p.x()) is beyond the end of the line, use line length.
     int c = std::min(col, textlen);
@@ -1207,48 +1493,32 @@ QString wLogText::selectedText() const
     if (!d->selecting) {
         return QString();
     }
-
-    QString selText;
-    int line = d->selectTop.lineNumber();
-    int last = std::min(d->selectBottom.lineNumber(), m_lineCount);
-    if (last < line)
-        qSwap(last, line);
-    if (line == last) {
-        selText = items[line]->m_text.mid(d->selectTop.columnNumber(), d->selectBottom.columnNumber() - d->selectTop.columnNumber());
-        ++line;
-    } else {
-        logItemsImplCIt it, end;
-        int nItems = items.size();
-        if (line < nItems) {
-            it = items.cbegin() + line;
-            end = (last < nItems) ? (items.cbegin() + last) : items.cend();
-        } else {
-            end = items.cend();
-            it = end;
-        }
-        if ((it != items.cend()) && d->selectTop.columnNumber() > 0) {
-            selText = (*it)->m_text.mid(d->selectTop.columnNumber()) + QLatin1Char('\n');
-            ++it;
-        }
-
-        for (; it != end; ++it) {
-            selText += (*it)->m_text + QLatin1Char('\n');
-        }
-        if ((it != items.cend()) && last < m_lineCount) {
-            selText += (*it)->m_text.left(d->selectBottom.columnNumber());
-        }
-    }
-    return selText;
+    return d->regionText({d->selectTop, d->selectBottom});
 }
 
 QString wLogText::toPlainText(QLatin1Char sep) const
 {
     QString ret;
-    for (auto const& item : items)
-        ret += item->m_text + sep;
+    ret.reserve(static_cast<int>(std::min<qint64>(d->regionLength({cell{0, 0}, cell{m_lineCount, 0}}),
+                                                  std::numeric_limits<int>::max())));
+    for (lineNumber_t line = 0; line < items.size(); ++line) {
+        auto const text = items.text(line);
+        ret.append(text.data(), static_cast<int>(text.size()));
+        ret += sep;
+    }
     return ret;
 }
 
+auto wLogText::writeSelectedText(QIODevice& device) const -> bool
+{
+    return !d->selecting || d->writeRegion(device, {d->selectTop, d->selectBottom});
+}
+
+auto wLogText::writeText(QIODevice& device) const -> bool
+{
+    return d->writeRegion(device, {cell{0, 0}, cell{m_lineCount, 0}});
+}
+
 void wLogText::copy() const
 {
     if (d->selecting) {
@@ -1443,7 +1713,7 @@ void wLogText::shrinkFont()
 
 auto wLogText::length(lineNumber_t lineNumber) const -> int
 {
-    return validLineNumber(lineNumber) ? items[lineNumber]->m_text.length() : 0;
+    return validLineNumber(lineNumber) ? items.length(lineNumber) : 0;
 }
 
 
@@ -1457,39 +1727,293 @@ void wLogText::setMaxLogLines(lineNumber_t mll)
 {
     // Treat <= 0 as unlimited:
     maximumLogLines = mll;
+    maximumLogLinesSlacked = slackedLineLimit(mll);
+
+    // Now would be a good time to trim:
+    if (mll > 0)
+        trimLines();
+}
 
-    if (mll <= 0) {
-        maximumLogLinesSlacked = std::numeric_limits<lineNumber_t>::max();
+void logTextStore::append(logTextItem const& item)
+{
+    lineKey_t const lineKey = key(size());
+    if (m_source) {
+        Q_ASSERT(item.m_sourcedLength >= 0);
+        m_offsets.push_back(m_offsets.back() + static_cast<size_t>(std::max(item.m_sourcedLength, 0)));
     } else {
-        // Calculate a slack value:
-        maximumLogLinesSlacked = mll + qBound(10, mll/10, 1000);
+        m_text.insert(m_text.end(), item.m_text.cbegin(), item.m_text.cend());
+        m_offsets.push_back(m_text.size());
+    }
+    m_styles.push_back(item.m_styleId);
+    m_markers.push_back(item.m_markers);
+    m_tags.push_back(item.m_tag);
+    if (item.m_markers != 0) [[unlikely]]
+        ++m_markedLines;
+    if (item.m_pixmapId) [[unlikely]]
+        m_pixmaps.insert(lineKey, *item.m_pixmapId);
+    if (item.m_badge != 0) [[unlikely]]
+        m_badges.insert(lineKey, item.m_badge);
+}
 
-        // Check for overflow maxint:
-        if (maximumLogLinesSlacked <= mll)
-            maximumLogLinesSlacked = std::numeric_limits<lineNumber_t>::max();
-        // Now would be a good time to trim:
-        trimLines();
+/** @brief reserve room for @p more elements beyond the size of @p v, keeping geometric growth */
+template <typename T>
+static auto reserveMore(std::vector<T>& v, size_t more)
+{
+    if (v.size() + more > v.capacity())
+        v.reserve(std::max(v.size() + more, 2 * v.capacity()));
+}
+
+void logTextStore::reserve(lineNumber_t lines, size_t chars)
+{
+    auto const count = static_cast<size_t>(lines);
+    if (!m_source)
+        reserveMore(m_text, chars);
+    reserveMore(m_offsets, count);
+    reserveMore(m_styles, count);
+    reserveMore(m_markers, count);
+    reserveMore(m_tags, count);
+}
+
+void logTextStore::setMarkers(lineNumber_t line, markerMask_t markers)
+{
+    auto& lineMarkers = m_markers[at(line)];
+    m_markedLines += (markers != 0) - (lineMarkers != 0);
+    lineMarkers = markers;
+}
+
+void logTextStore::keepMarkers(markerMask_t keep)
+{
+    m_markedLines = 0;
+    for (auto n = at(0); n < m_markers.size(); ++n)
+        m_markedLines += (m_markers[n] &= keep) != 0;
+}
+
+/** @brief remove the entries of @p map keyed before @p first */
+template <typename K, typename T>
+static auto eraseKeysBefore(QHash<K, T>& map, K first)
+{
+    for (auto it = map.begin(); it != map.end();) {
+        if (it.key() < first)
+            it = map.erase(it);
+        else
+            ++it;
     }
 }
 
-static auto findMaxLineLength(logItemsImplList const& items)
+/** @return @p map with the keys in [first, first + count) removed, and later keys moved down by @p count */
+template <typename K, typename T>
+static auto eraseKeys(QHash<K, T> const& map, K first, K count)
 {
-    if (items.empty())
-        return 0;
-    auto test = [](logTextItemCPtr x, logTextItemCPtr y) {return x->text().length() < y->text().length();};
-    return (*std::ranges::max_element(items, test))->text().length();
+    QHash<K, T> erased;
+    erased.reserve(map.size());
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        if (it.key() < first)
+            erased.insert(it.key(), it.value());
+        else if (it.key() >= first + count)
+            erased.insert(it.key() - count, it.value());
+    }
+    return erased;
+}
+
+void logTextStore::erase(lineNumber_t first, lineNumber_t count)
+{
+    for (lineNumber_t line = first; line < first + count; ++line)
+        m_markedLines -= m_markers[at(line)] != 0;
+
+    if (first == 0) {
+        // Drop the lines by advancing the head; compact when they outnumber the rest.
+        m_head += count;
+        m_base += count;
+        if (m_head >= std::max(size(), lineNumber_t{1024}))
+            compact();
+        return;
+    }
+
+    compact();
+    ++m_generation;
+    auto const begin = at(first);
+    auto const end = at(first + count);
+    size_t const textBegin = m_offsets[begin];
+    size_t const textCount = m_offsets[end] - textBegin;
+    if (!m_source)
+        m_text.erase(m_text.begin() + static_cast<ptrdiff_t>(textBegin),
+                     m_text.begin() + static_cast<ptrdiff_t>(textBegin + textCount));
+    m_offsets.erase(m_offsets.begin() + static_cast<ptrdiff_t>(begin + 1),
+                    m_offsets.begin() + static_cast<ptrdiff_t>(end + 1));
+    for (size_t n = begin + 1; n < m_offsets.size(); ++n)
+        m_offsets[n] -= textCount;
+
+    auto const eraseRange = [begin,end](auto& v) {
+        v.erase(v.begin() + static_cast<ptrdiff_t>(begin), v.begin() + static_cast<ptrdiff_t>(end));};
+    eraseRange(m_styles);
+    eraseRange(m_markers);
+    eraseRange(m_tags);
+    if (!m_pixmaps.isEmpty())
+        m_pixmaps = eraseKeys(m_pixmaps, key(first), lineKey_t{count});
+    if (!m_badges.isEmpty())
+        m_badges = eraseKeys(m_badges, key(first), lineKey_t{count});
+}
+
+void logTextStore::compact()
+{
+    if (m_head == 0)
+        return;
+    auto const head = static_cast<ptrdiff_t>(m_head);
+    size_t const textStart = m_offsets[static_cast<size_t>(m_head)];
+    if (!m_source)
+        m_text.erase(m_text.begin(), m_text.begin() + static_cast<ptrdiff_t>(textStart));
+    m_offsets.erase(m_offsets.begin(), m_offsets.begin() + head);
+    for (auto& offset : m_offsets)
+        offset -= textStart;
+    m_styles.erase(m_styles.begin(), m_styles.begin() + head);
+    m_markers.erase(m_markers.begin(), m_markers.begin() + head);
+    m_tags.erase(m_tags.begin(), m_tags.begin() + head);
+    eraseKeysBefore(m_pixmaps, m_base);
+    eraseKeysBefore(m_badges, m_base);
+    m_head = 0;
+}
+
+void logTextStore::clear()
+{
+    /* Swap with empty vectors, so the buffers are released rather than kept at capacity. */
+    std::vector<QChar>{}.swap(m_text);
+    std::vector<size_t>{0}.swap(m_offsets);
+    std::vector<styleId_t>{}.swap(m_styles);
+    std::vector<markerMask_t>{}.swap(m_markers);
+    std::vector<quintptr>{}.swap(m_tags);
+    m_pixmaps.clear();
+    m_badges.clear();
+    m_head = 0;
+    m_base = 0;
+    m_markedLines = 0;
+    ++m_generation;
+}
+
+auto logTextStore::sourceText(lineNumber_t line) const -> QStringView
+{
+    /* Parallel finds read lines on several threads, so each decodes into its
+     * own buffers; a ring, so a caller comparing two lines holds both. */
+    thread_local std::array<QString, sourcedTextViews> decoded;
+    thread_local size_t next = 0;
+    QString& buffer = decoded[next];
+    next = (next + 1) % sourcedTextViews;
+    buffer = m_source(tag(line));
+    return buffer;
+}
+
+void logTextStore::shrinkToFit()
+{
+    compact();
+    m_text.shrink_to_fit();
+    m_offsets.shrink_to_fit();
+    m_styles.shrink_to_fit();
+    m_markers.shrink_to_fit();
+    m_tags.shrink_to_fit();
+    m_pixmaps.squeeze();
+    m_badges.squeeze();
+}
+
+/** @return the pool wrap indexing runs on; it is bulk work, kept off the filtering and interactive lanes */
+static auto indexPool() -> QThreadPool*
+{
+    return workScheduler::instance().pool(workLane::background);
+}
+
+void wrapIndex::update(logTextStore const& store, int columns)
+{
+    lineNumber_t const count = store.size();
+    if (count < lines())        // Lines erased other than from the front
+        clear();
+
+    if (columns != m_columns) {
+        // Lines shorter than both widths keep their single row, so re-wrap
+        // from the first line whose row count changes.
+        size_t const indexed = static_cast<size_t>(lines());
+        auto const ranges = splitRanges(indexed, 4096, indexPool());
+        std::vector<size_t> firstChanged(ranges.size(), indexed);
+        blockingMapRanges(indexPool(), ranges, [&](indexRange const& r) {
+            for (size_t n = r.first; n < r.second; ++n) {
+                row_t const had = m_prefix[m_head + n + 1] - m_prefix[m_head + n];
+                if (had != rowsOf(store.length(static_cast<lineNumber_t>(n)), columns)) {
+                    firstChanged[static_cast<size_t>(&r - ranges.data())] = n;
+                    break;
+                }
+            }});
+        size_t const first = firstChanged.empty() ? 0 : *std::min_element(firstChanged.begin(), firstChanged.end());
+        m_prefix.resize(m_head + first + 1);
+        m_columns = columns;
+    }
+
+    if (lines() < count)
+        indexLines(store, lines(), count);
+}
+
+
+void wrapIndex::indexLines(logTextStore const& store, lineNumber_t first, lineNumber_t last)
+{
+    // Two parallel passes: the rows of each line, and the chunk totals; then
+    // each chunk's prefix sums from the total of the chunks before it.
+    size_t const base = m_head + static_cast<size_t>(first);
+    size_t const count = static_cast<size_t>(last - first);
+    m_prefix.resize(base + count + 1);
+    auto const ranges = splitRanges(count, 4096, indexPool());
+    std::vector<row_t> totals(ranges.size());
+    blockingMapRanges(indexPool(), ranges, [&](indexRange const& r) {
+        row_t total = 0;
+        for (size_t n = r.first; n < r.second; ++n) {
+            row_t const rows = rowsOf(store.length(first + static_cast<lineNumber_t>(n)), m_columns);
+            m_prefix[base + n + 1] = rows;
+            total += rows;
+        }
+        totals[static_cast<size_t>(&r - ranges.data())] = total;});
+
+    std::exclusive_scan(totals.begin(), totals.end(), totals.begin(), m_prefix[base]);
+    blockingMapRanges(indexPool(), ranges, [&](indexRange const& r) {
+        row_t sum = totals[static_cast<size_t>(&r - ranges.data())];
+        for (size_t n = r.first; n < r.second; ++n)
+            m_prefix[base + n + 1] = sum += m_prefix[base + n + 1];});
 }
 
+
+void wrapIndex::eraseFront(lineNumber_t count)
+{
+    if (count >= lines()) {
+        clear();
+        return;
+    }
+    m_head += static_cast<size_t>(count);
+    if (m_head >= std::max(static_cast<size_t>(lines()), size_t{1024})) {
+        m_prefix.erase(m_prefix.begin(), m_prefix.begin() + static_cast<std::ptrdiff_t>(m_head));
+        m_head = 0;
+    }
+}
+
+
+void wrapIndex::clear()
+{
+    m_prefix.assign(1, 0);
+    m_head = 0;
+}
+
+
+auto wrapIndex::lineAt(row_t row) const -> std::pair<lineNumber_t, int>
+{
+    if (row >= rows())
+        return {lines(), 0};
+    row_t const target = m_prefix[m_head] + std::max<row_t>(row, 0);
+    auto const next = std::upper_bound(m_prefix.begin() + static_cast<std::ptrdiff_t>(m_head), m_prefix.end(), target);
+    auto const line = static_cast<lineNumber_t>(next - m_prefix.begin() - static_cast<std::ptrdiff_t>(m_head)) - 1;
+    return {line, static_cast<int>(target - *std::prev(next))};
+}
+
+
 void wLogText::trimLines()
 {
     if (maximumLogLines > 0 && static_cast<int>(items.size()) > maximumLogLines) {
         int const toRemove = items.size() - maximumLogLines;
-        auto const begin = items.begin();
-        auto const end = begin + toRemove;
-        std::for_each(begin, end, [](auto item) {delete item;});
-        items.erase(begin, end);
+        items.erase(0, toRemove);
+        d->wrapRows.eraseFront(toRemove);
         m_lineCount = items.size();
-        m_maxLineChars = findMaxLineLength(items);
 
         // Adjust selection:
         if (d->selecting) {
@@ -1508,6 +2032,7 @@ void wLogText::trimLines()
             }
         }
 
+        d->rebuildMarkerBins();
         Q_EMIT trimmed(toRemove);
         d->m_maxVScroll = 0;
         d->setContentSize();
@@ -1539,7 +2064,9 @@ void wLogText::vScrollChange(int value)
             d->setSoftLock(false);
         }
     }
+    adjustHorizontalScrollBar();
     viewport()->update();
+    d->minimap->update();
 }
 
 
@@ -1552,8 +2079,12 @@ void wLogText::hScrollChange(int value)
 
 inline QPoint wLogTextPrivate::cellToPoint(const cell& c) const
 {
-    int const y = c.lineNumber() * m_textLineHeight;
-    int const x = c.columnNumber() * m_characterWidth + m_gutterOffset;
+    qint64 const row = cellToRow(c);
+    int const y = static_cast<int>(row * m_textLineHeight);
+    int column = c.columnNumber();
+    if (isWrapping())
+        column -= static_cast<int>(row - lineToRow(c.lineNumber())) * wrapColumns();
+    int const x = column * m_characterWidth + m_gutterOffset;
     return QPoint(x, y);
 }
 
@@ -1576,7 +2107,65 @@ inline auto wLogTextPrivate::xToCharColumn(int x) const -> int
 
 inline auto wLogTextPrivate::yToLine(int y) const -> int
 {
-    return (q->verticalScrollBar()->value() + std::max(y, 0)) / m_textLineHeight;
+    qint64 const row = (q->verticalScrollBar()->value() + std::max(y, 0)) / m_textLineHeight;
+    if (!isWrapping())
+        return static_cast<int>(row);
+    return wrapped().lineAt(row).first;
+}
+
+
+auto wLogTextPrivate::pointToCell(QPoint const& point) const -> cell
+{
+    qint64 const row = (q->verticalScrollBar()->value() + std::max(point.y(), 0)) / m_textLineHeight;
+    int const col = xToCharColumn(point.x());
+    if (!isWrapping())
+        return {static_cast<lineNumber_t>(std::min<qint64>(row, q->m_lineCount)), col};
+
+    // The column is within the row's part of the line, so doesn't run on
+    // into the next row.
+    auto const [line, subRow] = wrapped().lineAt(row);
+    int const wrapCols = wrapColumns();
+    return {line, subRow * wrapCols + std::min(col, wrapCols - 1)};
+}
+
+
+auto wLogTextPrivate::wrapColumns() const -> int
+{
+    if (m_characterWidth == 0)
+        return 0;
+    return std::max(minWrapColumns, (q->viewport()->size().width() - m_gutterOffset) / m_characterWidth);
+}
+
+
+auto wLogTextPrivate::wrapped() const -> wrapIndex const&
+{
+    wrapRows.update(q->items, wrapColumns());
+    return wrapRows;
+}
+
+
+auto wLogTextPrivate::totalRows() const -> qint64
+{
+    return isWrapping() ? wrapped().rows() : q->m_lineCount;
+}
+
+
+auto wLogTextPrivate::lineToRow(lineNumber_t line) const -> qint64
+{
+    if (!isWrapping())
+        return line;
+    auto const& index = wrapped();
+    return index.rowOf(std::clamp(line, 0, index.lines()));
+}
+
+
+auto wLogTextPrivate::cellToRow(cell const& c) const -> qint64
+{
+    qint64 const row = lineToRow(c.lineNumber());
+    if (!isWrapping() || !q->validLineNumber(c.lineNumber()))
+        return row;
+    auto const rows = wrapIndex::rowsOf(q->items.length(c.lineNumber()), wrapColumns());
+    return row + std::min<qint64>(c.columnNumber() / wrapColumns(), rows - 1);
 }
 
 
@@ -1589,8 +2178,8 @@ void wLogText::ensureCaretVisible()
         // however the scroll bar maximum is based on total lines - lines per
         // page.  So while intuitively you want '+ linesPerPage/2', when
         // you subtract linesPerPage from the total, you get '- linesPerPage/2'.
-        verticalScrollBar()->setValue(
-                (line - (d->linesPerPage()/2)) * d->m_textLineHeight);
+        verticalScrollBar()->setValue(static_cast<int>(
+                (d->lineToRow(line) - (d->linesPerPage()/2)) * d->m_textLineHeight));
     }
 }
 
@@ -1617,18 +2206,26 @@ void wLogText::setShowCaret(bool show)
 void wLogText::clear()
 {
     d->selecting= false;
-    qDeleteAll(items);
     items.clear();
+    d->wrapRows.clear();
     m_lineCount = 0;
-    m_maxLineChars = 0;
     d->m_maxVScroll = 0;
     d->setSoftLock(false);
     d->setHardLock(false);
     d->caretPosition = cell(0, 0);
+    d->markerBins.reset();
+    d->minimap->update();
     d->setContentSize();
 }
 
 
+void wLogText::setTextSource(logTextStore::textSource source)
+{
+    clear();
+    items.setTextSource(std::move(source));
+}
+
+
 void wLogText::clear(int top, int count)
 {
     d->selecting = false;
@@ -1638,16 +2235,14 @@ void wLogText::clear(int top, int count)
     if ((top + count) > m_lineCount)
         count = m_lineCount - top;
 
-    auto const begin = items.begin() + top;
-    auto const end = begin + count;
-    std::for_each(begin, end, [](auto item) { delete item; });
-    items.erase(begin, end);
+    items.erase(top, count);
+    d->wrapRows.clear();
     if (finalized)
-        items.shrink_to_fit();
+        items.shrinkToFit();
 
     d->m_maxVScroll = 0;
     m_lineCount = items.size();
-    m_maxLineChars = findMaxLineLength(items);
+    d->rebuildMarkerBins();
 
     d->caretPosition = cell(0, 0);
     d->setContentSize();
@@ -1684,11 +2279,10 @@ auto wLogText::find(const QString& str, cell *at,
     auto [lineNumber, col] = pos;
 
     bool match = false;
-    auto it = items.cbegin() + lineNumber;
     if (forward) {
 qWarning() << __func__ << "fwd start:" << pos << *at;
-        for (auto const end=items.cend(); it != end; ++it, ++lineNumber) {
-            col = (*it)->m_text.indexOf(str, col, caseSensitive);
+        for (lineNumber_t const end = items.size(); lineNumber < end; ++lineNumber) {
+            col = static_cast<int>(items.text(lineNumber).indexOf(str, col, caseSensitive));
             match = (col != -1);
             if (match) {
                 int end = col + str.length();
@@ -1701,8 +2295,8 @@ qWarning() << __func__ << "match:" << col << end << caretPosition() << getSelect
         }
     } else {
 qWarning() << __func__ << "rev start:" << pos << *at;
-        for (auto const end = items.cbegin(); it != end; --it, --lineNumber) {
-            col = (*it)->m_text.lastIndexOf(str, col, caseSensitive);
+        for (; lineNumber >= 0; --lineNumber) {
+            col = static_cast<int>(items.text(lineNumber).lastIndexOf(str, col, caseSensitive));
             match = (col != -1);
             if (match) {
                 int end = col + str.length();
@@ -1758,11 +2352,14 @@ auto wLogText::find(QRegularExpression const& re, cell *at, bool forward) -> boo
 
     bool matched=false;
     auto [lineNumber, col] = pos;
-    auto it = items.cbegin() + lineNumber;
+    /* QRegularExpression matches a QString; wrap the stored text without copying it. */
+    auto const lineText = [this](lineNumber_t line) {
+        auto const text = items.text(line);
+        return QString::fromRawData(text.data(), static_cast<int>(text.size()));};
     if (forward) {
-        for (auto const end=items.cend(); it != end; ++it, ++lineNumber) {
+        for (lineNumber_t const end = items.size(); lineNumber < end; ++lineNumber) {
             QRegularExpressionMatch match;
-            col = (*it)->m_text.indexOf(re, col, &match);
+            col = lineText(lineNumber).indexOf(re, col, &match);
             matched = (col != -1);
             if (matched) {
                 d->updateCaretPos(cell(lineNumber, col + match.capturedLength()));
@@ -1772,9 +2369,9 @@ auto wLogText::find(QRegularExpression const& re, cell *at, bool forward) -> boo
             col = 0;
         }
     } else {
-        for (auto it=items.cbegin() + lineNumber; lineNumber >= 0; --it, --lineNumber) {
+        for (; lineNumber >= 0; --lineNumber) {
             QRegularExpressionMatch match;
-            col = (*it)->m_text.lastIndexOf(re, col, &match);
+            col = lineText(lineNumber).lastIndexOf(re, col, &match);
             matched = (col != -1);
             if (matched) {
                 d->updateCaretPos(cell(lineNumber, col));
@@ -1802,7 +2399,7 @@ auto wLogTextPrivate::prepareFind(bool forward, cell& pos, const cell *at) const
         pos.setLineNumber(q->m_lineCount - 1);
         pos.setColumnNumber(-1);
     }
-    int const lineLen = q->items[pos.lineNumber()]->text().length();
+    int const lineLen = q->items.length(pos.lineNumber());
     if (pos.columnNumber() >= lineLen)
         pos.setColumnNumber(lineLen - 1);
     return true;
@@ -1830,7 +2427,7 @@ void wLogText::clearPixmap(pixmapId_t pixmapId) noexcept
 void wLogText::clearLinePixmap(lineNumber_t lineNo) noexcept
 {
     if (validLineNumber(lineNo)) {
-        items[lineNo]->clearPixmap();
+        items.setPixmap(lineNo, std::nullopt);
         if (updatesEnabled() && d->gutterWidth > 0) {
             setUpdatesNeeded(updateFull);
             update(0, lineNo * d->m_textLineHeight, d->gutterWidth,
@@ -1844,7 +2441,7 @@ void wLogText::clearLinePixmap(lineNumber_t lineNo) noexcept
 void wLogText::setLinePixmap(lineNumber_t lineNo, pixmapId_t pixmapId) noexcept
 {
     if (validLineNumber(lineNo)) {
-        items[lineNo]->m_pixmapId = pixmapId;
+        items.setPixmap(lineNo, pixmapId);
         if (updatesEnabled() && d->gutterWidth > 0) {
             setUpdatesNeeded(updateFull);
             update(0, lineNo * d->m_textLineHeight, d->gutterWidth,
@@ -1855,6 +2452,277 @@ void wLogText::setLinePixmap(lineNumber_t lineNo, pixmapId_t pixmapId) noexcept
 }
 
 
+void wLogText::addLineMarkers(lineNumber_t lineNo, markerMask_t markers)
+{
+    d->markerBins.update(lineNo, markers, true);
+}
+
+
+void wLogText::setLineMarkers(lineNumber_t lineNo, markerMask_t markers)
+{
+    if (validLineNumber(lineNo)) {
+        if (auto const old = items.markers(lineNo); old != markers) {
+            d->markerBins.update(lineNo, old, false);
+            items.setMarkers(lineNo, markers);
+            d->markerBins.update(lineNo, markers, true);
+            d->minimap->update();
+        }
+    }
+}
+
+
+auto wLogText::lineMarkers(lineNumber_t lineNo) const noexcept -> markerMask_t
+{
+    return validLineNumber(lineNo) ? items.markers(lineNo) : 0;
+}
+
+
+void wLogText::setChannelMarkers(int channel, std::vector<lineNumber_t> const& lines)
+{
+    if (channel < 0 || channel >= markerChannels)
+        return;
+    auto const bit = static_cast<markerMask_t>(1u << channel);
+    auto const keep = static_cast<markerMask_t>(~bit);
+    items.keepMarkers(keep);
+    d->markerBins.clearChannel(channel);
+    for (auto const lineNo : lines) {
+        if (validLineNumber(lineNo)) {
+            items.setMarkers(lineNo, items.markers(lineNo) | bit);
+            d->markerBins.update(lineNo, bit, true);
+        }
+    }
+    d->minimap->update();
+}
+
+
+void wLogText::setMarkerColor(int channel, QColor const& color)
+{
+    if (channel >= 0 && channel < markerChannels) {
+        d->markerColors[channel] = color;
+        d->minimap->update();
+    }
+}
+
+
+void wLogText::setMinimapVisible(bool visible)
+{
+    d->minimap->setVisible(visible);
+    setViewportMargins(0, 0, visible ? minimapWidth : 0, 0);
+    d->layoutMinimap();
+}
+
+
+auto wLogText::minimapVisible() const -> bool
+{
+    return !d->minimap->isHidden();
+}
+
+
+void wLogText::setWrapLines(bool wrap)
+{
+    if (wrap == d->wrapping)
+        return;
+    lineNumber_t const top = d->firstVisibleLine();
+    d->wrapping = wrap;
+    if (!wrap)
+        d->wrapRows.clear();
+    d->setContentSize();
+    horizontalScrollBar()->setValue(0);
+    verticalScrollBar()->setValue(static_cast<int>(d->lineToRow(top) * d->m_textLineHeight));
+    viewport()->update();
+    d->minimap->update();
+}
+
+
+auto wLogText::wrapLines() const -> bool
+{
+    return d->wrapping;
+}
+
+
+auto wLogText::paintStats() const -> logTextPaintStats
+{
+    return d->paintStats;
+}
+
+
+void wLogText::resetPaintStats()
+{
+    d->paintStats = {};
+    d->statsMark = {};
+    d->statsClock.invalidate();
+    d->paintsPerSecond = 0;
+    d->mergedPerSecond = 0;
+}
+
+
+void wLogText::setPaintStatsOverlay(bool show)
+{
+    d->showPaintStats = show;
+    viewport()->update();
+}
+
+
+auto wLogText::paintStatsOverlay() const -> bool
+{
+    return d->showPaintStats;
+}
+
+
+void minimapBins::reset()
+{
+    m_linesPerBin = 1;
+    std::ranges::fill(bins, counts{});
+}
+
+
+void minimapBins::update(lineNumber_t lineNo, markerMask_t markers, bool add)
+{
+    // Double the bin size until the line fits, merging adjacent bins:
+    while (static_cast<size_t>(lineNo / m_linesPerBin) >= binCount) {
+        for (size_t n = 0; n < binCount / 2; ++n) {
+            for (int c = 0; c < markerChannels; ++c)
+                bins[n][c] = bins[2 * n][c] + bins[2 * n + 1][c];
+        }
+        std::fill(bins.begin() + binCount / 2, bins.end(), counts{});
+        m_linesPerBin *= 2;
+    }
+
+    auto& bin = bins[static_cast<size_t>(lineNo / m_linesPerBin)];
+    for (int c = 0; c < markerChannels; ++c) {
+        if (markers & (1u << c)) {
+            if (add)
+                ++bin[c];
+            else if (bin[c] > 0)
+                --bin[c];
+        }
+    }
+}
+
+
+void minimapBins::clearChannel(int channel)
+{
+    for (auto& bin : bins)
+        bin[channel] = 0;
+}
+
+
+void wLogTextPrivate::rebuildMarkerBins()
+{
+    markerBins.reset();
+    auto const& items = q->items;
+    if (items.markedLines() != 0) {
+        for (lineNumber_t n = 0; n < items.size(); ++n) {
+            if (auto const markers = items.markers(n); markers != 0)
+                markerBins.update(n, markers, true);
+        }
+    }
+    minimap->update();
+}
+
+
+void wLogTextPrivate::layoutMinimap()
+{
+    if (minimap && !minimap->isHidden()) {
+        QRect const vp = q->viewport()->geometry();
+        minimap->setGeometry(vp.right() + 1, vp.top(), minimapWidth, vp.height());
+    }
+}
+
+
+void wLogTextPrivate::drawMinimap(QPainter& painter, QRect const& bounds) const
+{
+    painter.fillRect(bounds, m_qpalette.color(QPalette::Active, QPalette::Window));
+    qint64 const lineCount = q->m_lineCount;
+    int const height = bounds.height();
+    if (lineCount <= 0 || height <= 0)
+        return;
+    auto const toY = [lineCount, height](qint64 line) {
+        return static_cast<int>(std::min(line, lineCount) * height / lineCount);};
+
+    // The visible part of the text:
+    int const top = toY(firstVisibleLine());
+    int const bottom = std::max(top + 1, toY(lastVisibleLine() + 1));
+    QColor visible = m_qpalette.color(QPalette::Active, QPalette::Highlight);
+    visible.setAlpha(64);
+    painter.fillRect(bounds.left(), bounds.top() + top, bounds.width(), bottom - top, visible);
+
+    std::array<int, markerChannels> columns;
+    int activeChannels = 0;
+    for (int c = 0; c < markerChannels; ++c)
+        columns[c] = markerColors[c].isValid() ? activeChannels++ : -1;
+    if (activeChannels == 0)
+        return;
+
+    // Sum the bins into pixel rows; a bin spanning several rows adds to each.
+    std::vector<minimapBins::counts> rows(static_cast<size_t>(height));
+    std::vector<qint64> rowLines(static_cast<size_t>(height));
+    qint64 const linesPerBin = markerBins.linesPerBin();
+    size_t const usedBins = std::min<size_t>(minimapBins::binCount,
+                                             static_cast<size_t>((lineCount + linesPerBin - 1) / linesPerBin));
+    for (size_t b = 0; b < usedBins; ++b) {
+        qint64 const first = static_cast<qint64>(b) * linesPerBin;
+        qint64 const last = std::min(first + linesPerBin, lineCount);
+        int const y0 = std::min(toY(first), height - 1);
+        int const y1 = std::max(y0 + 1, toY(last));
+        auto const& counts = markerBins.bin(b);
+        for (int y = y0; y < y1; ++y) {
+            auto& row = rows[static_cast<size_t>(y)];
+            for (int c = 0; c < markerChannels; ++c)
+                row[c] += counts[c];
+            rowLines[static_cast<size_t>(y)] += last - first;
+        }
+    }
+
+    int const columnWidth = std::max(1, bounds.width() / activeChannels);
+    for (int y = 0; y < height; ++y) {
+        auto const& row = rows[static_cast<size_t>(y)];
+        for (int c = 0; c < markerChannels; ++c) {
+            if (columns[c] < 0 || row[c] == 0)
+                continue;
+            // Square root, so sparse markers remain visible beside dense ones
+            double const density = std::min(1.0, static_cast<double>(row[c]) /
+                                                 static_cast<double>(std::max<qint64>(rowLines[static_cast<size_t>(y)], 1)));
+            QColor color = markerColors[c];
+            color.setAlpha(96 + static_cast<int>(159.0 * std::sqrt(density)));
+            painter.fillRect(bounds.left() + columns[c] * columnWidth, bounds.top() + y, columnWidth, 1, color);
+        }
+    }
+}
+
+
+void wLogTextPrivate::minimapJump(int y)
+{
+    int const height = minimap->height();
+    if (height <= 0 || q->m_lineCount <= 0)
+        return;
+    auto const line = static_cast<lineNumber_t>(
+        static_cast<qint64>(std::clamp(y, 0, height - 1)) * q->m_lineCount / height);
+    q->verticalScrollBar()->setValue(static_cast<int>((lineToRow(line) - linesPerPage() / 2) * m_textLineHeight));
+}
+
+
+void logTextMinimap::paintEvent([[maybe_unused]] QPaintEvent *event)
+{
+    QPainter painter{this};
+    d->drawMinimap(painter, rect());
+}
+
+
+void logTextMinimap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        d->minimapJump(event->pos().y());
+}
+
+
+void logTextMinimap::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        d->minimapJump(event->pos().y());
+}
+
+
 auto wLogText::gutter() const noexcept -> int
 {
     return d->gutterWidth;
@@ -1869,6 +2737,8 @@ void wLogText::setGutter(int width)
     d->gutterWidth = width;
     d->m_gutterOffset = (width != 0) ? width + gutterBorder + textBorder :
                         d->m_gutterOffset = textBorder;
+    if (d->isWrapping())
+        d->setContentSize();
     if (updatesEnabled()) {
         viewport()->update();
     }
@@ -1925,9 +2795,8 @@ void wLogText::setEscJumpsToEnd(bool state) noexcept
 
 void wLogText::setLineStyle(lineNumber_t line, int style) noexcept
 {
-    logTextItemPtr const item = validLineNumber(line) ? items[line] : nullptr;
-    if (item && item->styleId() != style) {
-        item->setStyleId(style);
+    if (validLineNumber(line) && items.styleId(line) != style) {
+        items.setStyleId(line, static_cast<styleId_t>(style));
         // TODO Only refresh if item is in view
         setUpdatesNeeded(updateFull);
     }
@@ -1940,8 +2809,8 @@ void wLogText::visitItems(logTextItemVisitor& v, lineNumber_t firstLine)
         return;
 
     QSignalBlocker signalBlock(this);
-    for (lineNumber_t lineNumber = firstLine; auto& item : items) {
-        if (!v.visit({this, item, lineNumber++}))
+    for (lineNumber_t lineNumber = std::max(firstLine, 0); lineNumber < m_lineCount; ++lineNumber) {
+        if (!v.visit({this, item(lineNumber)}))
             break;
     }
 }
@@ -1950,8 +2819,8 @@ void wLogText::visitItems(logTextItemVisitor& v, lineNumber_t firstLine)
 void wLogText::visitItems(bool (*v)(const logTextItemVisitor::visitedItem& item))
 {
     QSignalBlocker signalBlock(this);
-    for (lineNumber_t lineNumber = 1; auto& item : items) {
-        if (!v({this, item, lineNumber++}))
+    for (lineNumber_t lineNumber = 0; lineNumber < m_lineCount; ++lineNumber) {
+        if (!v({this, item(lineNumber)}))
             break;
     }
 }
@@ -1960,12 +2829,11 @@ void wLogText::visitItems(bool (*v)(const logTextItemVisitor::visitedItem& item)
 void wLogText::visitSelection(logTextItemVisitor &v)
 {
     if (d->selecting) {
-        auto it  = items.cbegin() + d->selectTop.lineNumber();
-        auto const end = items.cbegin() + std::min(d->selectBottom.lineNumber(), m_lineCount);
+        lineNumber_t const end = std::min(d->selectBottom.lineNumber(), m_lineCount);
 
         QSignalBlocker signalBlock(this);
-        for (lineNumber_t lineNumber = d->selectTop.lineNumber(); it != end; ++it) {
-            if (!v.visit({this, *it, lineNumber++}))
+        for (lineNumber_t lineNumber = d->selectTop.lineNumber(); lineNumber < end; ++lineNumber) {
+            if (!v.visit({this, item(lineNumber)}))
                 break;
         }
     }
@@ -1975,12 +2843,11 @@ void wLogText::visitSelection(logTextItemVisitor &v)
 void wLogText::visitSelection(bool (*v)(const logTextItemVisitor::visitedItem&))
 {
     if (d->selecting) {
-        auto it  = items.cbegin() + d->selectTop.lineNumber();
-        auto const end = items.cbegin() + std::min(d->selectBottom.lineNumber(), m_lineCount);
+        lineNumber_t const end = std::min(d->selectBottom.lineNumber(), m_lineCount);
 
         QSignalBlocker signalBlocker(this);
-        for (lineNumber_t lineNumber = d->selectTop.lineNumber(); it != end; ++it) {
-            if (!v({this, *it, lineNumber++}))
+        for (lineNumber_t lineNumber = d->selectTop.lineNumber(); lineNumber < end; ++lineNumber) {
+            if (!v({this, item(lineNumber)}))
                 break;
         }
     }
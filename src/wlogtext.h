@@ -7,28 +7,61 @@
 #ifndef WLOGTEXT_H
 #define WLOGTEXT_H
 
+#include <algorithm>
 #include <climits>
+#include <concepts>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <optional>
+#include <ranges>
+#include <type_traits>
 #include <vector>
 
 #include <QAbstractScrollArea>
 #include <QColor>
 #include <QElapsedTimer>
 #include <QFlags>
+#include <QHash>
 #include <QPoint>
 #include <QPixmap>
 #include <QDate>
+#include <QStringView>
 
 using styleId_t = uint16_t;        //!< Style id within a palette
 using pixmapId_t = uint16_t;
 using lineNumber_t = int32_t;
+using markerMask_t = uint8_t;       //!< Bit mask of minimap marker channels
+
+/** Number of minimap marker channels; one per bit of markerMask_t */
+inline constexpr int markerChannels = 8;
+
+/**
+ * @brief line count at which a line limit is enforced
+ *
+ * A limited store of lines is allowed some slack over its limit, so it is
+ * trimmed in batches rather than on every append: once the slacked count is
+ * reached, it is trimmed back to the limit. See wLogText::setMaxLogLines().
+ *
+ * @param limit line limit; <= 0 for unlimited
+ * @return slacked line count; the largest lineNumber_t if unlimited
+ */
+inline auto slackedLineLimit(lineNumber_t limit) -> lineNumber_t
+{
+    if (limit <= 0)
+        return std::numeric_limits<lineNumber_t>::max();
+    lineNumber_t const slack = std::clamp(limit / 10, 10, 1000);
+    // Check for overflow maxint:
+    return limit > std::numeric_limits<lineNumber_t>::max() - slack ?
+           std::numeric_limits<lineNumber_t>::max() : limit + slack;
+}
 
 class QClipboard;
 class QContextMenuEvent;
 class QCustomEvent;
 class QFocusEvent;
 class QFont;
+class QIODevice;
 class QKeyEvent;
 class QMouseEvent;
 class QResizeEvent;
@@ -265,25 +298,35 @@ template<int N> auto get(region const& r) -> decltype(auto) {
     if constexpr(N == 0) return r.first(); else return r.second();}
 
 /**
- * Class to define a line item for to be displayed in a logText widget.
- * It allows access to the text, attributes, and positional information of a
- * text line.
+ * @brief length of a line whose text is read from the widget's text source
+ * @see wLogText::setTextSource()
+ */
+struct sourcedText {
+    int length = 0;                     //!< length of the text in characters
+};
+
+/**
+ * @brief a line to be appended to a logText widget
  *
- * This class should not be instantiated by an application.  Creation and
- * access should be done through a logText object.
+ * A value holding the text and attributes of a new line. wLogText::append()
+ * copies it into the widget's line store; it is not kept. Lines already in
+ * the widget are read through a logTextItemView, and modified through the
+ * wLogText setters, so the display reflects the change.
  *
- * Many attributes are accessible from the object, and some are settable.
- * However, in most cases an object should be modified through the logText
- * object, so that the display will reflect changes in the item.
+ * A widget with a text source is given sourced lines, which carry only the
+ * length of their text.
  */
-
 class logTextItem {
-    friend class wLogText;
+    friend class logTextStore;
 
 private:
     QString m_text;                     //!< actual line text
+    int m_sourcedLength = -1;           //!< length of a sourced line's text; -1 if the text is held
     std::optional<pixmapId_t> m_pixmapId; //!< ID within the pixmap palette for the gutter pixmap
+    quintptr m_tag = 0;                 //!< application data carried with the line
+    uint32_t m_badge = 0;               //!< count displayed in the gutter; zero for none
     styleId_t m_styleId = 0;            //!< style ID within the active palette to paint this line
+    markerMask_t m_markers = 0;         //!< minimap marker channels set on this line
 
 public:
     /**
@@ -298,20 +341,14 @@ public:
     logTextItem(QString&& text, styleId_t styleNo) noexcept :
             m_text(std::move(text)), m_styleId(styleNo) {}
 
-    logTextItem& operator =(logTextItem const&) = delete;
-    logTextItem& operator =(logTextItem&&) noexcept = default;
-
     /**
-     * Copy constructor.
-     * @param source Object to copy from.
-     */
-    logTextItem(const logTextItem&) noexcept = default;
-    logTextItem(logTextItem&&) noexcept = default;
-
-    virtual ~logTextItem() = default;
-
-    static auto newItem(const QString& text, styleId_t styleNo) {return new logTextItem{text, styleNo};}
-    static auto newItem(QString&& text, styleId_t styleNo) {return new logTextItem{std::move(text), styleNo};}
+     * Constructor of a line whose text is read from the widget's text source.
+     *
+     * @param text length of the text the source gives for the line's tag
+     * @param styleNo Style number of the base.
+     **/
+    logTextItem(sourcedText text, styleId_t styleNo) noexcept :
+            m_sourcedLength(text.length), m_styleId(styleNo) {}
 
     /**
      * Get the style for a logText line.
@@ -322,13 +359,6 @@ public:
 
     /**
      * @brief set line style
-     *
-     * Sets the text style of the logText line.
-     * @note Use this method to set the style of a newly constructed item, as
-     * changing it after it has been appended to the monitorWidget will not
-     * result in a redraw with the new style. The application should modify an
-     * existing text entry through a wLogText::setStyle(lineNo, style) method
-     * so that it can synchronize the on screen view with changes.
      * @param styleNo New style number to be applied to this text.
      */
     auto setStyleId(styleId_t styleNo) noexcept -> void {m_styleId = styleNo;}
@@ -340,6 +370,10 @@ public:
      **/
     auto text() const ->QString const& {return m_text;}
 
+    /** @return length of the line's text, held or sourced */
+    auto length() const noexcept -> int {
+        return m_sourcedLength < 0 ? static_cast<int>(m_text.length()) : m_sourcedLength;}
+
     /**
      * Set a pixmap on a logTextItem.
      *
@@ -357,26 +391,232 @@ public:
     auto clearPixmap() noexcept {m_pixmapId.reset();}
 
     /**
-     * test if item has a pixmap ID assigned
-     * @return @c true if pixmap ID is assigned; otherwise @c false
+     * Set a count badge on a logTextItem.
+     *
+     * The count is drawn right aligned in the text gutter, if enabled. As with
+     * pixmaps, it is the applications responsibility to size the gutter to fit
+     * the badge text.
+     *
+     * @param count count to display; zero removes the badge
+     **/
+    auto setBadge(uint32_t count) noexcept {m_badge = count;}
+
+    /**
+     * Set the minimap marker channels of the line.
+     * @param markers bit mask of marker channels
+     **/
+    auto setMarkers(markerMask_t markers) noexcept {m_markers = markers;}
+
+    /** @return minimap marker channels of the line */
+    auto markers() const noexcept {return m_markers;}
+
+    /**
+     * @brief set application data of the line
+     *
+     * The tag is opaque to the widget; an application uses it to relate a
+     * displayed line back to its own data, e.g. a pointer to the source of
+     * the line. Read it back with logTextItemView::tag().
+     *
+     * @param tag application data
      */
-    auto hasPixmap() const noexcept {return m_pixmapId.has_value();}
+    auto setTag(quintptr tag) noexcept {m_tag = tag;}
+};
+
+/**
+ * @brief contiguous store of the lines of a logText widget
+ *
+ * The lines are held as a structure of arrays, rather than an object per
+ * line: the text of all lines back to back in one buffer with the offset of
+ * each line, and parallel arrays of style IDs, marker channels and tags.
+ * Pixmaps and badges, which few lines have, are kept by line sequence number.
+ * Painting and searching walk the arrays without chasing a pointer per line,
+ * and clearing releases a handful of buffers rather than an allocation per
+ * line.
+ *
+ * Lines erased from the front, as a line limit trims the oldest lines, are
+ * dropped by advancing a head index. The arrays are compacted once the
+ * dropped lines outnumber the live ones, so trimming costs constant time per
+ * line, as in a ring buffer, while each line's text stays contiguous.
+ *
+ * With a text source, no text is held: the offsets advance by each line's
+ * length, and the text is asked of the source by the line's tag as it is
+ * read.
+ */
+class logTextStore {
+public:
+    /** Gives the text of a line from its tag; called from any thread reading the store */
+    using textSource = std::function<QString(quintptr tag)>;
 
     /**
-     * return the item's assigned pixmap ID
+     * @brief read the text of lines from a source, rather than holding it
+     * @param source text of each line; empty to hold the text. Set while the store is empty.
+     */
+    auto setTextSource(textSource source) -> void {m_source = std::move(source);}
+
+    /** @return number of lines */
+    auto size() const noexcept {return static_cast<lineNumber_t>(m_styles.size()) - m_head;}
+    auto empty() const noexcept {return size() == 0;}
+
+    /**
+     * @brief append a line
+     * @param item text and attributes of the line
+     */
+    auto append(logTextItem const& item) -> void;
+
+    /**
+     * @brief reserve space for lines about to be appended
+     * @param lines number of lines
+     * @param chars total length of their text; zero if unknown
+     */
+    auto reserve(lineNumber_t lines, size_t chars) -> void;
+
+    /** Number of views of sourced text that stay valid at once on a thread; see text() */
+    static constexpr size_t sourcedTextViews = 4;
+
+    /**
+     * @return text of line @p line; valid until lines are appended or
+     * erased. With a text source, the text is decoded into one of a ring of
+     * sourcedTextViews buffers per thread, so a view is valid until text()
+     * has been called sourcedTextViews more times on the same thread; copy
+     * the text to hold it longer.
+     */
+    auto text(lineNumber_t line) const -> QStringView {
+        if (m_source) [[unlikely]]
+            return sourceText(line);
+        auto const first = m_offsets[at(line)];
+        return {m_text.data() + first, static_cast<qsizetype>(m_offsets[at(line) + 1] - first)};}
+
+    /** @return length of line @p line in characters */
+    auto length(lineNumber_t line) const -> int {
+        return static_cast<int>(m_offsets[at(line) + 1] - m_offsets[at(line)]);}
+
+    auto styleId(lineNumber_t line) const -> styleId_t {return m_styles[at(line)];}
+    auto setStyleId(lineNumber_t line, styleId_t style) -> void {m_styles[at(line)] = style;}
+
+    auto pixmapId(lineNumber_t line) const -> std::optional<pixmapId_t> {
+        auto const it = m_pixmaps.constFind(key(line));
+        return it == m_pixmaps.cend() ? std::nullopt : std::optional{*it};}
+    auto setPixmap(lineNumber_t line, std::optional<pixmapId_t> pm) -> void {
+        if (pm) m_pixmaps.insert(key(line), *pm); else m_pixmaps.remove(key(line));}
+
+    auto badge(lineNumber_t line) const -> uint32_t {return m_badges.value(key(line), 0);}
+
+    auto markers(lineNumber_t line) const -> markerMask_t {return m_markers[at(line)];}
+    auto setMarkers(lineNumber_t line, markerMask_t markers) -> void;
+
+    /** @brief clear the marker channels not in @p keep from all lines */
+    auto keepMarkers(markerMask_t keep) -> void;
+
+    /** @return number of lines with any marker channel set */
+    auto markedLines() const noexcept {return m_markedLines;}
+
+    auto tag(lineNumber_t line) const -> quintptr {return m_tags[at(line)];}
+
+    /**
+     * @brief erase a range of lines
+     *
+     * Erasing from the first line takes time proportional to @p count;
+     * elsewhere, to the number of lines after the range.
      *
-     * If the item has a pixmap ID assigned, then return its value. If no ID was assigned,
-     * returns an out-of-range value, rather than throwing an exception. Generally,
-     * @c hasPixmap() would be tested first, rather than relying of OOR return value.
-     * @return ID of assigned pixmap; if no pixmap is assigned, return out-of-range value
+     * @param first first line to erase
+     * @param count number of lines to erase
      */
-    auto pixmapId() const noexcept {return m_pixmapId.value_or(std::numeric_limits<pixmapId_t>::max());}
+    auto erase(lineNumber_t first, lineNumber_t count) -> void;
+
+    auto clear() -> void;
+    auto shrinkToFit() -> void;
+
+    using lineKey_t = qint64;           //!< line sequence number; unchanged as earlier lines are trimmed
+
+    /** @return sequence number of line @p line, the key of its pixmap and badge */
+    auto key(lineNumber_t line) const -> lineKey_t {return m_base + line;}
+
+    /**
+     * @brief number of the clears and erases which renumber lines
+     *
+     * Trimming lines from the front keeps the keys of the other lines; a
+     * clear, or an erase elsewhere, starts a new generation of keys.
+     */
+    auto generation() const noexcept -> quint64 {return m_generation;}
+
+    /**
+     * @brief line of a key
+     * @param key sequence number of a line, or of the end of the lines
+     * @param generation generation() when @p key was taken
+     * @return line number, up to size(); nullopt if the line has been erased
+     */
+    auto lineOf(lineKey_t key, quint64 generation) const -> std::optional<lineNumber_t> {
+        if (generation != m_generation || key < m_base || key > m_base + size())
+            return std::nullopt;
+        return static_cast<lineNumber_t>(key - m_base);}
+
+private:
+
+    std::vector<QChar> m_text;          //!< text of all lines, back to back; empty with a text source
+    std::vector<size_t> m_offsets{0};   //!< start of each line in m_text, followed by the end of the last
+    std::vector<styleId_t> m_styles;    //!< style ID of each line
+    std::vector<markerMask_t> m_markers; //!< minimap marker channels of each line
+    std::vector<quintptr> m_tags;       //!< application data of each line
+    QHash<lineKey_t, pixmapId_t> m_pixmaps; //!< gutter pixmap of the lines which have one
+    QHash<lineKey_t, uint32_t> m_badges;    //!< gutter badge of the lines which have one
+    lineNumber_t m_head = 0;            //!< dropped lines at the front of the arrays
+    lineKey_t m_base = 0;               //!< sequence number of line 0
+    lineNumber_t m_markedLines = 0;     //!< lines with markers set
+    quint64 m_generation = 0;           //!< see generation()
+    textSource m_source;                //!< text of the lines, when not held
+
+    /** @return index of line @p line in the arrays */
+    auto at(lineNumber_t line) const -> size_t {return static_cast<size_t>(line + m_head);}
+
+    /** @brief release the dropped lines at the front of the arrays */
+    auto compact() -> void;
+
+    /** @return text of line @p line from the text source */
+    auto sourceText(lineNumber_t line) const -> QStringView;
+};
+
+/**
+ * @brief read only view of a line in a logText widget
+ *
+ * Returned by wLogText::item(). The view refers to the widget's line store,
+ * and is valid until lines are appended to or erased from the widget.
+ */
+class logTextItemView {
+public:
+    logTextItemView(logTextStore const& store, lineNumber_t line) noexcept :
+            m_store{&store}, m_line{line} {}
+
+    /** @return line number of the line in the widget */
+    auto lineNumber() const noexcept {return m_line;}
+
+    /** @return text of the line; as logTextStore::text(), only a few are valid at once with a text source */
+    auto text() const {return m_store->text(m_line);}
+
+    /** @return Style number applied to this text. */
+    auto styleId() const {return m_store->styleId(m_line);}
+
+    /** @return @c true if a pixmap ID is assigned */
+    auto hasPixmap() const {return m_store->pixmapId(m_line).has_value();}
+
+    /**
+     * return the line's assigned pixmap ID
+     * @return ID of assigned pixmap; if no pixmap is assigned, an out-of-range value
+     */
+    auto pixmapId() const {return m_store->pixmapId(m_line).value_or(std::numeric_limits<pixmapId_t>::max());}
+
+    /** @return count displayed in the gutter; zero if no badge is set */
+    auto badge() const {return m_store->badge(m_line);}
+
+    /** @return bit mask of marker channels set on the line */
+    auto markers() const {return m_store->markers(m_line);}
+
+    /** @return application data set by logTextItem::setTag() */
+    auto tag() const {return m_store->tag(m_line);}
+
+private:
+    logTextStore const* m_store;
+    lineNumber_t m_line;
 };
-using logTextItemPtr = logTextItem *;
-using logTextItemCPtr = logTextItem const *;
-using logItemsImplList = std::vector<logTextItemPtr>;        //!< list type for the body of logTextItems
-using logItemsImplIt = logItemsImplList::iterator;      //!< iterartor for the list of logTextItems
-using logItemsImplCIt = logItemsImplList::const_iterator;      //!< iterartor for the list of logTextItems
 
 
 /**********************************************************
@@ -396,6 +636,10 @@ using logItemsImplCIt = logItemsImplList::const_iterator;      //!< iterartor fo
  * A derived class can implement input and result members for communicating
  * between the application and the visit method.
  *
+ * The text of a visited item is a view. With a text source, it is reused
+ * after a few more lines are read, as logTextStore::text() describes, so a
+ * visitor keeping the text of earlier lines must copy it.
+ *
  * Example:
  * @code
  * class countStrings : public logTextItemVisitor {
@@ -405,10 +649,10 @@ using logItemsImplCIt = logItemsImplList::const_iterator;      //!< iterartor fo
  *  public:
  *      countStrings(QString& text) : matches(0), match(text) {};
  *      int count() { return matches; };
- *      visit(wLogText *logText, logTextItem *item, visitationFlags flags) {
- *          if (item->text().find(match) != -1) {
+ *      auto visit(const visitedItem& item) -> bool override {
+ *          if (item.lineItem.text().contains(match)) {
  *              ++matches;          // Increment counter for showing results
- *              logText->setItemStyle(item, styleTextFound);  // Recolor
+ *              item.logText->setLineStyle(item.lineNumber, styleTextFound);  // Recolor
  *          }
  *          return true;  // Keep going
  *      };
@@ -429,10 +673,10 @@ public:
     class visitedItem {
     public:
         wLogText *logText;
-        logTextItem *lineItem;
+        logTextItemView lineItem;
         lineNumber_t lineNumber;
-        visitedItem(wLogText *log, logTextItem *item, lineNumber_t firstLine) :
-                    logText(log), lineItem(item), lineNumber(firstLine) {}
+        visitedItem(wLogText *log, logTextItemView item) :
+                    logText(log), lineItem(item), lineNumber(item.lineNumber()) {}
     };
     virtual ~logTextItemVisitor() = default;
 
@@ -450,6 +694,29 @@ public:
 };
 
 
+/**
+ * @brief paint counters of a logText widget
+ *
+ * Counted since the widget was created or wLogText::resetPaintStats(), so a
+ * caller can measure a workload by resetting, running it, and reading the
+ * counters. The style cache is the font and colors of the last painted
+ * line's style: a hit when the next line has the same style, a miss when the
+ * painter must switch font.
+ */
+struct logTextPaintStats {
+    qint64 paints = 0;                  //!< paint events drawn
+    qint64 totalPaintNanos = 0;         //!< time spent drawing, in nanoseconds
+    qint64 lastPaintNanos = 0;          //!< time of the last paint, in nanoseconds
+    qint64 maxPaintNanos = 0;           //!< time of the slowest paint, in nanoseconds
+    qint64 rowsDrawn = 0;               //!< text rows drawn
+    qint64 lastRowsDrawn = 0;           //!< text rows drawn by the last paint
+    qint64 styleCacheHits = 0;          //!< rows drawn in the style of the row before
+    qint64 styleCacheMisses = 0;        //!< rows needing a change of style
+    qint64 refreshRequests = 0;         //!< requests to refresh after a change of lines
+    qint64 mergedRefreshes = 0;         //!< requests merged into a refresh already pending
+};
+
+
 /**
  * @brief A widget for displaying simple text lines, optimized for speed with few formatting options.
  *
@@ -529,6 +796,12 @@ class wLogText : public QAbstractScrollArea {
      **/
     Q_PROPERTY(bool escJumpsToEnd READ escJumpsToEnd WRITE setEscJumpsToEnd)
 
+    /** Wrap lines longer than the view's width onto several rows */
+    Q_PROPERTY(bool wrapLines READ wrapLines WRITE setWrapLines)
+
+    /** Show paint timing and counters over the text */
+    Q_PROPERTY(bool paintStatsOverlay READ paintStatsOverlay WRITE setPaintStatsOverlay)
+
 private:
     /** Refresh needed due to changes during an "updatesDisabled" state */
     enum updateLevel {
@@ -543,15 +816,16 @@ protected:
     /** Pointer to implementation detail */
     std::unique_ptr<wLogTextPrivate> const d;
 
-    logItemsImplList items;         //!< Vector of text plus attribute items.
+    logTextStore items;             //!< Text plus attributes of all lines.
     lineNumber_t m_lineCount = 0;   //!< Count of lines
-    int m_maxLineChars = 0;         //!< Width in characters of longest line in list of all lines.
 
     lineNumber_t maximumLogLines = 0;        //!< Maximum lines held.  Above this, and top lines are discarded.
     lineNumber_t maximumLogLinesSlacked = std::numeric_limits<lineNumber_t>::max(); //!< maximumLogLines + slack to go before trimming.
 
     updateLevel updatesNeeded = updateLevel::noUpdate;  //!< Flag to indicate to idle event to update screen.
     int updatePosted = 0;           //!< Flag indicting that an update event is already pending.
+    int refreshTimerId = 0;         //!< Timer deferring an update to the next frame; zero if none.
+    QElapsedTimer lastRefresh;      //!< Time of the last update, to update at most once a frame.
 
     QPoint mouseRawPos;         //!< Raw position of the last mouse move event
     QElapsedTimer mouseHoverOnTime;     //!< Time at last mouse move event
@@ -704,6 +978,17 @@ protected:
      */
     auto timerEvent(QTimerEvent *event) -> void override;
 
+    /**
+     * @brief Reimplementation of QAbstractScrollArea::viewportEvent [virtual]
+     *
+     * Keeps the minimap beside the viewport as the viewport geometry changes,
+     * e.g. when the scroll bars are shown or hidden.
+     *
+     * @param event event for the viewport
+     * @return result from QAbstractScrollArea::viewportEvent
+     */
+    auto viewportEvent(QEvent *event) -> bool override;
+
     /**
      * @brief Handle mouse wheel event.
      *
@@ -725,8 +1010,9 @@ protected:
     /**
      * @brief recalculate the horizontal scrollbar limits
      *
-     * Called when the character width or max line length changes, to
-     * recalculate the horizontal scroll bad limits.
+     * Called when the character width, the line lengths or the lines in view
+     * change, to recalculate the horizontal scroll bar limits from the longest
+     * line in view.
      **/
     auto adjustHorizontalScrollBar() const -> void;
 
@@ -748,6 +1034,13 @@ protected:
      **/
     auto trimLines() -> void;
 
+    /**
+     * @brief account for markers of an appended line in the minimap bins
+     * @param lineNo line number of the new line
+     * @param markers marker channels set on the line
+     */
+    auto addLineMarkers(lineNumber_t lineNo, markerMask_t markers) -> void;
+
     auto updateFontMetrics(int lineHeight, int charWidth) -> void {Q_EMIT(fontMetricsChanged(lineHeight, charWidth));}
 
 public:
@@ -850,28 +1143,64 @@ public:
     /**
      * @brief Append a single line of text.
      *
-     * Appends a text item pointer to the widget. The item pointer must
-     * be allocated via new. Ownership of the pointer transfers to the widget,
-     * which will be responsible for its deletion with delete.
+     * Copies the text and attributes of @p item into the widget's line store.
      *
-     * @param item pointer to logTextItem. Ownership of the pointer transfers
+     * @param item text and attributes of the line
      * @return line number of newly added line
      **/
-    auto append(logTextItem *item) {
-        m_maxLineChars = std::max(m_maxLineChars, item->m_text.length());
-        items.push_back(item);
+    auto append(logTextItem const& item) {
+        items.append(item);
         setUpdatesNeeded(updateCond);
 
-        if (maximumLogLines && (m_lineCount >= maximumLogLinesSlacked))
+        if (item.markers() != 0) [[unlikely]]
+            addLineMarkers(m_lineCount, item.markers());
+
+        ++m_lineCount;
+        if (maximumLogLines && (m_lineCount > maximumLogLinesSlacked))
             trimLines();
-        return m_lineCount++;
+        return m_lineCount - 1;
+    }
+
+    /**
+     * @brief Append a range of lines.
+     *
+     * Appends each logTextItem of @p lines, as append() would, but reserves
+     * the line store once, and updates the line metrics and requests a
+     * refresh once for the whole range. Prefer it to appending line by line
+     * when lines arrive in batches.
+     *
+     * @param lines range of logTextItem, or of values converting to one
+     * @return line count after appending
+     **/
+    template <std::ranges::input_range R>
+        requires std::convertible_to<std::ranges::range_reference_t<R>, logTextItem const&>
+    auto append(R&& lines) -> lineNumber_t {
+        size_t chars = 0;
+        /* Only count the text of stored items; a range computing its items
+         * would compute each twice. */
+        if constexpr (std::ranges::forward_range<R> && std::is_lvalue_reference_v<std::ranges::range_reference_t<R>>) {
+            for (logTextItem const& line : lines)
+                chars += static_cast<size_t>(line.length());
+        }
+        if constexpr (std::ranges::sized_range<R>)
+            items.reserve(static_cast<lineNumber_t>(std::ranges::size(lines)), chars);
+
+        for (logTextItem const& line : lines) {
+            items.append(line);
+            if (line.markers() != 0) [[unlikely]]
+                addLineMarkers(m_lineCount, line.markers());
+            if (++m_lineCount > maximumLogLinesSlacked) [[unlikely]]
+                trimLines();
+        }
+        setUpdatesNeeded(updateCond);
+        return m_lineCount;
     }
 
     auto append(QString const& text, styleId_t styleNo) {
-        return append(logTextItem::newItem(text, styleNo));}
+        return append(logTextItem{text, styleNo});}
 
     auto append(QString&& text, styleId_t styleNo) {
-        return append(logTextItem::newItem(std::move(text), styleNo));}
+        return append(logTextItem{std::move(text), styleNo});}
 
     /**
      * @brief Erase a range of lines
@@ -896,16 +1225,16 @@ public:
         return (lineNo >= 0) && (lineNo < m_lineCount); }
 
     /**
-     * @brief Return const pointer to line item for a line
+     * @brief Return a view of a line
      *
-     * Get a reference to a text item (text string + attributes).  Results are
-     * unpredictable if the passed line number is out of range.
+     * Get a view of a line's text and attributes. An out of range line number
+     * gives the last line; results are unpredictable if there are no lines.
      *
      * @param lineNo number of line to retrieve.
-     * @return const pointer to line item.
+     * @return view of the line, valid until lines are appended or erased.
      */
-    auto item(lineNumber_t lineNo) const -> logTextItem const* {
-        return items[validLineNumber(lineNo) ? lineNo : (m_lineCount - 1)];
+    auto item(lineNumber_t lineNo) const -> logTextItemView {
+        return {items, validLineNumber(lineNo) ? lineNo : (m_lineCount - 1)};
     }
 
     // Palette operations:
@@ -1333,15 +1662,106 @@ public:
      */
     auto clearLinePixmap(lineNumber_t lineNo) noexcept -> void;
 
+    /**
+     * @brief Set the minimap marker channels of a line.
+     *
+     * Marker channels are application defined, e.g. bookmarks or search hits.
+     * The minimap next to the vertical scroll bar shows the density of the
+     * lines with each channel set, in the channel color.
+     *
+     * @see wLogText::setMarkerColor
+     * @param lineNo Line number of line on which to set the markers.
+     * @param markers bit mask of marker channels for the line
+     */
+    auto setLineMarkers(lineNumber_t lineNo, markerMask_t markers) -> void;
+
+    /**
+     * @brief Get the minimap marker channels of a line.
+     * @param lineNo Line number of line
+     * @return bit mask of marker channels for the line; 0 for an invalid line
+     */
+    auto lineMarkers(lineNumber_t lineNo) const noexcept -> markerMask_t;
+
+    /**
+     * @brief Set one marker channel on a list of lines.
+     *
+     * The channel is cleared on all other lines, and the minimap bins of the
+     * channel are rebuilt.
+     *
+     * @param channel marker channel, 0 to markerChannels-1
+     * @param lines sorted line numbers which get the marker
+     */
+    auto setChannelMarkers(int channel, std::vector<lineNumber_t> const& lines) -> void;
+
+    /**
+     * @brief Set the color of a minimap marker channel.
+     *
+     * Channels without a valid color are not displayed.
+     *
+     * @param channel marker channel, 0 to markerChannels-1
+     * @param color color for the channel
+     */
+    auto setMarkerColor(int channel, QColor const& color) -> void;
+
+    /**
+     * @brief Show or hide the minimap.
+     *
+     * The minimap is a strip between the text and the vertical scroll bar,
+     * showing the density of marked lines over the whole text. Clicking or
+     * dragging in the strip scrolls to that position.
+     *
+     * @param visible @c true to show the minimap
+     */
+    auto setMinimapVisible(bool visible) -> void;
+
+    /**
+     * @brief Is the minimap shown?
+     * @return @c true if the minimap is visible
+     */
+    auto minimapVisible() const -> bool;
+
+    /**
+     * @brief Wrap long lines, or scroll them horizontally.
+     *
+     * Wrapped lines continue on the following rows, wrapping at the width of
+     * the view, and the horizontal scroll bar is unused. Rows are counted by a
+     * prefix sum index built as lines are shown, so mapping between rows and
+     * lines stays logarithmic in the line count. The first visible line stays
+     * in view.
+     *
+     * @param wrap @c true to wrap lines
+     */
+    auto setWrapLines(bool wrap) -> void;
+
+    /**
+     * @brief Are long lines wrapped?
+     * @return @c true if lines are wrapped
+     */
+    auto wrapLines() const -> bool;
+
+    /**
+     * @brief Get the paint counters.
+     * @return counters since creation or the last resetPaintStats()
+     */
+    auto paintStats() const -> logTextPaintStats;
+
+    /** @brief Zero the paint counters. */
+    auto resetPaintStats() -> void;
+
+    /**
+     * @brief Is the paint statistics overlay shown?
+     * @return @c true if the overlay is shown
+     */
+    auto paintStatsOverlay() const -> bool;
+
     /**
      * @brief Set the style on an item.
      *
-     * Alters the style value on a logTextItem.  This method is used in place of
-     * directly altering the item, to ensure an update of items currently on screen
-     * are redrawn.  If updates are enabled, the screen refresh (if any) is deferred
-     * until updates are re-enabled.
+     * Alters the style value of a line, and ensures an update if the line is
+     * currently on screen.  If updates are enabled, the screen refresh (if any)
+     * is deferred until updates are re-enabled.
      *
-     * @param item pointer to the item to be updated.
+     * @param line number of the line to be updated.
      * @param style New style value for the item.
      */
     auto setLineStyle( lineNumber_t line, int style) noexcept -> void;
@@ -1419,6 +1839,17 @@ protected Q_SLOTS:
     auto hScrollChange(int value) -> void;
 
 public Q_SLOTS:
+    /**
+     * @brief Show or hide the paint statistics overlay.
+     *
+     * The overlay, in the top right corner of the text, shows the time and
+     * rows of the last paint, the slowest paint, the style cache hits and
+     * misses, and the paints and merged refresh requests per second.
+     *
+     * @param show @c true to show the overlay
+     */
+    auto setPaintStatsOverlay(bool show) -> void;
+
     /**
      * @brief Sets the maximum number of lines.
      *
@@ -1440,6 +1871,19 @@ public Q_SLOTS:
      */
     auto clear() -> void;
 
+    /**
+     * @brief read the text of lines from the application, rather than holding a copy
+     *
+     * Clears the widget. Lines appended after are sourced logTextItem values,
+     * carrying the length of their text; painting, find and copy ask
+     * @p source for the text of a line by its tag, as they read it. The
+     * source is called from worker threads too, and must give text of the
+     * appended length for as long as the line is in the widget.
+     *
+     * @param source text of a line from its tag; empty to hold the text again
+     */
+    auto setTextSource(logTextStore::textSource source) -> void;
+
     /**
      * @brief advisory that no new items are expected
      *
@@ -1516,10 +1960,32 @@ public Q_SLOTS:
      * @brief Copy selection to the clipboard.
      *
      * Request to copy the current selection, if there is one, to the clipboard.  If
-     * there is no current selection, no action is taken.
+     * there is no current selection, no action is taken. A large selection is
+     * copied as its region, and its text built only when it is pasted.
      */
     auto copy() const -> void;
 
+    /**
+     * @brief Write the selected text to a device.
+     *
+     * Writes the selection as UTF-8, a block at a time, so a selection of
+     * any size is saved without building its text as a whole.
+     *
+     * @param device open device to write to
+     * @return @c true if the selection was written; @c false on a write error
+     */
+    auto writeSelectedText(QIODevice& device) const -> bool;
+
+    /**
+     * @brief Write all lines to a device.
+     *
+     * As writeSelectedText(), for all lines, each ended with a new-line.
+     *
+     * @param device open device to write to
+     * @return @c true if the lines were written; @c false on a write error
+     */
+    auto writeText(QIODevice& device) const -> bool;
+
     /**
      * @brief Set the gutter width.
      *
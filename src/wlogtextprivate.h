@@ -12,8 +12,15 @@
 #include <QHash>
 #include <QMap>
 #include <QClipboard>
+#include <QMimeData>
 #include <QPixmap>
+#include <QPointer>
 #include <QReadLocker>
+#include <QWidget>
+
+#include <array>
+#include <utility>
+#include <vector>
 
 /** State of text drag */
 enum class dragStates {
@@ -102,6 +109,171 @@ public:
 };
 
 
+/**
+ * @brief Density bins for the minimap.
+ *
+ * Counts of marked lines per channel, in a fixed number of bins, each covering
+ * linesPerBin() lines. When a marked line falls beyond the last bin, the bin
+ * size doubles, merging adjacent pairs of bins. Counts are updated as markers
+ * change, so painting the minimap never scans the lines.
+ */
+class minimapBins {
+public:
+    static constexpr size_t binCount = 1024;    //!< Number of bins
+    using counts = std::array<uint32_t, markerChannels>;    //!< Per channel counts of a bin
+
+private:
+    lineNumber_t m_linesPerBin = 1;
+    std::vector<counts> bins = std::vector<counts>(binCount);
+
+public:
+    /**
+     * @brief reset to empty, with one line per bin
+     */
+    auto reset() -> void;
+
+    /**
+     * @brief add or remove the markers of a line
+     * @param lineNo line number
+     * @param markers marker channels of the line
+     * @param add @c true to add the line to the counts, @c false to remove it
+     */
+    auto update(lineNumber_t lineNo, markerMask_t markers, bool add) -> void;
+
+    /**
+     * @brief clear the counts of one channel
+     * @param channel marker channel
+     */
+    auto clearChannel(int channel) -> void;
+
+    /** @return number of lines covered by each bin */
+    auto linesPerBin() const noexcept {return m_linesPerBin;}
+
+    /** @return counts of bin @p n */
+    auto bin(size_t n) const -> counts const& {return bins[n];}
+};
+
+
+/**
+ * @brief index of the display rows of wrapped lines
+ *
+ * Prefix sums of the rows each line takes when wrapped at a column width,
+ * so the first row of a line is found in constant time, and the line at a
+ * row by binary search. Lines are indexed as they are needed, the bulk of
+ * them in parallel. A change of width re-wraps from the first line whose row
+ * count changes; lines shorter than both widths keep their rows. Lines
+ * trimmed from the front are dropped by advancing a head index, as in
+ * logTextStore.
+ */
+class wrapIndex {
+public:
+    using row_t = qint64;
+
+    /** @return rows taken by a line of @p length characters wrapped at @p columns */
+    static auto rowsOf(int length, int columns) -> row_t {
+        return length <= columns ? 1 : (length + columns - 1) / columns;}
+
+    /**
+     * @brief bring the index up to date with the lines of @p store
+     * @param store lines of the widget
+     * @param columns wrap width in characters
+     */
+    auto update(logTextStore const& store, int columns) -> void;
+
+    /**
+     * @brief drop lines trimmed from the front of the store
+     * @param count number of lines trimmed
+     */
+    auto eraseFront(lineNumber_t count) -> void;
+
+    /** @brief drop all lines, to be indexed again when next needed */
+    auto clear() -> void;
+
+    /** @return number of lines indexed */
+    auto lines() const -> lineNumber_t {return static_cast<lineNumber_t>(m_prefix.size() - m_head) - 1;}
+
+    /** @return total rows of the indexed lines */
+    auto rows() const -> row_t {return m_prefix.back() - m_prefix[m_head];}
+
+    /** @return first row of line @p line; rows() for the line after the last */
+    auto rowOf(lineNumber_t line) const -> row_t {
+        return m_prefix[m_head + static_cast<size_t>(line)] - m_prefix[m_head];}
+
+    /**
+     * @brief find the line displayed on a row
+     * @param row row number
+     * @return line number, and row within the line; lines() if @p row is past the last line
+     */
+    auto lineAt(row_t row) const -> std::pair<lineNumber_t, int>;
+
+private:
+    std::vector<row_t> m_prefix{0};     //!< rows before each indexed line, and the total after the last
+    size_t m_head = 0;                  //!< dropped lines at the front of m_prefix
+    int m_columns = 0;                  //!< wrap width the lines are indexed at
+
+    /** @brief index lines [@p first, @p last) of @p store, after the indexed lines before @p first */
+    auto indexLines(logTextStore const& store, lineNumber_t first, lineNumber_t last) -> void;
+};
+
+
+/**
+ * @brief Minimap strip widget.
+ *
+ * Placed between the viewport and the vertical scroll bar of a wLogText; all
+ * drawing and mouse handling is delegated to wLogTextPrivate.
+ */
+class logTextMinimap : public QWidget {
+private:
+    wLogTextPrivate *const d;
+
+public:
+    logTextMinimap(wLogTextPrivate *dp, QWidget *parent) : QWidget{parent}, d{dp} {}
+
+protected:
+    auto paintEvent(QPaintEvent *event) -> void override;
+    auto mousePressEvent(QMouseEvent *event) -> void override;
+    auto mouseMoveEvent(QMouseEvent *event) -> void override;
+};
+
+
+/**
+ * @brief a region of a logText widget by line keys, found again after the front lines are trimmed
+ */
+struct keyedRegion {
+    quint64 generation = 0;             //!< logTextStore::generation() of the keys
+    logTextStore::lineKey_t firstKey = 0;   //!< key of the first line
+    int firstColumn = 0;                //!< first column in the first line
+    logTextStore::lineKey_t lastKey = 0;    //!< key of the last line, or of the end of the lines
+    int lastColumn = 0;                 //!< column after the region in the last line
+};
+
+/**
+ * @brief Clipboard data of a large selection, built when pasted.
+ *
+ * Holds the selected region rather than its text, so copying a selection of
+ * millions of lines costs nothing until the text is asked for. The region is
+ * held by line keys, so it survives appends and trimming of other lines; once
+ * its lines are gone, or the widget is destroyed, it pastes as empty text,
+ * rather than the widget building the text of every copy as its lines change.
+ */
+class selectionMimeData : public QMimeData {
+public:
+    selectionMimeData(wLogTextPrivate const *dp, keyedRegion const& selection) : d{dp}, m_selection{selection} {}
+
+    auto formats() const -> QStringList override;
+
+    /** @brief Drop the reference to the widget, as it is destroyed. */
+    auto release() -> void {d = nullptr;}
+
+protected:
+    auto retrieveData(QString const& mimeType, QVariant::Type type) const -> QVariant override;
+
+private:
+    wLogTextPrivate const *d;           //!< Source of the text; null once released
+    keyedRegion m_selection;            //!< Selected region of the widget
+};
+
+
 /**
  * @brief Private implementation details of wLogText widget
  *
@@ -121,8 +293,12 @@ protected:
     std::unique_ptr<QPixmap> drawPixMap;  //!< Rendering pixmap for the draw event
     QSize pmSize{0,0};              //!< Allocation size of the drawPixMap
 
-    bool timeDraw = false;          //!< Diagnostic to enable draw timing
-    QTime drawTimer;                //!< Diagnostic timer used for timing draw events
+    logTextPaintStats paintStats;   //!< Paint counters
+    bool showPaintStats = false;    //!< Draw the paint statistics overlay?
+    logTextPaintStats statsMark;    //!< Counters at the start of the current rate interval
+    QElapsedTimer statsClock;       //!< Time since statsMark
+    qint64 paintsPerSecond = 0;     //!< Paints in the last rate interval, per second
+    qint64 mergedPerSecond = 0;     //!< Merged refresh requests in the last rate interval, per second
 
     QPalette m_qpalette;            //!< System style palette for the widget
     QMap<int, QPixmap> itemPixMaps; //!< Map from pixmapId to QPixmap for the gutter pixmaps.
@@ -152,6 +328,13 @@ protected:
     cell selectBottom;              //!< Bottom of the selection region, regardless of selection direction.
     int selectScrollTimerId = 0;    //!< Timer when mouse-down and shift selecting out of range
     int timedVScrollStep = 0;       //!< Last scroll step: <0 for up, >0 for down, == 0 none
+    int hWheelDelta = 0;            //!< Horizontal wheel movement not yet scrolled, in 1/120ths of a character step
+
+    bool wrapping = false;          //!< Are long lines wrapped onto several rows?
+    mutable wrapIndex wrapRows;     //!< Rows of the wrapped lines; brought up to date by wrapped()
+
+    /** Lazy copies on the clipboard or in a drag, still referring to the lines */
+    mutable std::vector<QPointer<selectionMimeData>> lazyCopies;
 
     dragStates dragState = dragStates::dragNone; //!< Current state of dragging
     cell dragStart;                 //!< Mouse position of drag start
@@ -170,6 +353,10 @@ protected:
     paletteMap palettes;            //!< Map by name of available palettes.
     QString activatedPaletteName;   //!< name of active palette.
 
+    logTextMinimap *minimap = nullptr;  //!< Minimap strip, or nullptr before construction completes.
+    minimapBins markerBins;         //!< Marker density bins displayed in the minimap.
+    std::array<QColor, markerChannels> markerColors; //!< Minimap color per marker channel.
+
     /**
      * Constructor for private data of a wLogText
      * @param base public interface widget
@@ -195,6 +382,13 @@ protected:
      * @return linenumber of the top most line visible in the client area
      **/
     auto firstVisibleLine() const -> lineNumber_t;
+
+    /**
+     * @brief return the length of the longest line in view
+     *
+     * @return length in characters of the longest of the visible lines
+     **/
+    auto longestVisibleLine() const -> int;
     
     /**
      * @brief return number of lines visible on the painted region
@@ -347,6 +541,57 @@ protected:
      **/
     auto copySelToClipboard(QClipboard::Mode cbMode) const -> void;
 
+    /**
+     * @brief Call @p sink with each piece of the text of a region.
+     *
+     * Pieces are the parts of lines in the region, and the new-lines ending
+     * all but the last, in order.
+     *
+     * @param r region, in either order; lines past the last are ignored
+     * @param sink function called as sink(QStringView)
+     **/
+    template <typename Sink>
+    auto forRegionText(region const& r, Sink&& sink) const -> void;
+
+    /** @return length of the text of region @p r, with new-lines */
+    auto regionLength(region const& r) const -> qint64;
+
+    /**
+     * @brief Text of a region, built in a single allocation.
+     * @param r region, in either order
+     * @return text of @p r, lines separated by new-lines; empty if too long for a QString
+     **/
+    auto regionText(region const& r) const -> QString;
+
+    /**
+     * @brief Write the text of a region as UTF-8, a block at a time.
+     * @param device open device to write to
+     * @param r region, in either order
+     * @return @c true if all was written
+     **/
+    auto writeRegion(QIODevice& device, region const& r) const -> bool;
+
+    /**
+     * @brief Mime data for copying or dragging a region.
+     *
+     * Regions of up to lazyCopyChars characters are copied as text; larger
+     * ones as a selectionMimeData, building the text when it is pasted.
+     *
+     * @param r region to copy
+     * @return new mime data, owned by the caller
+     **/
+    auto regionMimeData(region const& r) const -> QMimeData *;
+
+    /**
+     * @brief Text of a region held by a lazy copy.
+     * @param k region by line keys
+     * @return text of the region; nullopt if its lines are gone
+     **/
+    auto keyedRegionText(keyedRegion const& k) const -> std::optional<QString>;
+
+    /** @brief Release outstanding lazy copies, as the widget is destroyed. */
+    auto releaseCopies() -> void;
+
     /**
      * @brief Make internal adjustment to calculated metrics.
      *
@@ -383,6 +628,15 @@ protected:
      **/
     auto drawCaret(QPainter& painter, int x, int top, int bot) const -> void;
 
+    /**
+     * @brief Draw the paint statistics overlay.
+     * @param painter painter of the text pixmap, drawn in the top right corner
+     **/
+    auto drawPaintStats(QPainter& painter) const -> void;
+
+    /** @brief Count a paint taking @p nanos nanoseconds to draw @p rows rows, and update the rates. */
+    auto countPaint(qint64 nanos, qint64 rows) -> void;
+
     /**
      * @brief Check if location is in the gutter area.
      *
@@ -433,6 +687,67 @@ protected:
      * @return Calculated line number based on scroll view coordinate.
      **/
     auto yToLine(int y) const -> lineNumber_t;
+
+    /**
+     * @brief Convert view pixel position to a character cell.
+     *
+     * Combines yToLine() and xToCharColumn(), also when lines are wrapped,
+     * where the column depends on the row of the line at @p point.
+     *
+     * @param point viewport coordinates to translate.
+     * @return cell at @p point; the line is at most the line count.
+     **/
+    auto pointToCell(QPoint const& point) const -> cell;
+
+    // Line wrapping methods
+    /** @return @c true if lines are wrapped; wrapping waits for the character width to be known */
+    auto isWrapping() const -> bool {return wrapping && m_characterWidth != 0;}
+
+    /** @return width in characters at which lines are wrapped */
+    auto wrapColumns() const -> int;
+
+    /** @return the wrap index, brought up to date with the lines and wrap width */
+    auto wrapped() const -> wrapIndex const&;
+
+    /** @return number of display rows: the line count, unless wrapping */
+    auto totalRows() const -> qint64;
+
+    /** @return first display row of line @p line */
+    auto lineToRow(lineNumber_t line) const -> qint64;
+
+    /** @return display row of cell @p c */
+    auto cellToRow(cell const& c) const -> qint64;
+
+    // Minimap methods
+    /**
+     * @brief rebuild the minimap bins from the line markers
+     *
+     * Used after lines are removed, which shifts the line numbers of all
+     * following lines.
+     */
+    auto rebuildMarkerBins() -> void;
+
+    /**
+     * @brief position the minimap in the viewport margin
+     */
+    auto layoutMinimap() -> void;
+
+    /**
+     * @brief paint the minimap
+     *
+     * Per pixel row densities are summed from the bins, so the cost depends on
+     * the number of bins and the strip height, not the number of lines.
+     *
+     * @param painter painter on the minimap widget
+     * @param bounds minimap widget rectangle
+     */
+    auto drawMinimap(QPainter& painter, QRect const& bounds) const -> void;
+
+    /**
+     * @brief scroll so the line at minimap position @p y is centered
+     * @param y y coordinate in the minimap
+     */
+    auto minimapJump(int y) -> void;
 };
 
 #endif //ifndef LOGTEXTPRIVATE_H